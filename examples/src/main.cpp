@@ -10,6 +10,7 @@
 **/
 
 #include <Arduino.h>
+#include <atomic>
 #include "wifimanager.h"
 #include "otawebupdater.h"
 
@@ -22,6 +23,9 @@ OTAWEBUPDATER OtaWebUpdater
 // We do need the Webserver to attach our RESTful API
 AsyncWebServer webServer(80);
 
+// Set while an update runs, written by the task doing the update
+std::atomic<bool> appPaused{false};
+
 void setup() {
   Serial.begin(115200);
 
@@ -32,6 +36,15 @@ void setup() {
  
   OtaWebUpdater.setBaseUrl(OTA_BASE_URL);        // Set the OTA Base URL for automatic updates
   OtaWebUpdater.setFirmware(__DATE__, '1.0.0');  // Set the current firmware version
+  OtaWebUpdater.onLifecycle([](const OtaLifecycleInfo &info) {
+    // Background workload can cause upgrade issues, pause it from the first event (uploads start
+    // with DOWNLOADING) until the update is aborted, a successful one ends with a restart
+    bool paused = info.event != OTA_LIFECYCLE_ABORTED;
+    if (paused && !appPaused) Serial.println("Update started, pausing the application");
+    if (!paused) Serial.printf("Update aborted: %s, resuming the application\n", info.reason);
+    appPaused = paused;
+  });
+  OtaWebUpdater.setHealthCheck(120, []() { return true; }); // Revert a new image that is not healthy within 2 minutes
   OtaWebUpdater.startBackgroundTask();           // Run the background task to check for updates
   OtaWebUpdater.attachWebServer(&webServer);     // Attach our API to the Webserver
   OtaWebUpdater.attachUI();                      // Attach the UI to the Webserver
@@ -48,9 +61,8 @@ void setup() {
 }
 
 void loop() {
-  // Do not continue regular operation as long as a OTA is running
-  // Reason: Background workload can cause upgrade issues that we want to avoid!
-  if (otaWebUpdater->otaIsRunning) { yield(); delay(50); return; };
+  // Regular operation is paused and resumed by the onLifecycle() callback in setup()
+  if (appPaused) { delay(50); return; }
 
   // your special code to do some good stuff
   delay(500);
@@ -0,0 +1,61 @@
+/**
+ * OTA throughput self-test
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#include "otaBenchmark.h"
+
+#include <algorithm>
+#include <esp_random.h>
+
+/**
+ * @brief Record the duration of one operation
+ * @param micros Duration in microseconds
+ *
+ * Once the reservoir is full, each new sample replaces a random stored one with
+ * a probability of stored/seen, so the percentiles cover the whole run.
+ */
+void OtaLatencySamples::observe(uint32_t micros) {
+    seen++;
+    total += micros;
+    if (micros > max)
+        max = micros;
+    if (stored < OTABENCHMARK_SAMPLES) {
+        samples[stored++] = micros;
+        return;
+    }
+    uint32_t idx = esp_random() % seen;
+    if (idx < OTABENCHMARK_SAMPLES)
+        samples[idx] = micros;
+}
+
+/**
+ * @brief Percentiles of the observed latencies
+ */
+OtaBenchmarkPhase OtaLatencySamples::summary() {
+    OtaBenchmarkPhase phase;
+    phase.count = seen;
+    phase.max = max;
+    phase.totalMicros = total;
+    if (!stored)
+        return phase;
+    std::sort(samples, samples + stored);
+    phase.p50 = samples[(stored - 1) * 50 / 100];
+    phase.p90 = samples[(stored - 1) * 90 / 100];
+    phase.p99 = samples[(stored - 1) * 99 / 100];
+    return phase;
+}
+
+const char *OtaBenchmarkResult::modeName(OtaBenchmarkMode mode) {
+    switch (mode) {
+    case OTA_BENCHMARK_WRITE:
+        return "write";
+    case OTA_BENCHMARK_FLASH:
+        return "flash";
+    default:
+        return "discard";
+    }
+}
@@ -0,0 +1,77 @@
+/**
+ * @file otaBenchmark.h
+ * @author Martin Verges <martin@verges.cc>
+ * @version 0.3
+ * @date 2025-01-06
+ *
+ * @copyright Copyright (c) 2022-2024 by the author alone
+ *
+ * License: CC BY-NC-SA 4.0
+ */
+
+#ifndef OTABENCHMARK_h
+#define OTABENCHMARK_h
+
+#include <Arduino.h>
+
+// Latencies kept per phase, later ones replace random earlier ones
+#define OTABENCHMARK_SAMPLES 512
+
+// What the throughput self-test measures
+enum OtaBenchmarkMode {
+    OTA_BENCHMARK_DISCARD = 0, // download the blob, drop the data
+    OTA_BENCHMARK_WRITE = 1,   // download the blob into the inactive app partition, never activated
+    OTA_BENCHMARK_FLASH = 2,   // erase and write the inactive app partition, no network
+};
+
+// Latency distribution of one phase in microseconds
+struct OtaBenchmarkPhase {
+    uint32_t count = 0;
+    uint32_t p50 = 0;
+    uint32_t p90 = 0;
+    uint32_t p99 = 0;
+    uint32_t max = 0;
+    uint64_t totalMicros = 0;
+};
+
+/**
+ * Reservoir of latency samples, allocated for the duration of a benchmark.
+ */
+class OtaLatencySamples {
+  public:
+    // Record the duration of one operation
+    void observe(uint32_t micros);
+
+    // Percentiles of everything observed, sorts the samples
+    OtaBenchmarkPhase summary();
+
+  private:
+    uint32_t samples[OTABENCHMARK_SAMPLES];
+    uint32_t stored = 0;
+    uint32_t seen = 0;
+    uint32_t max = 0;
+    uint64_t total = 0;
+};
+
+// Result of the last self-test, reported by /api/ota/benchmark
+struct OtaBenchmarkResult {
+    OtaBenchmarkMode mode = OTA_BENCHMARK_DISCARD;
+    bool running = false;
+    bool success = false;
+    String error = "";
+    size_t bytes = 0;
+    uint32_t micros = 0;
+    uint32_t firstByteMicros = 0; // connect, TLS, request and the first chunk
+
+    OtaBenchmarkPhase read;  // network wait per chunk, without the wait for a free slot
+    OtaBenchmarkPhase write; // sink calls: discard, or partition writes including erases
+    OtaBenchmarkPhase erase; // sector erases of the flash mode
+
+    // Payload throughput in MB/s
+    float mbps() { return micros ? (float)bytes / micros : 0; }
+
+    // Name of a mode for the API
+    static const char *modeName(OtaBenchmarkMode mode);
+};
+
+#endif // OTABENCHMARK_h
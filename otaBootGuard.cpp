@@ -0,0 +1,145 @@
+/**
+ * OTA boot health guard
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#include "otaBootGuard.h"
+#include "otaImageVerifier.h"
+
+#include <esp_image_format.h>
+#include <esp_partition.h>
+
+/**
+ * @brief Find out if the running image is on trial
+ * @param nvs Namespace of the NVS keys, shared with the OtaWebUpdater
+ *
+ * Counts the boot of an image on trial, call it before anything that could
+ * crash the new image, e.g. from the OtaWebUpdater constructor.
+ */
+void OtaBootGuard::begin(const char *nvs) {
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    esp_ota_img_states_t imageState;
+    pendingVerify = esp_ota_get_state_partition(running, &imageState) == ESP_OK && imageState == ESP_OTA_IMG_PENDING_VERIFY;
+    if (pendingVerify) {
+        bootState = OTA_BOOT_TRIAL;
+        bootCount = 1;
+    }
+
+#if OTAWEBUPDATER_USE_NVS == true
+    NVS = nvs;
+    if (!preferences.begin(NVS, false))
+        return;
+    previous = preferences.getString("bgPrev", "");
+    rejected = preferences.getString("bgRejected", "");
+    if (previous.isEmpty()) {
+        // nothing armed
+    } else if (previous != running->label) {
+        bootState = OTA_BOOT_TRIAL;
+        bootCount = preferences.getUChar("bgBoots", 0) + 1;
+        preferences.putUChar("bgBoots", bootCount);
+    } else {
+        // back on the previous partition, the new image never got confirmed
+        bootState = OTA_BOOT_REVERTED;
+        rejected = preferences.getString("bgImage", "");
+        preferences.putString("bgRejected", rejected);
+        preferences.end();
+        clear();
+        return;
+    }
+    preferences.end();
+#endif
+}
+
+/**
+ * @brief Put the new boot partition on trial for its first boots
+ *
+ * The image is identified by its SHA-256, which equals the SHA-256 of the
+ * firmware.bin it was written from, however it was installed. Does nothing if
+ * the boot partition was not changed, e.g. by an update of the filesystem only.
+ */
+void OtaBootGuard::arm() {
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    const esp_partition_t *boot = esp_ota_get_boot_partition();
+    if (!boot || boot == running)
+        return;
+
+#if OTAWEBUPDATER_USE_NVS == true
+    String image = imageSha256(boot);
+    if (preferences.begin(NVS, false)) {
+        preferences.putString("bgPrev", running->label);
+        preferences.putString("bgImage", image);
+        preferences.putUChar("bgBoots", 0);
+        preferences.end();
+    }
+#endif
+}
+
+/**
+ * @brief Keep the running image
+ */
+void OtaBootGuard::confirm() {
+    if (pendingVerify && esp_ota_mark_app_valid_cancel_rollback() == ESP_OK)
+        pendingVerify = false;
+    clear();
+    bootState = OTA_BOOT_CONFIRMED;
+}
+
+/**
+ * @brief Restart into the partition that ran before the update
+ *
+ * Uses the rollback of the bootloader if the image is pending verify, the
+ * partition stored by arm() otherwise. On success the device restarts.
+ */
+void OtaBootGuard::revert() {
+    if (pendingVerify) {
+        esp_ota_mark_app_invalid_rollback_and_reboot();
+        // returns if there is no valid image to roll back to
+    }
+
+    const esp_partition_t *partition = NULL;
+    if (!previous.isEmpty())
+        partition = esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_ANY, previous.c_str());
+    if (!partition) {
+        error = "no previous image to return to";
+        return;
+    }
+    if (esp_ota_set_boot_partition(partition) != ESP_OK) {
+        error = "the previous image is not valid";
+        return;
+    }
+    ESP.restart();
+}
+
+/**
+ * @brief Forget the trial
+ */
+void OtaBootGuard::clear() {
+    previous = "";
+    bootCount = 0;
+#if OTAWEBUPDATER_USE_NVS == true
+    if (preferences.begin(NVS, false)) {
+        for (const char *key : {"bgPrev", "bgImage", "bgBoots"})
+            if (preferences.isKey(key))
+                preferences.remove(key);
+        preferences.end();
+    }
+#endif
+}
+
+/**
+ * @brief SHA-256 of the app image in a partition as hex, empty if it is not valid
+ */
+String OtaBootGuard::imageSha256(const esp_partition_t *partition) {
+    esp_partition_pos_t pos = {partition->address, partition->size};
+    esp_image_metadata_t data;
+    if (esp_image_verify(ESP_IMAGE_VERIFY_SILENT, &pos, &data) != ESP_OK)
+        return "";
+    OtaImageVerifier image;
+    image.begin("", "", NULL);
+    if (!image.updateFromPartition(partition, data.image_len) || !image.finish())
+        return "";
+    return image.digestHex();
+}
@@ -0,0 +1,92 @@
+/**
+ * @file otaBootGuard.h
+ * @author Martin Verges <martin@verges.cc>
+ * @version 0.3
+ * @date 2025-01-06
+ *
+ * @copyright Copyright (c) 2022-2024 by the author alone
+ *
+ * License: CC BY-NC-SA 4.0
+ */
+
+#ifndef OTABOOTGUARD_h
+#define OTABOOTGUARD_h
+
+#include <Arduino.h>
+#include <esp_ota_ops.h>
+
+#ifndef OTAWEBUPDATER_USE_NVS
+#define OTAWEBUPDATER_USE_NVS true
+#endif
+#if OTAWEBUPDATER_USE_NVS == true
+#include <Preferences.h>
+#endif
+
+// Health of the running image, see OtaBootGuard::state()
+enum OtaBootState {
+    OTA_BOOT_CONFIRMED, // the running image is known good
+    OTA_BOOT_TRIAL,     // a new image runs and has to prove its health
+    OTA_BOOT_REVERTED,  // the last new image failed, the previous one runs again
+};
+
+/**
+ * Keeps track of a newly installed image until it is confirmed healthy.
+ *
+ * Before the restart into a new image, arm() stores the label of the running
+ * partition and the SHA-256 of the new image in NVS. After the restart begin() finds the new image on trial and
+ * counts its boots. confirm() ends the trial, revert() boots the previous
+ * partition. Booting the previous partition again, by a revert or by the
+ * bootloader, is reported as OTA_BOOT_REVERTED and the failed image is
+ * remembered, so it is not installed a second time.
+ *
+ * With CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE the bootloader marks a new image
+ * as pending verify. confirm() then cancels the rollback, and a crash before
+ * that makes the bootloader return to the previous image on its own.
+ */
+class OtaBootGuard {
+  public:
+    // Check the running image, call once after boot
+    void begin(const char *nvs);
+
+    // Remember the running partition and the SHA-256 of the new image before a restart into it
+    void arm();
+
+    // The running image is healthy, cancel the rollback
+    void confirm();
+
+    // Boot the previous partition, returns only if that failed
+    void revert();
+
+    // Health of the running image
+    OtaBootState state() { return bootState; }
+
+    // Boots of the image on trial, including this one
+    uint8_t boots() { return bootCount; }
+
+    // Is the image with this hex SHA-256 the one that was reverted last
+    bool isRejected(const String &sha256Hex) { return !sha256Hex.isEmpty() && sha256Hex.equalsIgnoreCase(rejected); }
+
+    // SHA-256 of the image that was reverted last
+    const String &rejectedImage() { return rejected; }
+
+    // Description of the last error
+    const char *errorString() { return error; }
+
+  private:
+    void clear();
+    static String imageSha256(const esp_partition_t *partition);
+
+    OtaBootState bootState = OTA_BOOT_CONFIRMED;
+    bool pendingVerify = false; // the bootloader waits for esp_ota_mark_app_valid_cancel_rollback()
+    uint8_t bootCount = 0;
+    String previous = ""; // label of the partition to return to
+    String rejected = "";
+    const char *error = "";
+
+#if OTAWEBUPDATER_USE_NVS == true
+    Preferences preferences;
+    const char *NVS = NULL;
+#endif
+};
+
+#endif // OTABOOTGUARD_h
@@ -0,0 +1,85 @@
+/**
+ * OTA download buffer pool
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#include "otaBufferPool.h"
+
+#include <esp_heap_caps.h>
+
+/**
+ * @brief Allocate the buffers according to the strategy
+ * @param count Number of buffers wanted
+ * @param size Size of each buffer wanted
+ * @param strategy Where to allocate the buffers
+ * @return true if at least two buffers of minChunk bytes could be allocated
+ */
+bool OtaBufferPool::begin(size_t count, size_t size, OtaBufferStrategy strategy) {
+    release();
+    if (count < 2)
+        count = 2;
+    if (size < minChunk)
+        size = minChunk;
+
+    // PSRAM is plenty and not used by WiFi, take the full layout or nothing
+    if (strategy != OTA_BUFFER_INTERNAL && psramFound()) {
+        if (allocate(count, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)) {
+            psram = true;
+            return true;
+        }
+    }
+    if (strategy == OTA_BUFFER_PSRAM)
+        return false;
+
+    // Shrink the layout until it fits the internal heap
+    while (size >= minChunk) {
+        size_t maxAlloc = ESP.getMaxAllocHeap();
+        size_t freeHeap = ESP.getFreeHeap();
+        size_t budget = freeHeap > heapReserve ? freeHeap - heapReserve : 0;
+
+        size_t fitting = size <= maxAlloc ? budget / size : 0;
+        if (fitting >= 2) {
+            if (allocate(fitting < count ? fitting : count, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT))
+                return true;
+        }
+        size /= 2;
+    }
+    return false;
+}
+
+/**
+ * @brief Allocate count buffers with the given capabilities, all or nothing
+ */
+bool OtaBufferPool::allocate(size_t count, size_t size, uint32_t caps) {
+    buffers = (uint8_t **)calloc(count, sizeof(uint8_t *));
+    if (!buffers)
+        return false;
+
+    for (bufferCount = 0; bufferCount < count; bufferCount++) {
+        buffers[bufferCount] = (uint8_t *)heap_caps_malloc(size, caps);
+        if (!buffers[bufferCount]) {
+            release();
+            return false;
+        }
+    }
+    bufferSize = size;
+    return true;
+}
+
+/**
+ * @brief Free all buffers
+ */
+void OtaBufferPool::release() {
+    if (buffers) {
+        for (size_t i = 0; i < bufferCount; i++)
+            heap_caps_free(buffers[i]);
+        free(buffers);
+        buffers = NULL;
+    }
+    bufferCount = 0;
+    bufferSize = 0;
+    psram = false;
+}
@@ -0,0 +1,72 @@
+/**
+ * @file otaBufferPool.h
+ * @author Martin Verges <martin@verges.cc>
+ * @version 0.3
+ * @date 2025-01-06
+ *
+ * @copyright Copyright (c) 2022-2024 by the author alone
+ *
+ * License: CC BY-NC-SA 4.0
+ */
+
+#ifndef OTABUFFERPOOL_h
+#define OTABUFFERPOOL_h
+
+#include <Arduino.h>
+
+// Internal heap the buffers leave free for WiFi, LwIP and TLS
+#define OTABUFFERPOOL_HEAP_RESERVE (32 * 1024)
+
+// Where the download buffers should be allocated
+enum OtaBufferStrategy {
+    OTA_BUFFER_AUTO = 0,     // PSRAM if present, otherwise internal heap with shrinking chunks
+    OTA_BUFFER_PSRAM = 1,    // PSRAM only, fail if there is none
+    OTA_BUFFER_INTERNAL = 2, // Internal heap only, shrinking chunks on tight heaps
+};
+
+/**
+ * A set of equally sized buffers allocated once per update and freed afterwards.
+ *
+ * The requested layout is a wish: on a fragmented internal heap the chunk size is
+ * halved (down to minChunk) and the count reduced (down to 2) until the buffers
+ * fit into ESP.getMaxAllocHeap() while leaving headroom for WiFi and TLS.
+ */
+class OtaBufferPool {
+  public:
+    OtaBufferPool() {}
+    virtual ~OtaBufferPool() { release(); }
+
+    // Allocate count buffers of up to size bytes each
+    bool begin(size_t count, size_t size, OtaBufferStrategy strategy = OTA_BUFFER_AUTO);
+
+    // Free all buffers
+    void release();
+
+    // Get a buffer by index
+    uint8_t *get(size_t idx) { return idx < bufferCount ? buffers[idx] : NULL; }
+
+    // Number of allocated buffers
+    size_t count() { return bufferCount; }
+
+    // Size of each allocated buffer
+    size_t size() { return bufferSize; }
+
+    // Are the buffers located in PSRAM
+    bool inPsram() { return psram; }
+
+    // Smallest chunk size to fall back to
+    size_t minChunk = 4 * 1024;
+
+    // Internal heap to keep free for WiFi, LwIP and TLS
+    size_t heapReserve = OTABUFFERPOOL_HEAP_RESERVE;
+
+  private:
+    bool allocate(size_t count, size_t size, uint32_t caps);
+
+    uint8_t **buffers = NULL;
+    size_t bufferCount = 0;
+    size_t bufferSize = 0;
+    bool psram = false;
+};
+
+#endif // OTABUFFERPOOL_h
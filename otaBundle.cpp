@@ -0,0 +1,242 @@
+/**
+ * OTA update bundles
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#include "otaBundle.h"
+
+#include <string.h>
+
+#define OTABUNDLE_HEADER_SIZE 16
+#define OTABUNDLE_ENTRY_SIZE 64
+
+static uint32_t readLe32(const uint8_t *buf) {
+    return buf[0] | buf[1] << 8 | buf[2] << 16 | (uint32_t)buf[3] << 24;
+}
+
+/**
+ * @brief Start reading a new bundle
+ * @param check Optional signature check of the header, see HeaderCheck
+ * @return true
+ */
+bool OtaBundle::begin(HeaderCheck check) {
+    abort();
+    headerCheck = check;
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts(&sha, 0);
+    hashing = true;
+    state = HEADER;
+    error = "";
+    bufLen = 0;
+    count = current = 0;
+    position = payloadPos = artifactPos = 0;
+    appVerified = false;
+    return true;
+}
+
+/**
+ * @brief Feed the next bytes of the bundle
+ * @param data Bundle bytes
+ * @param len Number of bytes
+ * @return false if the bundle is invalid or an artifact could not be written
+ */
+bool OtaBundle::write(uint8_t *data, size_t len) {
+    while (len) {
+        switch (state) {
+        case HEADER:
+        case ENTRIES: {
+            size_t want = state == HEADER ? OTABUNDLE_HEADER_SIZE : OTABUNDLE_ENTRY_SIZE;
+            size_t take = want - bufLen < len ? want - bufLen : len;
+            memcpy(buf + bufLen, data, take);
+            bufLen += take;
+            data += take;
+            len -= take;
+            position += take;
+            if (bufLen < want)
+                break;
+            bufLen = 0;
+            mbedtls_sha256_update(&sha, buf, want);
+            if (state == HEADER ? !parseHeader() : !parseEntry(buf))
+                return false;
+            break;
+        }
+        case GAP: {
+            // padding between two artifacts
+            size_t gap = entry[current].offset - payloadPos;
+            size_t take = gap < len ? gap : len;
+            data += take;
+            len -= take;
+            position += take;
+            payloadPos += take;
+            if (payloadPos == entry[current].offset && !startArtifact())
+                return false;
+            break;
+        }
+        case PAYLOAD: {
+            size_t left = entry[current].size - artifactPos;
+            size_t take = left < len ? left : len;
+            if (!writer->write(data, take))
+                return fail(entry[current].type == OTA_BUNDLE_APP ? "unable to write the app image" : "unable to write the filesystem");
+            mbedtls_sha256_update(&sha, data, take);
+            data += take;
+            len -= take;
+            position += take;
+            payloadPos += take;
+            artifactPos += take;
+            if (artifactPos == entry[current].size && !finishArtifact())
+                return false;
+            break;
+        }
+        case DONE:
+            return fail("trailing data after the bundle");
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Check the bundle and make the new app bootable
+ * @return true if every artifact was written and verified
+ */
+bool OtaBundle::end() {
+    if (state == FAILED)
+        return false;
+    if (state != DONE)
+        return fail("bundle is incomplete");
+
+    // the point of no return, everything before could be discarded
+    if (appVerified && !appWriter.activate())
+        return fail("unable to activate the app image");
+    return true;
+}
+
+/**
+ * @brief Stop writing without activating anything
+ */
+void OtaBundle::abort() {
+    appWriter.abort();
+    fsWriter.abort();
+    writer = NULL;
+    if (hashing)
+        mbedtls_sha256_free(&sha);
+    hashing = false;
+    if (state != DONE)
+        state = FAILED;
+}
+
+/**
+ * @brief Validate the bundle header
+ */
+bool OtaBundle::parseHeader() {
+    if (memcmp(buf, OTABUNDLE_MAGIC, 8) != 0)
+        return fail("invalid bundle header");
+    uint16_t version = buf[8] | buf[9] << 8;
+    if (version != OTABUNDLE_VERSION)
+        return fail("unsupported bundle version");
+    count = buf[10] | buf[11] << 8;
+    if (!count || count > OTABUNDLE_MAX_ARTIFACTS)
+        return fail("invalid number of artifacts");
+    state = ENTRIES;
+    return true;
+}
+
+/**
+ * @brief Validate an entry of the artifact table and store it
+ */
+bool OtaBundle::parseEntry(const uint8_t *raw) {
+    Entry &e = entry[current];
+    e.type = raw[0];
+    e.offset = readLe32(raw + 4);
+    e.size = readLe32(raw + 8);
+    memcpy(e.sha256, raw + 12, 32);
+    memcpy(e.name, raw + 44, 20);
+    e.name[20] = 0;
+
+    if (e.type != OTA_BUNDLE_APP && e.type != OTA_BUNDLE_FILESYSTEM)
+        return fail("unknown artifact type");
+    if (!e.size)
+        return fail("empty artifact");
+    for (uint16_t i = 0; i < current; i++) {
+        if (entry[i].type == e.type)
+            return fail("duplicate artifact type");
+        if (e.offset < entry[i].offset + entry[i].size)
+            return fail("artifacts overlap or are out of order");
+        if (entry[i].type == OTA_BUNDLE_FILESYSTEM)
+            return fail("the filesystem must be the last artifact");
+    }
+
+    if (++current < count)
+        return true;
+
+    // the table is complete, nothing was written so far
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&sha, digest);
+    mbedtls_sha256_free(&sha);
+    hashing = false;
+    if (headerCheck && !headerCheck(digest))
+        return fail("bundle signature mismatch");
+
+    current = 0;
+    state = GAP;
+    if (entry[0].offset == 0)
+        return startArtifact();
+    return true;
+}
+
+/**
+ * @brief Open the partition of the current artifact
+ */
+bool OtaBundle::startArtifact() {
+    Entry &e = entry[current];
+    writer = e.type == OTA_BUNDLE_APP ? &appWriter : &fsWriter;
+    if (!writer->begin(e.type == OTA_BUNDLE_APP ? U_FLASH : U_SPIFFS, 0))
+        return fail(e.type == OTA_BUNDLE_APP ? "no app partition to update" : "no filesystem partition");
+    if (e.size > writer->partition()->size)
+        return fail("artifact does not fit into its partition");
+
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts(&sha, 0);
+    hashing = true;
+    artifactPos = 0;
+    state = PAYLOAD;
+    return true;
+}
+
+/**
+ * @brief Check the hash of the current artifact and move on to the next one
+ */
+bool OtaBundle::finishArtifact() {
+    Entry &e = entry[current];
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&sha, digest);
+    mbedtls_sha256_free(&sha);
+    hashing = false;
+    if (memcmp(digest, e.sha256, sizeof(digest)) != 0)
+        return fail(e.type == OTA_BUNDLE_APP ? "app image hash mismatch" : "filesystem hash mismatch");
+
+    if (!writer->end(false))
+        return fail(e.type == OTA_BUNDLE_APP ? "app image verification failed" : "filesystem write failed");
+    if (e.type == OTA_BUNDLE_APP)
+        appVerified = true;
+    writer = NULL;
+
+    if (++current == count) {
+        state = DONE;
+        return true;
+    }
+    state = GAP;
+    if (payloadPos == entry[current].offset)
+        return startArtifact();
+    return true;
+}
+
+bool OtaBundle::fail(const char *msg) {
+    error = msg;
+    state = FAILED;
+    return false;
+}
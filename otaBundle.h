@@ -0,0 +1,127 @@
+/**
+ * @file otaBundle.h
+ * @author Martin Verges <martin@verges.cc>
+ * @version 0.3
+ * @date 2025-01-06
+ *
+ * @copyright Copyright (c) 2022-2024 by the author alone
+ *
+ * License: CC BY-NC-SA 4.0
+ */
+
+#ifndef OTABUNDLE_h
+#define OTABUNDLE_h
+
+#include "otaPartitionWriter.h"
+
+#include <Arduino.h>
+#include <functional>
+#include <mbedtls/sha256.h>
+
+#define OTABUNDLE_MAGIC "OTABNDL1"
+#define OTABUNDLE_VERSION 1
+#define OTABUNDLE_MAX_ARTIFACTS 4
+
+// Kind of an artifact inside of a bundle
+enum OtaBundleType {
+    OTA_BUNDLE_APP = 0,        // firmware.bin, written to the next OTA partition
+    OTA_BUNDLE_FILESYSTEM = 1, // littlefs.bin / spiffs.bin, written to the data partition
+};
+
+/**
+ * Streaming demultiplexer of a multi artifact update bundle.
+ *
+ * Layout (little endian), created by tools/makeBundle.py:
+ *
+ *   header   "OTABNDL1", uint16 version, uint16 count, uint32 reserved
+ *   entries  count x { uint8 type, uint8 reserved[3], uint32 offset, uint32 size,
+ *                      uint8 sha256[32], char name[20] }
+ *   payload  the artifacts, offset is relative to the end of the entries
+ *
+ * Every artifact is hashed while it is written and checked at its end. The app
+ * image is only made bootable in end(), after all artifacts were verified. The
+ * filesystem has no second slot, so it must follow the app: it is only touched
+ * once the new app image is complete and valid.
+ *
+ * The header and the entries, and with them the artifact hashes, can be signed.
+ * The HeaderCheck receives their SHA-256 before the first artifact is written.
+ */
+class OtaBundle {
+  public:
+    // Validate the SHA-256 of the header and entries, return false to reject the bundle
+    typedef std::function<bool(const uint8_t *digest)> HeaderCheck;
+
+    OtaBundle() {}
+    virtual ~OtaBundle() { abort(); }
+
+    // Start reading a new bundle
+    bool begin(HeaderCheck check = NULL);
+
+    // Feed the next bytes of the bundle
+    bool write(uint8_t *data, size_t len);
+
+    // Check that all artifacts were written and verified, then activate the app
+    bool end();
+
+    // Stop writing, nothing is activated
+    void abort();
+
+    // The start of the app partition was erased in the background, see OtaPartitionWriter
+    void setAppErased(size_t bytes) { appWriter.setErased(bytes); }
+
+    // Erase the partitions in steps of this many bytes, see OtaPartitionWriter
+    void setEraseAhead(size_t bytes) {
+        appWriter.setEraseAhead(bytes);
+        fsWriter.setEraseAhead(bytes);
+    }
+
+    // Number of artifacts in the bundle, 0 until the header was read
+    uint16_t artifacts() { return count; }
+
+    // Bytes of the bundle consumed so far
+    size_t consumed() { return position; }
+
+    // Description of the last error
+    const char *errorString() { return error; }
+
+  private:
+    enum State { HEADER, ENTRIES, GAP, PAYLOAD, DONE, FAILED };
+
+    struct Entry {
+        uint8_t type;
+        uint32_t offset;
+        uint32_t size;
+        uint8_t sha256[32];
+        char name[21];
+    };
+
+    bool parseHeader();
+    bool parseEntry(const uint8_t *buf);
+    bool startArtifact();
+    bool finishArtifact();
+    bool fail(const char *msg);
+
+    State state = FAILED;
+    const char *error = "";
+    HeaderCheck headerCheck = NULL;
+
+    uint8_t buf[64];
+    size_t bufLen = 0;
+
+    Entry entry[OTABUNDLE_MAX_ARTIFACTS];
+    uint16_t count = 0;
+    uint16_t current = 0;
+
+    size_t position = 0;    // bytes consumed
+    size_t payloadPos = 0;  // position relative to the payload start
+    size_t artifactPos = 0; // bytes of the current artifact written
+
+    OtaPartitionWriter appWriter;
+    OtaPartitionWriter fsWriter;
+    OtaPartitionWriter *writer = NULL;
+    bool appVerified = false;
+    bool hashing = false;
+    mbedtls_sha256_context sha;
+};
+
+#endif // OTABUNDLE_h
@@ -0,0 +1,314 @@
+/**
+ * OTA streaming decompression
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#include "otaDecompressor.h"
+
+#include <esp_heap_caps.h>
+#include <rom/crc.h>
+#include <string.h>
+
+#define OTAGZIP_FHCRC 0x02
+#define OTAGZIP_FEXTRA 0x04
+#define OTAGZIP_FNAME 0x08
+#define OTAGZIP_FCOMMENT 0x10
+
+/**
+ * @brief Start decoding a new image
+ * @param codec The encoding of the data, AUTO detects gzip by its magic bytes
+ * @param sink Receives the decoded data in order
+ * @return false if the decoder memory could not be allocated
+ */
+bool OtaDecompressor::begin(OtaCompression codec, Sink sink) {
+    release();
+    output = sink;
+    producedBytes = 0;
+    gzLen = 0;
+    gzStep = 0;
+    crc = 0;
+    error = "";
+    state = SNIFF;
+    compression = codec;
+    if (codec == OTA_COMPRESSION_AUTO)
+        return true;
+    return select(codec);
+}
+
+/**
+ * @brief Switch to the given codec and allocate its state
+ */
+bool OtaDecompressor::select(OtaCompression codec) {
+    compression = codec;
+    if (codec == OTA_COMPRESSION_NONE || codec == OTA_COMPRESSION_AUTO) {
+        compression = OTA_COMPRESSION_NONE;
+        state = PASSTHROUGH;
+        return true;
+    }
+
+    // The dictionary is only accessed sequentially, PSRAM is good enough
+    inflator = (tinfl_decompressor *)heap_caps_malloc(sizeof(tinfl_decompressor), MALLOC_CAP_8BIT);
+    dict = (uint8_t *)heap_caps_malloc(TINFL_LZ_DICT_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!dict)
+        dict = (uint8_t *)heap_caps_malloc(TINFL_LZ_DICT_SIZE, MALLOC_CAP_8BIT);
+    if (!inflator || !dict) {
+        release();
+        return fail("out of memory");
+    }
+    tinfl_init(inflator);
+    dictOffset = 0;
+    state = codec == OTA_COMPRESSION_GZIP ? GZIP_HEADER : INFLATE;
+    return true;
+}
+
+/**
+ * @brief Internal heap a gzip stream would still need
+ *
+ * In AUTO mode the inflate state is only allocated when the gzip magic shows
+ * up, after the download buffers took their share. Reserve this much for it
+ * when sizing them, on boards without PSRAM the dictionary needs 32 KB more.
+ */
+size_t OtaDecompressor::pendingHeap() {
+    if (compression != OTA_COMPRESSION_AUTO || inflator)
+        return 0;
+    return sizeof(tinfl_decompressor) + (psramFound() ? 0 : TINFL_LZ_DICT_SIZE);
+}
+
+/**
+ * @brief Feed the next encoded bytes
+ * @param data Encoded bytes
+ * @param len Number of bytes
+ * @return false on a decoding error or if the sink failed
+ */
+bool OtaDecompressor::write(uint8_t *data, size_t len) {
+    while (len) {
+        switch (state) {
+        case SNIFF: {
+            // Keep the first byte until the second one tells if it is gzip
+            if (!gzLen) {
+                gzBuf[gzLen++] = *data++;
+                len--;
+                break;
+            }
+            bool gzip = gzBuf[0] == 0x1f && data[0] == 0x8b;
+            if (!select(gzip ? OTA_COMPRESSION_GZIP : OTA_COMPRESSION_NONE))
+                return false;
+            if (!gzip) {
+                gzLen = 0;
+                if (!emit(gzBuf, 1))
+                    return false;
+            }
+            break;
+        }
+        case PASSTHROUGH:
+            return emit(data, len);
+        case GZIP_HEADER:
+            if (!parseGzipHeader(data, len))
+                return false;
+            break;
+        case INFLATE:
+            if (!inflate(data, len))
+                return false;
+            break;
+        case GZIP_TRAILER: {
+            size_t take = 8 - gzLen < len ? 8 - gzLen : len;
+            memcpy(gzBuf + gzLen, data, take);
+            gzLen += take;
+            data += take;
+            len -= take;
+            if (gzLen < 8)
+                break;
+            uint32_t expectedCrc = gzBuf[0] | gzBuf[1] << 8 | gzBuf[2] << 16 | (uint32_t)gzBuf[3] << 24;
+            uint32_t expectedSize = gzBuf[4] | gzBuf[5] << 8 | gzBuf[6] << 16 | (uint32_t)gzBuf[7] << 24;
+            if (expectedCrc != crc)
+                return fail("gzip crc mismatch");
+            if (expectedSize != (uint32_t)producedBytes)
+                return fail("gzip size mismatch");
+            state = DONE;
+            break;
+        }
+        case DONE:
+            return fail("trailing data after the compressed stream");
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Check that the encoded stream is complete
+ * @return true if everything was decoded and verified
+ */
+bool OtaDecompressor::end() {
+    bool success = false;
+    if (state == SNIFF) {
+        // a single byte image, whatever that is good for
+        success = !gzLen || emit(gzBuf, gzLen);
+    } else if (state == PASSTHROUGH || state == DONE) {
+        success = true;
+    } else if (state != FAILED) {
+        fail("compressed stream is incomplete");
+    }
+    release();
+    return success;
+}
+
+/**
+ * @brief Skip the variable length gzip header (RFC 1952 section 2.3)
+ */
+bool OtaDecompressor::parseGzipHeader(uint8_t *&data, size_t &len) {
+    while (len && state == GZIP_HEADER) {
+        switch (gzStep) {
+        case 0: // ID1 ID2 CM FLG MTIME(4) XFL OS
+            gzBuf[gzLen++] = *data++;
+            len--;
+            if (gzLen < 10)
+                break;
+            if (gzBuf[0] != 0x1f || gzBuf[1] != 0x8b || gzBuf[2] != 8)
+                return fail("invalid gzip header");
+            gzFlags = gzBuf[3];
+            gzLen = 0;
+            gzStep = 1;
+            break;
+        case 1: // XLEN
+            if (!(gzFlags & OTAGZIP_FEXTRA)) {
+                gzStep = 3;
+                break;
+            }
+            gzBuf[gzLen++] = *data++;
+            len--;
+            if (gzLen == 2) {
+                gzExtra = gzBuf[0] | gzBuf[1] << 8;
+                gzLen = 0;
+                gzStep = 2;
+            }
+            break;
+        case 2: { // extra field
+            size_t take = gzExtra < len ? gzExtra : len;
+            gzExtra -= take;
+            data += take;
+            len -= take;
+            if (!gzExtra)
+                gzStep = 3;
+            break;
+        }
+        case 3: // zero terminated file name
+        case 4: // zero terminated comment
+            if (!(gzFlags & (gzStep == 3 ? OTAGZIP_FNAME : OTAGZIP_FCOMMENT))) {
+                gzStep++;
+                break;
+            }
+            len--;
+            if (*data++ == 0)
+                gzStep++;
+            break;
+        case 5: // header crc16
+            if (gzFlags & OTAGZIP_FHCRC) {
+                len--;
+                data++;
+                if (++gzLen < 2)
+                    break;
+            }
+            gzLen = 0;
+            state = INFLATE;
+            break;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Run the inflater on the input, draining the dictionary into the sink
+ */
+bool OtaDecompressor::inflate(uint8_t *&data, size_t &len) {
+    mz_uint32 flags = TINFL_FLAG_HAS_MORE_INPUT;
+    if (compression == OTA_COMPRESSION_DEFLATE)
+        flags |= TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_COMPUTE_ADLER32;
+
+    for (;;) {
+        size_t inBytes = len;
+        size_t outBytes = TINFL_LZ_DICT_SIZE - dictOffset;
+        tinfl_status status = tinfl_decompress(inflator, data, &inBytes, dict, dict + dictOffset, &outBytes, flags);
+        data += inBytes;
+        len -= inBytes;
+
+        if (outBytes) {
+            if (!emit(dict + dictOffset, outBytes))
+                return false;
+            dictOffset = (dictOffset + outBytes) & (TINFL_LZ_DICT_SIZE - 1);
+        }
+
+        if (status == TINFL_STATUS_DONE) {
+            state = compression == OTA_COMPRESSION_GZIP ? GZIP_TRAILER : DONE;
+            gzLen = 0;
+            return true;
+        }
+        if (status == TINFL_STATUS_NEEDS_MORE_INPUT) {
+            if (!len)
+                return true;
+            continue;
+        }
+        if (status != TINFL_STATUS_HAS_MORE_OUTPUT)
+            return fail(status == TINFL_STATUS_ADLER32_MISMATCH ? "zlib adler32 mismatch" : "corrupt compressed data");
+    }
+}
+
+/**
+ * @brief Pass decoded data to the sink
+ */
+bool OtaDecompressor::emit(uint8_t *data, size_t len) {
+    if (!len)
+        return true;
+    if (compression == OTA_COMPRESSION_GZIP)
+        crc = crc32_le(crc, data, len);
+    if (!output || !output(data, len))
+        return fail("unable to write the decoded data");
+    producedBytes += len;
+    return true;
+}
+
+bool OtaDecompressor::fail(const char *msg) {
+    error = msg;
+    state = FAILED;
+    return false;
+}
+
+void OtaDecompressor::release() {
+    heap_caps_free(inflator);
+    heap_caps_free(dict);
+    inflator = NULL;
+    dict = NULL;
+}
+
+/**
+ * @brief Map a HTTP Content-Encoding value to a codec
+ * @param encoding The header value, e.g. "gzip"
+ * @return OTA_COMPRESSION_AUTO for unknown or missing encodings
+ */
+OtaCompression OtaDecompressor::fromContentEncoding(String encoding) {
+    encoding.trim();
+    encoding.toLowerCase();
+    if (encoding == "gzip" || encoding == "x-gzip")
+        return OTA_COMPRESSION_GZIP;
+    if (encoding == "deflate")
+        return OTA_COMPRESSION_DEFLATE;
+    if (encoding == "identity")
+        return OTA_COMPRESSION_NONE;
+    return OTA_COMPRESSION_AUTO;
+}
+
+/**
+ * @brief Map an upload filename to a codec
+ * @param filename The name of the uploaded file, e.g. "firmware.bin.gz"
+ * @return OTA_COMPRESSION_GZIP for *.gz, OTA_COMPRESSION_AUTO otherwise
+ */
+OtaCompression OtaDecompressor::fromFilename(String filename) {
+    filename.toLowerCase();
+    if (filename.endsWith(".gz"))
+        return OTA_COMPRESSION_GZIP;
+    return OTA_COMPRESSION_AUTO;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file otaDecompressor.h
+ * @author Martin Verges <martin@verges.cc>
+ * @version 0.3
+ * @date 2025-01-06
+ *
+ * @copyright Copyright (c) 2022-2024 by the author alone
+ *
+ * License: CC BY-NC-SA 4.0
+ */
+
+#ifndef OTADECOMPRESSOR_h
+#define OTADECOMPRESSOR_h
+
+#include <Arduino.h>
+#include <functional>
+#include <rom/miniz.h>
+
+// Encoding of a downloaded or uploaded image
+enum OtaCompression {
+    OTA_COMPRESSION_NONE = 0,    // raw image
+    OTA_COMPRESSION_AUTO = 1,    // gzip if the data starts with the gzip magic, raw otherwise
+    OTA_COMPRESSION_GZIP = 2,    // RFC 1952, e.g. "gzip -9 firmware.bin"
+    OTA_COMPRESSION_DEFLATE = 3, // RFC 1950 zlib stream (HTTP "deflate")
+};
+
+/**
+ * Streaming inflate stage between the network and the flash writer.
+ *
+ * Uses the miniz inflater in the ESP32 ROM and works in fixed memory: the
+ * decompressor state and a 32 KB dictionary, allocated once per image. Output
+ * is handed to the sink straight out of the dictionary, so no extra copy is made.
+ */
+class OtaDecompressor {
+  public:
+    typedef std::function<bool(uint8_t *data, size_t len)> Sink;
+
+    OtaDecompressor() {}
+    virtual ~OtaDecompressor() { release(); }
+
+    // Start decoding a new image
+    bool begin(OtaCompression codec, Sink output);
+
+    // Feed the next encoded bytes
+    bool write(uint8_t *data, size_t len);
+
+    // Check that the encoded stream is complete and valid
+    bool end();
+
+    // The codec in use, AUTO is resolved after the first bytes
+    OtaCompression codec() { return compression; }
+
+    // Decoded bytes passed to the sink
+    size_t produced() { return producedBytes; }
+
+    // Internal heap the decoder may still allocate, AUTO only knows after the first bytes
+    size_t pendingHeap();
+
+    // The sink the decoded data is written to
+    Sink sink() { return output; }
+
+    // Description of the last error
+    const char *errorString() { return error; }
+
+    // Map a HTTP Content-Encoding header value to a codec
+    static OtaCompression fromContentEncoding(String encoding);
+
+    // Map an upload filename (*.gz) to a codec
+    static OtaCompression fromFilename(String filename);
+
+  private:
+    enum State { SNIFF, PASSTHROUGH, GZIP_HEADER, INFLATE, GZIP_TRAILER, DONE, FAILED };
+
+    bool select(OtaCompression codec);
+    bool parseGzipHeader(uint8_t *&data, size_t &len);
+    bool inflate(uint8_t *&data, size_t &len);
+    bool emit(uint8_t *data, size_t len);
+    bool fail(const char *msg);
+    void release();
+
+    Sink output = NULL;
+    OtaCompression compression = OTA_COMPRESSION_NONE;
+    State state = FAILED;
+    const char *error = "";
+
+    tinfl_decompressor *inflator = NULL;
+    uint8_t *dict = NULL;
+    size_t dictOffset = 0;
+
+    // gzip header and trailer parsing
+    uint8_t gzBuf[10];
+    size_t gzLen = 0;
+    uint8_t gzFlags = 0;
+    uint8_t gzStep = 0;
+    uint16_t gzExtra = 0;
+    uint32_t crc = 0;
+
+    size_t producedBytes = 0;
+};
+
+#endif // OTADECOMPRESSOR_h
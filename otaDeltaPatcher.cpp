@@ -0,0 +1,228 @@
+/**
+ * OTA streaming delta patcher
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#include "otaDeltaPatcher.h"
+
+#include <string.h>
+
+#define OTADELTA_MAGIC "ENDSLEY/BSDIFF43"
+#define OTADELTA_OLD_BUFFER 512
+
+/**
+ * @brief Start applying a new patch
+ * @param src The partition holding the old image (usually the running one)
+ * @param srcSize The size of the old image the patch was created against
+ * @param sink Receives the new image in order
+ * @return true if the buffers could be allocated
+ */
+bool OtaDeltaPatcher::begin(const esp_partition_t *src, size_t srcSize, Sink sink) {
+    release();
+    if (!src || !sink || srcSize > src->size)
+        return fail("invalid source partition");
+
+    outBuf = (uint8_t *)malloc(BLOCK_SIZE);
+    oldBuf = (uint8_t *)malloc(OTADELTA_OLD_BUFFER);
+    if (!outBuf || !oldBuf) {
+        release();
+        return fail("out of memory");
+    }
+
+    source = src;
+    sourceSize = srcSize;
+    output = sink;
+    state = HEADER;
+    headerLen = 0;
+    diffLeft = extraLeft = seek = oldPos = 0;
+    targetSize = producedBytes = 0;
+    outLen = 0;
+    oldBufLen = 0;
+    error = "";
+    return true;
+}
+
+/**
+ * @brief Feed the next bytes of the patch
+ * @param data Patch bytes
+ * @param len Number of bytes
+ * @return false if the patch is invalid or the sink failed
+ */
+bool OtaDeltaPatcher::write(uint8_t *data, size_t len) {
+    while (len) {
+        switch (state) {
+        case HEADER:
+        case CONTROL: {
+            size_t take = sizeof(header) - headerLen;
+            if (take > len)
+                take = len;
+            memcpy(header + headerLen, data, take);
+            headerLen += take;
+            data += take;
+            len -= take;
+            if (headerLen < sizeof(header))
+                break;
+            headerLen = 0;
+
+            if (state == HEADER) {
+                if (memcmp(header, OTADELTA_MAGIC, 16) != 0)
+                    return fail("invalid patch header");
+                int64_t size = offtin(header + 16);
+                if (size <= 0)
+                    return fail("invalid new image size");
+                targetSize = size;
+                state = CONTROL;
+                break;
+            }
+
+            if (!producedBytes && !outLen && memcmp(header, "BZh", 3) == 0)
+                return fail("bzip2 compressed patch, convert it with tools/makeDelta.py");
+            diffLeft = offtin(header);
+            extraLeft = offtin(header + 8);
+            seek = offtin(header + 16);
+            if (diffLeft < 0 || extraLeft < 0 || producedBytes + outLen + diffLeft + extraLeft > targetSize)
+                return fail("corrupt patch control block");
+            state = diffLeft ? DIFF : (extraLeft ? EXTRA : CONTROL);
+            if (state == CONTROL)
+                oldPos += seek;
+            break;
+        }
+        case DIFF: {
+            // new = old + diff, bytes outside of the old image count as zero
+            size_t take = diffLeft < (int64_t)len ? diffLeft : len;
+            for (size_t i = 0; i < take; i++) {
+                uint8_t value = 0;
+                if (!readOld(oldPos + i, value))
+                    return false;
+                value += data[i];
+                if (!emit(&value, 1))
+                    return false;
+            }
+            oldPos += take;
+            diffLeft -= take;
+            data += take;
+            len -= take;
+            if (!diffLeft)
+                state = extraLeft ? EXTRA : CONTROL;
+            if (state == CONTROL)
+                oldPos += seek;
+            break;
+        }
+        case EXTRA: {
+            size_t take = extraLeft < (int64_t)len ? extraLeft : len;
+            if (!emit(data, take))
+                return false;
+            extraLeft -= take;
+            data += take;
+            len -= take;
+            if (!extraLeft) {
+                state = CONTROL;
+                oldPos += seek;
+            }
+            break;
+        }
+        case DONE:
+            return fail("trailing data after the patch");
+        default:
+            return false;
+        }
+
+        if (state == CONTROL && producedBytes + outLen == targetSize)
+            state = DONE;
+    }
+    return true;
+}
+
+/**
+ * @brief Flush the output and check that the new image is complete
+ * @return true if the whole new image was produced
+ */
+bool OtaDeltaPatcher::end() {
+    if (state == FAILED)
+        return false;
+    if (state == CONTROL && producedBytes + outLen == targetSize)
+        state = DONE;
+    if (state != DONE)
+        return fail("patch is incomplete");
+
+    bool success = flush();
+    release();
+    return success;
+}
+
+/**
+ * @brief Decode a sign-magnitude little endian 64 bit integer
+ */
+int64_t OtaDeltaPatcher::offtin(const uint8_t *buf) {
+    int64_t y = buf[7] & 0x7F;
+    for (int i = 6; i >= 0; i--)
+        y = y * 256 + buf[i];
+    return (buf[7] & 0x80) ? -y : y;
+}
+
+/**
+ * @brief Get a byte of the old image, read from flash in small blocks
+ */
+bool OtaDeltaPatcher::readOld(int64_t pos, uint8_t &value) {
+    if (pos < 0 || pos >= (int64_t)sourceSize) {
+        value = 0;
+        return true;
+    }
+    if (pos < oldBufStart || pos >= oldBufStart + (int64_t)oldBufLen) {
+        oldBufStart = pos;
+        oldBufLen = sourceSize - pos < OTADELTA_OLD_BUFFER ? sourceSize - pos : OTADELTA_OLD_BUFFER;
+        if (esp_partition_read(source, oldBufStart, oldBuf, oldBufLen) != ESP_OK) {
+            oldBufLen = 0;
+            return fail("unable to read the running partition");
+        }
+    }
+    value = oldBuf[pos - oldBufStart];
+    return true;
+}
+
+/**
+ * @brief Append bytes of the new image to the output block
+ */
+bool OtaDeltaPatcher::emit(const uint8_t *data, size_t len) {
+    while (len) {
+        size_t take = BLOCK_SIZE - outLen;
+        if (take > len)
+            take = len;
+        memcpy(outBuf + outLen, data, take);
+        outLen += take;
+        data += take;
+        len -= take;
+        if (outLen == BLOCK_SIZE && !flush())
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Pass the output block to the sink
+ */
+bool OtaDeltaPatcher::flush() {
+    if (!outLen)
+        return true;
+    if (!output(outBuf, outLen))
+        return fail("unable to write the new image");
+    producedBytes += outLen;
+    outLen = 0;
+    return true;
+}
+
+bool OtaDeltaPatcher::fail(const char *msg) {
+    error = msg;
+    state = FAILED;
+    return false;
+}
+
+void OtaDeltaPatcher::release() {
+    free(outBuf);
+    free(oldBuf);
+    outBuf = NULL;
+    oldBuf = NULL;
+}
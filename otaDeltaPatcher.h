@@ -0,0 +1,95 @@
+/**
+ * @file otaDeltaPatcher.h
+ * @author Martin Verges <martin@verges.cc>
+ * @version 0.3
+ * @date 2025-01-06
+ *
+ * @copyright Copyright (c) 2022-2024 by the author alone
+ *
+ * License: CC BY-NC-SA 4.0
+ */
+
+#ifndef OTADELTAPATCHER_h
+#define OTADELTAPATCHER_h
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <functional>
+
+/**
+ * Streaming bsdiff patch applier.
+ *
+ * Accepts a patch in the "ENDSLEY/BSDIFF43" format of https://github.com/mendsley/bsdiff,
+ * in arbitrary chunks. bsdiff itself compresses the stream after the header with
+ * bzip2, tools/makeDelta.py writes it uncompressed and gzips the whole file for
+ * OtaDecompressor instead. The old image is read from the running partition on
+ * demand, the new image is produced sequentially and passed to the output sink
+ * in blocks of BLOCK_SIZE bytes.
+ *
+ * Patch layout:
+ *   "ENDSLEY/BSDIFF43" | int64 newSize | { int64 diff, int64 extra, int64 seek, diff bytes, extra bytes }*
+ */
+class OtaDeltaPatcher {
+  public:
+    typedef std::function<bool(uint8_t *data, size_t len)> Sink;
+
+    static const size_t BLOCK_SIZE = 4096;
+
+    OtaDeltaPatcher() {}
+    virtual ~OtaDeltaPatcher() { release(); }
+
+    // Start a new patch against the first sourceSize bytes of the source partition
+    bool begin(const esp_partition_t *source, size_t sourceSize, Sink output);
+
+    // Feed the next bytes of the patch
+    bool write(uint8_t *data, size_t len);
+
+    // Flush the output and check that the new image is complete
+    bool end();
+
+    // Size of the new image announced by the patch header
+    size_t newSize() { return targetSize; }
+
+    // Bytes of the new image produced so far
+    size_t produced() { return producedBytes; }
+
+    // Description of the last error
+    const char *errorString() { return error; }
+
+  private:
+    enum State { HEADER, CONTROL, DIFF, EXTRA, DONE, FAILED };
+
+    static int64_t offtin(const uint8_t *buf);
+    bool fail(const char *msg);
+    bool readOld(int64_t pos, uint8_t &value);
+    bool emit(const uint8_t *data, size_t len);
+    bool flush();
+    void release();
+
+    const esp_partition_t *source = NULL;
+    size_t sourceSize = 0;
+    Sink output = NULL;
+
+    State state = FAILED;
+    uint8_t header[24];
+    size_t headerLen = 0;
+
+    int64_t diffLeft = 0;
+    int64_t extraLeft = 0;
+    int64_t seek = 0;
+    int64_t oldPos = 0;
+
+    size_t targetSize = 0;
+    size_t producedBytes = 0;
+
+    uint8_t *outBuf = NULL;
+    size_t outLen = 0;
+
+    uint8_t *oldBuf = NULL;
+    int64_t oldBufStart = 0;
+    size_t oldBufLen = 0;
+
+    const char *error = "";
+};
+
+#endif // OTADELTAPATCHER_h
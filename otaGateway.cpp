@@ -0,0 +1,236 @@
+/**
+ * OTA gateway push to downstream devices
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#include "otaGateway.h"
+
+#include <base64.h>
+#include <new> // std::nothrow
+
+#define OTAGATEWAY_BOUNDARY "otagateway7b3f"
+#define OTAGATEWAY_BODY_PREFIX "--" OTAGATEWAY_BOUNDARY "\r\n"                                       \
+                               "Content-Disposition: form-data; name=\"firmware\"; filename=\"firmware.bin\"\r\n" \
+                               "Content-Type: application/octet-stream\r\n\r\n"
+#define OTAGATEWAY_BODY_SUFFIX "\r\n--" OTAGATEWAY_BOUNDARY "--\r\n"
+
+#define OTAGATEWAY_CONNECT_TIMEOUT 3000   // ms
+#define OTAGATEWAY_RESPONSE_TIMEOUT 30000 // ms, the target verifies the image before it answers
+
+/**
+ * @brief Add a device to the next push
+ * @param address "host" or "host:port" of the device webserver
+ * @return false if the address is invalid, the list is full or a push is running
+ */
+bool OtaGatewayPush::addTarget(const String &address) {
+    if (running || count >= OTAGATEWAY_MAX_TARGETS)
+        return false;
+    int colon = address.lastIndexOf(':');
+    String host = colon > 0 ? address.substring(0, colon) : address;
+    uint16_t port = colon > 0 ? address.substring(colon + 1).toInt() : 80;
+    if (host.isEmpty() || !port)
+        return false;
+
+    OtaPushTarget &target = targets[count++];
+    target.host = host;
+    target.port = port;
+    target.state = OTA_PUSH_QUEUED;
+    target.sent = 0;
+    target.httpCode = 0;
+    target.error = "";
+    return true;
+}
+
+void OtaGatewayPush::clearTargets() {
+    if (!running)
+        count = 0;
+}
+
+uint8_t OtaGatewayPush::countState(OtaPushState state) {
+    uint8_t matches = 0;
+    for (uint8_t i = 0; i < count; i++)
+        if (targets[i].state == state)
+            matches++;
+    return matches;
+}
+
+/**
+ * @brief Upload an image to all targets
+ * @param partition Partition holding the image, usually the running one
+ * @param size Length of the image
+ * @param sha256Hex Hex SHA-256 of the image, checked by the targets
+ * @param signatureBase64 Signature of the hash, empty if the targets do not require one
+ * @param path Upload endpoint of the targets
+ * @return true if every target installed the image
+ */
+bool OtaGatewayPush::push(const esp_partition_t *partition, size_t size, const String &sha256Hex, const String &signatureBase64, const String &path) {
+    error = "";
+    if (!partition || !size || size > partition->size)
+        return fail("invalid image");
+    if (sha256Hex.length() != 64)
+        return fail("the image needs a sha256");
+    if (!count)
+        return fail("no targets");
+
+    uint8_t *buffer = (uint8_t *)malloc(OTAGATEWAY_CHUNK_SIZE);
+    if (!buffer)
+        return fail("out of memory");
+
+    running = true;
+    source = partition;
+    length = size;
+    for (uint8_t i = 0; i < count; i++) {
+        targets[i].state = OTA_PUSH_QUEUED;
+        targets[i].sent = 0;
+        targets[i].httpCode = 0;
+        targets[i].error = "";
+    }
+
+    uint8_t indexes[OTAGATEWAY_MAX_TARGETS];
+    for (uint8_t next = 0; next < count;) {
+        uint8_t budget = connectionBudget();
+        if (!budget) {
+            for (; next < count; next++) {
+                targets[next].state = OTA_PUSH_FAILED;
+                targets[next].error = "not enough heap on the gateway";
+            }
+            break;
+        }
+        waveSize = count - next < budget ? count - next : budget;
+        for (uint8_t i = 0; i < waveSize; i++)
+            indexes[i] = next + i;
+        pushWave(indexes, waveSize, buffer, sha256Hex, signatureBase64, path);
+        next += waveSize;
+    }
+
+    free(buffer);
+    running = false;
+    if (countState(OTA_PUSH_DONE) != count)
+        return fail("not all targets installed the image");
+    return true;
+}
+
+/**
+ * @brief Number of connections the free heap allows for, at most the concurrency
+ */
+uint8_t OtaGatewayPush::connectionBudget() {
+    size_t heap = ESP.getFreeHeap();
+    if (heap < heapReserve + OTAGATEWAY_TARGET_HEAP)
+        return 0;
+    size_t budget = (heap - heapReserve) / OTAGATEWAY_TARGET_HEAP;
+    return budget < concurrency ? budget : concurrency;
+}
+
+/**
+ * @brief Upload the image to a group of targets at the same time
+ *
+ * Every chunk is read once and written to each connection in turn. A target
+ * that does not take the chunk within the socket timeout is dropped.
+ */
+void OtaGatewayPush::pushWave(uint8_t *indexes, uint8_t waveCount, uint8_t *buffer, const String &sha256Hex, const String &signatureBase64, const String &path) {
+    WiFiClient *clients = new (std::nothrow) WiFiClient[waveCount];
+    if (!clients) {
+        for (uint8_t i = 0; i < waveCount; i++) {
+            targets[indexes[i]].state = OTA_PUSH_FAILED;
+            targets[indexes[i]].error = "out of memory";
+        }
+        return;
+    }
+
+    uint8_t active = 0;
+    for (uint8_t i = 0; i < waveCount; i++)
+        if (startUpload(clients[i], targets[indexes[i]], sha256Hex, signatureBase64, path))
+            active++;
+
+    for (size_t offset = 0; offset < length && active; offset += OTAGATEWAY_CHUNK_SIZE) {
+        size_t len = length - offset < OTAGATEWAY_CHUNK_SIZE ? length - offset : OTAGATEWAY_CHUNK_SIZE;
+        bool readable = esp_partition_read(source, offset, buffer, len) == ESP_OK;
+        for (uint8_t i = 0; i < waveCount; i++) {
+            OtaPushTarget &target = targets[indexes[i]];
+            if (target.state != OTA_PUSH_SENDING)
+                continue;
+            if (!readable) {
+                drop(clients[i], target, "unable to read the image");
+                active--;
+            } else if (clients[i].write(buffer, len) != len) {
+                drop(clients[i], target, "connection lost");
+                active--;
+            } else {
+                target.sent = offset + len;
+            }
+        }
+        yield();
+    }
+
+    for (uint8_t i = 0; i < waveCount; i++)
+        if (targets[indexes[i]].state == OTA_PUSH_SENDING)
+            finishUpload(clients[i], targets[indexes[i]]);
+    delete[] clients;
+}
+
+/**
+ * @brief Connect and send the request headers and the start of the multipart body
+ */
+bool OtaGatewayPush::startUpload(WiFiClient &client, OtaPushTarget &target, const String &sha256Hex, const String &signatureBase64, const String &path) {
+    target.state = OTA_PUSH_SENDING;
+    if (!client.connect(target.host.c_str(), target.port, OTAGATEWAY_CONNECT_TIMEOUT)) {
+        drop(client, target, "unable to connect");
+        return false;
+    }
+
+    size_t contentLength = strlen(OTAGATEWAY_BODY_PREFIX) + length + strlen(OTAGATEWAY_BODY_SUFFIX);
+    String header = "POST " + path + " HTTP/1.1\r\n";
+    header += "Host: " + target.host + "\r\n";
+    header += "Connection: close\r\n";
+    header += "Content-Type: multipart/form-data; boundary=" OTAGATEWAY_BOUNDARY "\r\n";
+    header += "Content-Length: " + String(contentLength) + "\r\n";
+    header += "X-OTA-SHA256: " + sha256Hex + "\r\n";
+    if (!signatureBase64.isEmpty())
+        header += "X-OTA-Signature: " + signatureBase64 + "\r\n";
+    if (!otaPassword.isEmpty())
+        header += "Authorization: Basic " + base64::encode("ota:" + otaPassword) + "\r\n";
+    header += "\r\n" OTAGATEWAY_BODY_PREFIX;
+
+    if (client.write((const uint8_t *)header.c_str(), header.length()) != header.length()) {
+        drop(client, target, "connection lost");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Close the multipart body and wait for the answer of the target
+ */
+void OtaGatewayPush::finishUpload(WiFiClient &client, OtaPushTarget &target) {
+    const char *suffix = OTAGATEWAY_BODY_SUFFIX;
+    if (client.write((const uint8_t *)suffix, strlen(suffix)) != strlen(suffix))
+        return drop(client, target, "connection lost");
+
+    uint32_t start = millis();
+    while (!client.available() && client.connected() && millis() - start < OTAGATEWAY_RESPONSE_TIMEOUT)
+        vTaskDelay(pdMS_TO_TICKS(10));
+    String status = client.readStringUntil('\n'); // HTTP/1.1 200 OK
+    client.stop();
+
+    target.httpCode = status.startsWith("HTTP/") ? status.substring(status.indexOf(' ') + 1).toInt() : 0;
+    if (target.httpCode == 200) {
+        target.state = OTA_PUSH_DONE;
+    } else {
+        target.state = OTA_PUSH_FAILED;
+        target.error = !target.httpCode ? "no response" : target.httpCode == 401 ? "invalid password" : "upload rejected";
+    }
+}
+
+void OtaGatewayPush::drop(WiFiClient &client, OtaPushTarget &target, const char *msg) {
+    client.stop();
+    target.state = OTA_PUSH_FAILED;
+    target.error = msg;
+}
+
+bool OtaGatewayPush::fail(const char *msg) {
+    error = msg;
+    return false;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file otaGateway.h
+ * @author Martin Verges <martin@verges.cc>
+ * @version 0.3
+ * @date 2025-01-06
+ *
+ * @copyright Copyright (c) 2022-2024 by the author alone
+ *
+ * License: CC BY-NC-SA 4.0
+ */
+
+#ifndef OTAGATEWAY_h
+#define OTAGATEWAY_h
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <esp_partition.h>
+
+// Devices a single push serves
+#define OTAGATEWAY_MAX_TARGETS 32
+
+// Bytes read from flash at once and written to every target of a wave
+#define OTAGATEWAY_CHUNK_SIZE 4096
+
+// Heap a connection to a target costs, mostly lwIP send buffers
+#define OTAGATEWAY_TARGET_HEAP (8 * 1024)
+
+// Progress of a single target
+enum OtaPushState {
+    OTA_PUSH_QUEUED,  // waiting for a free connection
+    OTA_PUSH_SENDING, // the image is being uploaded
+    OTA_PUSH_DONE,    // the target accepted and installed the image
+    OTA_PUSH_FAILED,  // see OtaPushTarget::error
+};
+
+// A device the image is uploaded to
+struct OtaPushTarget {
+    String host;
+    uint16_t port = 80;
+    volatile OtaPushState state = OTA_PUSH_QUEUED;
+    volatile size_t sent = 0; // bytes of the image
+    int httpCode = 0;         // status of the upload response
+    const char *error = "";
+};
+
+/**
+ * Uploads an image from a partition to the /api/ota/upload endpoint of a list of devices.
+ *
+ * The targets are served in waves of up to setConcurrency() connections, fewer
+ * if the free heap does not allow for more. Each chunk of the image is read
+ * from flash once and written to all connections of the wave from the same
+ * buffer, so the memory does not grow with the number of targets. A target
+ * that fails or stalls is dropped, the others continue.
+ *
+ * Targets verify the upload with the X-OTA-SHA256 and X-OTA-Signature headers.
+ */
+class OtaGatewayPush {
+  public:
+    // Add a device as "host" or "host:port", false if the list is full
+    bool addTarget(const String &address);
+
+    // Remove all targets
+    void clearTargets();
+
+    // Connections of a wave at most
+    void setConcurrency(uint8_t connections) { concurrency = connections ? connections : 1; }
+
+    // Heap that has to stay free on the gateway, limits the connections of a wave
+    void setHeapReserve(size_t bytes) { heapReserve = bytes; }
+
+    // OTA password of the targets, empty if they have none
+    void setPassword(const String &password) { otaPassword = password; }
+
+    // Upload size bytes of the partition to all targets, blocks until every target is done or failed
+    bool push(const esp_partition_t *partition, size_t size, const String &sha256Hex, const String &signatureBase64, const String &path = "/api/ota/upload");
+
+    // The configured targets and their progress
+    uint8_t targetCount() { return count; }
+    const OtaPushTarget &target(uint8_t index) { return targets[index]; }
+
+    // Number of targets in a state
+    uint8_t countState(OtaPushState state);
+
+    // Is a push running
+    bool isRunning() { return running; }
+
+    // Size of the image of the last or the running push
+    size_t imageSize() { return length; }
+
+    // Connections used by the last wave
+    uint8_t lastConcurrency() { return waveSize; }
+
+    // Description of the last error
+    const char *errorString() { return error; }
+
+  private:
+    uint8_t connectionBudget();
+    void pushWave(uint8_t *indexes, uint8_t waveCount, uint8_t *buffer, const String &sha256Hex, const String &signatureBase64, const String &path);
+    bool startUpload(WiFiClient &client, OtaPushTarget &target, const String &sha256Hex, const String &signatureBase64, const String &path);
+    void finishUpload(WiFiClient &client, OtaPushTarget &target);
+    void drop(WiFiClient &client, OtaPushTarget &target, const char *msg);
+    bool fail(const char *msg);
+
+    OtaPushTarget targets[OTAGATEWAY_MAX_TARGETS];
+    uint8_t count = 0;
+    uint8_t concurrency = 4;
+    uint8_t waveSize = 0;
+    size_t heapReserve = 48 * 1024;
+    String otaPassword = "";
+    const esp_partition_t *source = NULL;
+    size_t length = 0;
+    volatile bool running = false;
+    const char *error = "";
+};
+
+#endif // OTAGATEWAY_h
@@ -0,0 +1,187 @@
+/**
+ * OTA keep-alive HTTP session
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#include "otaHttpSession.h"
+
+#include <atomic>
+#include <new> // std::nothrow
+#include <lwip/dns.h>
+#include <lwip/tcpip.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+// A name lookup shared by the caller and the lwIP callback, the last one frees it
+struct OtaDnsLookup {
+    char host[DNS_MAX_NAME_LENGTH];
+    ip_addr_t addr;
+    bool found = false;
+    SemaphoreHandle_t done = NULL;
+    std::atomic<uint8_t> refs{2};
+
+    void release() {
+        if (--refs == 0) {
+            vSemaphoreDelete(done);
+            delete this;
+        }
+    }
+};
+
+static void dnsFound(const char *name, const ip_addr_t *addr, void *arg) {
+    OtaDnsLookup *lookup = (OtaDnsLookup *)arg;
+    lookup->found = addr != NULL;
+    xSemaphoreGive(lookup->done);
+    lookup->release();
+}
+
+// runs in the tcpip thread
+static void dnsStart(void *arg) {
+    OtaDnsLookup *lookup = (OtaDnsLookup *)arg;
+    err_t err = dns_gethostbyname(lookup->host, &lookup->addr, dnsFound, lookup);
+    if (err != ERR_INPROGRESS)
+        dnsFound(lookup->host, err == ERR_OK ? &lookup->addr : NULL, lookup);
+}
+
+/**
+ * @brief Send a GET request over the session connection
+ * @param url The url to request
+ * @param prepare Optional callback to add headers, called again on a reconnect
+ * @param connectMs Deadline to resolve the host, connect and finish the TLS handshake, 0 for the session timeout
+ * @param readMs Deadline for each read of the response, 0 for the session timeout
+ * @return The HTTP status code, OTAHTTP_ERROR_DNS, OTAHTTP_ERROR_INSECURE or a negative HTTPC_ERROR_* value
+ */
+int OtaHttpSession::get(const String &url, Prepare prepare, uint16_t connectMs, uint16_t readMs) {
+    if (url.startsWith("https://") && !caCert && !insecure)
+        return OTAHTTP_ERROR_INSECURE;
+    connectMs = connectMs ? connectMs : connectTimeout;
+    readMs = readMs ? readMs : readTimeout;
+    for (uint8_t attempt = 0; attempt < 2; attempt++) {
+        if (!begin(url, connectMs, readMs))
+            return HTTPC_ERROR_CONNECTION_REFUSED;
+        if (!lastReused && !resolve(url, connectMs))
+            return OTAHTTP_ERROR_DNS;
+        if (prepare)
+            prepare(http);
+
+        int httpCode = http.GET();
+        if (httpCode >= 0 || !lastReused)
+            return httpCode;
+
+        // the server closed the idle connection, try once with a new one
+        close();
+    }
+    return HTTPC_ERROR_CONNECTION_LOST;
+}
+
+/**
+ * @brief Prepare the HTTPClient for the url, dropping connections to other origins
+ */
+bool OtaHttpSession::begin(const String &url, uint16_t connectMs, uint16_t readMs) {
+    String target = originOf(url);
+    if (target != origin)
+        close();
+    origin = target;
+
+    WiFiClient *client = &plain;
+    if (url.startsWith("https://")) {
+        if (caCert)
+            secure.setCACert(caCert);
+        else
+            secure.setInsecure(); // only with setInsecure(true), see get()
+        secure.setHandshakeTimeout((connectMs + 999) / 1000); // seconds, 120 by default
+        client = &secure;
+    }
+    lastReused = client->connected();
+
+    http.setReuse(true);
+    http.setFollowRedirects(HTTPC_FORCE_FOLLOW_REDIRECTS);
+    http.setConnectTimeout(connectMs);
+    http.setTimeout(readMs);
+    return http.begin(*client, url);
+}
+
+/**
+ * @brief Finish a completely read request and keep the connection if the server allows it
+ */
+void OtaHttpSession::end() {
+    http.end();
+}
+
+/**
+ * @brief Drop the connection
+ */
+void OtaHttpSession::close() {
+    http.setReuse(false);
+    http.end();
+    plain.stop();
+    secure.stop();
+    origin = "";
+    lastReused = false;
+}
+
+/**
+ * @brief Resolve the host of an url within a deadline
+ * @return false if the name is unknown or the DNS server did not answer in time
+ *
+ * The socket API blocks until the resolver gives up, which takes far longer
+ * than our connect timeout. This asks lwIP directly and only waits for the
+ * deadline, the connect right after finds the address in the DNS cache.
+ */
+bool OtaHttpSession::resolve(const String &url, uint16_t timeoutMs) {
+    String host = originOf(url);
+    int scheme = host.indexOf("://");
+    host = host.substring(scheme < 0 ? 0 : scheme + 3);
+    if (host.startsWith("["))
+        return true; // IPv6 literal
+    if (host.indexOf(':') >= 0)
+        host = host.substring(0, host.indexOf(':'));
+    if (host.isEmpty() || host.length() >= DNS_MAX_NAME_LENGTH)
+        return false;
+
+    OtaDnsLookup *lookup = new (std::nothrow) OtaDnsLookup();
+    if (!lookup)
+        return false;
+    lookup->done = xSemaphoreCreateBinary();
+    if (!lookup->done) {
+        delete lookup;
+        return false;
+    }
+    strcpy(lookup->host, host.c_str());
+    if (tcpip_callback(dnsStart, lookup) != ERR_OK) {
+        vSemaphoreDelete(lookup->done);
+        delete lookup;
+        return false;
+    }
+
+    bool found = xSemaphoreTake(lookup->done, pdMS_TO_TICKS(timeoutMs)) == pdTRUE && lookup->found;
+    lookup->release();
+    return found;
+}
+
+/**
+ * @brief Get "scheme://host:port" of an url
+ */
+String OtaHttpSession::originOf(const String &url) {
+    int scheme = url.indexOf("://");
+    int path = url.indexOf('/', scheme < 0 ? 0 : scheme + 3);
+    return path < 0 ? url : url.substring(0, path);
+}
+
+/**
+ * @brief Read up to length bytes, waiting no longer than the stream timeout and the deadline
+ */
+size_t OtaDeadlineStream::readBytes(char *buffer, size_t length) {
+    if (expired())
+        return 0;
+    unsigned long timeout = stream.getTimeout();
+    uint32_t remaining = deadline - millis();
+    stream.setTimeout(remaining < timeout ? remaining : timeout);
+    size_t len = stream.readBytes(buffer, length);
+    stream.setTimeout(timeout);
+    return len;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file otaHttpSession.h
+ * @author Martin Verges <martin@verges.cc>
+ * @version 0.3
+ * @date 2025-01-06
+ *
+ * @copyright Copyright (c) 2022-2024 by the author alone
+ *
+ * License: CC BY-NC-SA 4.0
+ */
+
+#ifndef OTAHTTPSESSION_h
+#define OTAHTTPSESSION_h
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <WiFiClient.h>
+#include <WiFiClientSecure.h>
+#include <functional>
+
+// get() result if the host name could not be resolved within the connect timeout
+#define OTAHTTP_ERROR_DNS (-20)
+
+// get() result for a https url without a CA certificate, unless setInsecure() allows it
+#define OTAHTTP_ERROR_INSECURE (-21)
+
+/**
+ * A HTTP/1.1 keep-alive connection shared by the manifest check and all downloads.
+ *
+ * Requests to the same origin (scheme, host and port) reuse the open TCP or TLS
+ * connection, so an update costs a single TLS handshake. A stale connection the
+ * server already closed is detected on the next request and reconnected once.
+ *
+ * Name resolution, connect, the TLS handshake and reads all end at explicit
+ * deadlines, so an unreachable server gives up after the timeouts instead of
+ * the stack defaults.
+ */
+class OtaHttpSession {
+  public:
+    // Called after begin() to add request headers and header keys to collect
+    typedef std::function<void(HTTPClient &http)> Prepare;
+
+    OtaHttpSession() {}
+    virtual ~OtaHttpSession() { close(); }
+
+    // Send a GET request, reusing the connection if possible, 0 uses the session timeouts
+    int get(const String &url, Prepare prepare = NULL, uint16_t connectMs = 0, uint16_t readMs = 0);
+
+    // The client of the running request, to read headers and the body
+    HTTPClient &client() { return http; }
+
+    // Finish a request whose body was read completely, keeps the connection open
+    void end();
+
+    // Drop the connection, required if the body was not read completely
+    void close();
+
+    // CA certificate (PEM) to verify https servers, without one https is refused
+    void setCACert(const char *ca) { caCert = ca; }
+
+    // Accept any server certificate if no CA certificate is set
+    void setInsecure(bool allow) { insecure = allow; }
+
+    // Connect and read timeout in milliseconds
+    void setTimeout(uint16_t ms) { connectTimeout = readTimeout = ms; }
+
+    // Read timeout of requests without an own one
+    uint16_t timeout() { return readTimeout; }
+
+    // Was the last request sent over an already open connection
+    bool reused() { return lastReused; }
+
+  private:
+    static String originOf(const String &url);
+    static bool resolve(const String &url, uint16_t timeoutMs);
+    bool begin(const String &url, uint16_t connectMs, uint16_t readMs);
+
+    HTTPClient http;
+    WiFiClient plain;
+    WiFiClientSecure secure;
+
+    String origin = "";
+    const char *caCert = NULL;
+    bool insecure = false;
+    uint16_t connectTimeout = 10000;
+    uint16_t readTimeout = 10000;
+    bool lastReused = false;
+};
+
+/**
+ * Ends the reads of a response body at a fixed point in time.
+ *
+ * The timeout of a stream applies to each read, a server sending a byte now
+ * and then keeps a parser busy far longer. Reads through this wrapper wait at
+ * most until the deadline and return nothing after it.
+ */
+class OtaDeadlineStream : public Stream {
+  public:
+    OtaDeadlineStream(Stream &source, uint32_t deadlineMillis) : stream(source), deadline(deadlineMillis) {}
+
+    int available() { return expired() ? 0 : stream.available(); }
+    int read() { return expired() ? -1 : stream.read(); }
+    int peek() { return expired() ? -1 : stream.peek(); }
+    size_t readBytes(char *buffer, size_t length);
+    size_t readBytes(uint8_t *buffer, size_t length) { return readBytes((char *)buffer, length); }
+    size_t write(uint8_t) { return 0; }
+
+    // Did the deadline pass
+    bool expired() { return (int32_t)(millis() - deadline) >= 0; }
+
+  private:
+    Stream &stream;
+    uint32_t deadline;
+};
+
+#endif // OTAHTTPSESSION_h
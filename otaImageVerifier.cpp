@@ -0,0 +1,156 @@
+/**
+ * OTA image verification
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#include "otaImageVerifier.h"
+
+#include <mbedtls/base64.h>
+#include <mbedtls/pk.h>
+#include <string.h>
+
+/**
+ * @brief Start verifying a new image
+ * @param sha256Hex Expected SHA-256 of the image as 64 hex digits, empty to skip
+ * @param signatureBase64 Base64 DER signature of the SHA-256, empty if unsigned
+ * @param publicKeyPem Public key in PEM format, NULL to accept unsigned images
+ * @return false if the expected values are malformed or a required signature is missing
+ */
+bool OtaImageVerifier::begin(const String &sha256Hex, const String &signatureBase64, const char *publicKeyPem) {
+    release();
+    error = "";
+    key = publicKeyPem;
+    hasHash = false;
+    hasDigest = false;
+    signatureLen = 0;
+
+    if (!sha256Hex.isEmpty()) {
+        if (sha256Hex.length() != 64)
+            return fail("invalid sha256 in the manifest");
+        for (uint8_t i = 0; i < 32; i++) {
+            char hex[3] = {sha256Hex[i * 2], sha256Hex[i * 2 + 1], 0};
+            char *end = NULL;
+            expected[i] = strtoul(hex, &end, 16);
+            if (*end)
+                return fail("invalid sha256 in the manifest");
+        }
+        hasHash = true;
+    }
+
+    // kept off the stack, the callers run next to TLS and the update buffers on the background task
+    if (!signatureBase64.isEmpty()) {
+        if (!signature)
+            signature = (uint8_t *)malloc(OTAVERIFIER_MAX_SIGNATURE);
+        if (!signature)
+            return fail("out of memory");
+        if (mbedtls_base64_decode(signature, OTAVERIFIER_MAX_SIGNATURE, &signatureLen, (const uint8_t *)signatureBase64.c_str(), signatureBase64.length()) != 0)
+            return fail("invalid signature encoding");
+    }
+    if (key && !signatureLen)
+        return fail("image is not signed");
+
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts(&sha, 0);
+    hashing = true;
+    return true;
+}
+
+/**
+ * @brief Hash the next bytes of the image
+ */
+void OtaImageVerifier::update(const uint8_t *data, size_t len) {
+    if (hashing)
+        mbedtls_sha256_update(&sha, data, len);
+}
+
+/**
+ * @brief Hash data that was written before, e.g. by an earlier boot
+ * @param partition The partition the image is written to
+ * @param len Bytes from the partition start to hash
+ * @return false on a flash read error
+ *
+ * This is the only read back from flash, and only for the part of a download
+ * that was written before the restart.
+ */
+bool OtaImageVerifier::updateFromPartition(const esp_partition_t *partition, size_t len) {
+    if (!hashing || !len)
+        return true;
+    uint8_t buf[512];
+    for (size_t pos = 0; pos < len; pos += sizeof(buf)) {
+        size_t take = len - pos < sizeof(buf) ? len - pos : sizeof(buf);
+        if (esp_partition_read(partition, pos, buf, take) != ESP_OK)
+            return fail("unable to read the written image");
+        mbedtls_sha256_update(&sha, buf, take);
+    }
+    return true;
+}
+
+/**
+ * @brief Compare the hash and check the signature
+ * @return true if the image matches the expected hash and signature
+ */
+bool OtaImageVerifier::finish() {
+    if (!hashing)
+        return !*error && !key;
+
+    mbedtls_sha256_finish(&sha, computed);
+    release();
+    hasDigest = true;
+
+    if (hasHash && memcmp(computed, expected, sizeof(computed)) != 0)
+        return fail("sha256 mismatch");
+    return checkSignature(computed);
+}
+
+/**
+ * @brief The SHA-256 of the image, available after finish()
+ */
+String OtaImageVerifier::digestHex() {
+    return hasDigest ? toHex(computed) : String();
+}
+
+String OtaImageVerifier::toHex(const uint8_t *digest) {
+    char hex[65];
+    for (uint8_t i = 0; i < 32; i++)
+        snprintf(hex + i * 2, 3, "%02x", digest[i]);
+    return String(hex);
+}
+
+/**
+ * @brief Verify the signature of a SHA-256 digest with the public key
+ * @param digest 32 bytes
+ * @return true if the signature is valid or no key is configured
+ */
+bool OtaImageVerifier::checkSignature(const uint8_t *digest) {
+    if (!key)
+        return true;
+    if (*error)
+        return false;
+
+    mbedtls_pk_context pk;
+    mbedtls_pk_init(&pk);
+    bool valid = false;
+    if (mbedtls_pk_parse_public_key(&pk, (const uint8_t *)key, strlen(key) + 1) != 0)
+        fail("invalid public key");
+    else if (mbedtls_pk_verify(&pk, MBEDTLS_MD_SHA256, digest, 32, signature, signatureLen) != 0)
+        fail("signature mismatch");
+    else
+        valid = true;
+    mbedtls_pk_free(&pk);
+    return valid;
+}
+
+bool OtaImageVerifier::fail(const char *msg) {
+    error = msg;
+    release();
+    return false;
+}
+
+void OtaImageVerifier::release() {
+    if (hashing)
+        mbedtls_sha256_free(&sha);
+    hashing = false;
+}
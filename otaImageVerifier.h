@@ -0,0 +1,83 @@
+/**
+ * @file otaImageVerifier.h
+ * @author Martin Verges <martin@verges.cc>
+ * @version 0.3
+ * @date 2025-01-06
+ *
+ * @copyright Copyright (c) 2022-2024 by the author alone
+ *
+ * License: CC BY-NC-SA 4.0
+ */
+
+#ifndef OTAIMAGEVERIFIER_h
+#define OTAIMAGEVERIFIER_h
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <mbedtls/sha256.h>
+
+// Longest DER encoded signature accepted (ECDSA P-521 or RSA-4096 would need more)
+#define OTAVERIFIER_MAX_SIGNATURE 512
+
+/**
+ * Incremental SHA-256 and signature check of an image while it is written.
+ *
+ * The hash is updated with every chunk on its way to the flash (the SHA engine
+ * of the ESP32 is used by mbedtls), so finish() only compares 32 bytes and checks
+ * the signature over the digest. The signature is a DER encoded ECDSA (or RSA)
+ * signature of the SHA-256, verified with the configured public key.
+ */
+class OtaImageVerifier {
+  public:
+    OtaImageVerifier() {}
+    virtual ~OtaImageVerifier() {
+        release();
+        free(signature);
+    }
+
+    // Start a new image, empty values are not checked, a key makes the signature mandatory
+    bool begin(const String &sha256Hex, const String &signatureBase64, const char *publicKeyPem);
+
+    // Hash the next bytes of the image
+    void update(const uint8_t *data, size_t len);
+
+    // Hash the first len bytes already in the partition, after a resumed download
+    bool updateFromPartition(const esp_partition_t *partition, size_t len);
+
+    // Check the hash and the signature of everything passed to update()
+    bool finish();
+
+    // Check the signature against a digest computed elsewhere, true if no key is set
+    bool checkSignature(const uint8_t *digest);
+
+    // SHA-256 computed by the last finish() as hex, empty before
+    String digestHex();
+
+    // Format a SHA-256 as 64 lower case hex digits
+    static String toHex(const uint8_t *digest);
+
+    // Is there anything to verify
+    bool enabled() { return hasHash || key; }
+
+    // Description of the last error
+    const char *errorString() { return error; }
+
+  private:
+    bool fail(const char *msg);
+    void release();
+
+    mbedtls_sha256_context sha;
+    bool hashing = false;
+
+    bool hasHash = false;
+    uint8_t expected[32];
+    bool hasDigest = false;
+    uint8_t computed[32];
+    uint8_t *signature = NULL; // OTAVERIFIER_MAX_SIGNATURE on the heap, only for signed images
+    size_t signatureLen = 0;
+    const char *key = NULL;
+
+    const char *error = "";
+};
+
+#endif // OTAIMAGEVERIFIER_h
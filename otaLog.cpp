@@ -0,0 +1,125 @@
+/**
+ * OTA log buffer
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#include "otaLog.h"
+
+#include <string.h>
+
+// Longest wait of the drain task before it checks for end(), in ms
+#define OTALOG_STOP_POLL 50
+
+/**
+ * @brief Allocate the ring buffer and start the drain task
+ * @param output Called from the drain task for every message
+ * @param capacity Size of the ring buffer in bytes
+ * @param priority Priority of the drain task, keep it below the network tasks
+ * @return true if the buffer is ready
+ */
+bool OtaLogBuffer::begin(Sink output, size_t capacity, UBaseType_t priority) {
+    end();
+    sink = output;
+    droppedMessages = queuedMessages = writtenMessages = 0;
+    stopping = stopped = false;
+
+    ring = xRingbufferCreate(capacity, RINGBUF_TYPE_NOSPLIT);
+    if (!ring)
+        return false;
+    maxItem = xRingbufferGetMaxItemSize(ring);
+
+    if (xTaskCreate(drainTask, "OtaLog", 3072, this, priority, &task) != pdPASS) {
+        vRingbufferDelete(ring);
+        ring = NULL;
+        task = NULL;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Stop the drain task and free the buffer
+ *
+ * The task is asked to exit and waited for, so it is never deleted while it
+ * holds an item of the ring buffer or runs the sink.
+ */
+void OtaLogBuffer::end() {
+    if (task) {
+        stopping = true;
+        while (!stopped)
+            delay(1);
+        task = NULL;
+    }
+    if (ring) {
+        vRingbufferDelete(ring);
+        ring = NULL;
+    }
+}
+
+/**
+ * @brief Copy a message into the buffer
+ * @param msg The message, does not need to be terminated
+ * @param len Length of the message, longer messages are truncated
+ * @param showtime Prepend the log time when the message is written
+ * @return false if the message was dropped
+ */
+bool OtaLogBuffer::push(const char *msg, size_t len, bool showtime) {
+    if (!ring)
+        return false;
+
+    // the item is the showtime flag, the message and a terminating zero
+    uint8_t *item = NULL;
+    if (len + 2 > maxItem)
+        len = maxItem - 2;
+    if (xRingbufferSendAcquire(ring, (void **)&item, len + 2, 0) != pdTRUE) {
+        droppedMessages++;
+        return false;
+    }
+    item[0] = showtime;
+    memcpy(item + 1, msg, len);
+    item[len + 1] = 0;
+    xRingbufferSendComplete(ring, item);
+    queuedMessages++;
+    return true;
+}
+
+/**
+ * @brief Wait for the drain task to write all queued messages
+ * @param timeoutMillis Give up after this time, e.g. if the sink hangs
+ */
+void OtaLogBuffer::flush(uint32_t timeoutMillis) {
+    uint32_t start = millis();
+    while (ring && writtenMessages != queuedMessages && millis() - start < timeoutMillis)
+        delay(1);
+}
+
+/**
+ * @brief Hand buffered messages to the sink, reporting lost ones
+ */
+void OtaLogBuffer::drainTask(void *param) {
+    OtaLogBuffer *log = (OtaLogBuffer *)param;
+    uint32_t reported = 0;
+    while (!log->stopping) {
+        size_t size = 0;
+        uint8_t *item = (uint8_t *)xRingbufferReceive(log->ring, &size, pdMS_TO_TICKS(OTALOG_STOP_POLL));
+        if (!item)
+            continue;
+        if (log->sink)
+            log->sink((const char *)item + 1, item[0]);
+        vRingbufferReturnItem(log->ring, item);
+        log->writtenMessages++;
+
+        uint32_t dropped = log->droppedMessages;
+        if (dropped != reported && log->sink) {
+            char msg[48];
+            snprintf(msg, sizeof(msg), "[OTA] %u log messages dropped", (unsigned)(dropped - reported));
+            log->sink(msg, true);
+            reported = dropped;
+        }
+    }
+    log->stopped = true;
+    vTaskDelete(NULL);
+}
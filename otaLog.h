@@ -0,0 +1,142 @@
+/**
+ * @file otaLog.h
+ * @author Martin Verges <martin@verges.cc>
+ * @version 0.3
+ * @date 2025-01-06
+ *
+ * @copyright Copyright (c) 2022-2024 by the author alone
+ *
+ * License: CC BY-NC-SA 4.0
+ */
+
+#ifndef OTALOG_h
+#define OTALOG_h
+
+#include <Arduino.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/ringbuf.h>
+#include <freertos/task.h>
+#include <functional>
+
+#define OTAWEBUPDATER_LOG_NONE 0
+#define OTAWEBUPDATER_LOG_ERROR 1
+#define OTAWEBUPDATER_LOG_INFO 2
+#define OTAWEBUPDATER_LOG_DEBUG 3
+
+// Messages above this level are removed at compile time
+#ifndef OTAWEBUPDATER_LOG_LEVEL
+#define OTAWEBUPDATER_LOG_LEVEL OTAWEBUPDATER_LOG_INFO
+#endif
+
+// The message expression is not evaluated if its level is disabled
+#if OTAWEBUPDATER_LOG_LEVEL >= OTAWEBUPDATER_LOG_ERROR
+#define OTA_LOG_ERROR(msg) logMessage(msg)
+#else
+#define OTA_LOG_ERROR(msg) \
+    do {                   \
+    } while (0)
+#endif
+
+#if OTAWEBUPDATER_LOG_LEVEL >= OTAWEBUPDATER_LOG_INFO
+#define OTA_LOG_INFO(msg) logMessage(msg)
+#else
+#define OTA_LOG_INFO(msg) \
+    do {                  \
+    } while (0)
+#endif
+
+#if OTAWEBUPDATER_LOG_LEVEL >= OTAWEBUPDATER_LOG_DEBUG
+#define OTA_LOG_DEBUG(msg) logMessage(msg)
+#else
+#define OTA_LOG_DEBUG(msg) \
+    do {                   \
+    } while (0)
+#endif
+
+/**
+ * Decouples log producers from a slow log sink (usually Serial).
+ *
+ * Messages are copied into a FreeRTOS no-split ring buffer without blocking and
+ * handed to the sink by a low priority task. If the buffer is full the message is
+ * dropped and counted instead of stalling the caller, e.g. the download loop.
+ */
+class OtaLogBuffer {
+  public:
+    // Receives a message and whether a timestamp should be prepended
+    typedef std::function<void(const char *msg, bool showtime)> Sink;
+
+    OtaLogBuffer() {}
+    virtual ~OtaLogBuffer() { end(); }
+
+    // Allocate the buffer and start the drain task
+    bool begin(Sink output, size_t capacity = 4096, UBaseType_t priority = tskIDLE_PRIORITY + 1);
+
+    // Stop the drain task after the message it is writing, pending messages are lost
+    void end();
+
+    // Queue a message, never blocks
+    bool push(const char *msg, size_t len, bool showtime);
+
+    // Wait until all queued messages were written, e.g. before a restart
+    void flush(uint32_t timeoutMillis = 250);
+
+    // Is the drain task running
+    bool running() { return ring != NULL; }
+
+    // Messages lost because the buffer was full
+    uint32_t dropped() { return droppedMessages; }
+
+  private:
+    static void drainTask(void *param);
+
+    Sink sink = NULL;
+    RingbufHandle_t ring = NULL;
+    TaskHandle_t task = NULL;
+    size_t maxItem = 0;
+    std::atomic<bool> stopping{false}; // end() asks the drain task to exit
+    std::atomic<bool> stopped{false};  // the drain task no longer touches the buffer
+    std::atomic<uint32_t> droppedMessages{0}; // counted by every producing task
+    std::atomic<uint32_t> queuedMessages{0};
+    std::atomic<uint32_t> writtenMessages{0};
+};
+
+/**
+ * Decides when a download progress is worth a log line.
+ *
+ * Reports every stepPercent of a known size, or every intervalMillis if the size
+ * is unknown or the download is slow, so the hot loop only compares numbers.
+ */
+struct OtaProgress {
+    uint8_t stepPercent = 10;
+    uint32_t intervalMillis = 5000;
+
+    // Start a new download
+    void reset() {
+        lastPercent = 0;
+        lastMillis = millis();
+    }
+
+    // Should the progress be reported now
+    bool due(size_t current, int total) {
+        if (total > 0) {
+            uint8_t percent = (uint64_t)current * 100 / total;
+            if (percent >= lastPercent + stepPercent || (percent == 100 && lastPercent != 100)) {
+                lastPercent = percent;
+                lastMillis = millis();
+                return true;
+            }
+        }
+        if (millis() - lastMillis >= intervalMillis) {
+            lastMillis = millis();
+            return true;
+        }
+        return false;
+    }
+
+  private:
+    uint8_t lastPercent = 0;
+    uint32_t lastMillis = 0;
+};
+
+#endif // OTALOG_h
@@ -0,0 +1,192 @@
+/**
+ * OTA metrics
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#include "otaMetrics.h"
+
+// A manifest request takes tens to thousands of milliseconds
+static const uint32_t manifestBounds[OTAMETRICS_BUCKETS] = {25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 5000000};
+
+// Reading or writing a slot takes microseconds (cached socket data) to a second (sector erase)
+static const uint32_t chunkBounds[OTAMETRICS_BUCKETS] = {100, 500, 1000, 5000, 10000, 50000, 100000, 500000};
+
+void OtaHistogram::observe(uint32_t micros) {
+    uint8_t i = 0;
+    while (i < OTAMETRICS_BUCKETS && micros > bounds[i])
+        i++;
+    buckets[i]++;
+    sumMicros += micros;
+    count++;
+}
+
+OtaMetrics::OtaMetrics() : manifestLatency(manifestBounds), readLatency(chunkBounds), slotWait(chunkBounds), writeLatency(chunkBounds) {
+    memset(errors, 0, sizeof(errors));
+}
+
+void OtaMetrics::observeManifest(uint32_t micros, bool success) {
+    portENTER_CRITICAL(&lock);
+    manifestLatency.observe(micros);
+    manifestChecks++;
+    if (!success)
+        manifestFailures++;
+    portEXIT_CRITICAL(&lock);
+}
+
+void OtaMetrics::observeRead(uint32_t micros, size_t len) {
+    portENTER_CRITICAL(&lock);
+    readLatency.observe(micros);
+    bytes += len;
+    portEXIT_CRITICAL(&lock);
+}
+
+void OtaMetrics::observeSlotWait(uint32_t micros) {
+    portENTER_CRITICAL(&lock);
+    slotWait.observe(micros);
+    portEXIT_CRITICAL(&lock);
+}
+
+void OtaMetrics::observeWrite(uint32_t micros) {
+    portENTER_CRITICAL(&lock);
+    writeLatency.observe(micros);
+    portEXIT_CRITICAL(&lock);
+}
+
+void OtaMetrics::countRetry() {
+    portENTER_CRITICAL(&lock);
+    retries++;
+    portEXIT_CRITICAL(&lock);
+}
+
+void OtaMetrics::updateStarted() {
+    uint32_t heap = ESP.getFreeHeap();
+    portENTER_CRITICAL(&lock);
+    updating = true;
+    updates++;
+    minFreeHeap = heap;
+    portEXIT_CRITICAL(&lock);
+}
+
+/**
+ * @param success The image was written and verified
+ * @param len Bytes received for this image
+ * @param micros Duration of the whole download or upload
+ */
+void OtaMetrics::updateFinished(bool success, size_t len, uint32_t micros) {
+    portENTER_CRITICAL(&lock);
+    updating = false;
+    if (!success)
+        updateFailures++;
+    if (micros)
+        lastBytesPerSecond = (uint64_t)len * 1000000 / micros;
+    portEXIT_CRITICAL(&lock);
+}
+
+/**
+ * @brief Count a failed begin or end call
+ * @param stage The call that failed
+ * @param code Update.getError() or the esp_err_t of the partition writer
+ *
+ * Codes beyond the first OTAMETRICS_ERRORS distinct ones are counted per stage as code "other".
+ */
+void OtaMetrics::countError(OtaMetricsStage stage, int code) {
+    portENTER_CRITICAL(&lock);
+    uint8_t i = 0;
+    while (i < errorCount && !(errors[i].stage == stage && errors[i].code == code))
+        i++;
+    if (i < errorCount) {
+        errors[i].count++;
+    } else if (errorCount < OTAMETRICS_ERRORS) {
+        errors[i].stage = stage;
+        errors[i].code = code;
+        errors[i].count = 1;
+        errorCount++;
+    } else {
+        otherErrors[stage]++;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void OtaMetrics::sampleHeap() {
+    uint32_t heap = ESP.getFreeHeap();
+    portENTER_CRITICAL(&lock);
+    if (updating && heap < minFreeHeap)
+        minFreeHeap = heap;
+    portEXIT_CRITICAL(&lock);
+}
+
+/**
+ * @brief Write all metrics in the Prometheus text exposition format 0.0.4
+ * @param out Any Print, e.g. an AsyncResponseStream
+ *
+ * A snapshot is taken first so the output is consistent and the lock is not
+ * held while the (possibly slow) output is written.
+ */
+void OtaMetrics::print(Print &out) {
+    portENTER_CRITICAL(&lock);
+    OtaMetrics snapshot = *this;
+    portEXIT_CRITICAL(&lock);
+
+    out.printf("# HELP ota_manifest_checks_total Version checks against the update server.\n"
+               "# TYPE ota_manifest_checks_total counter\n"
+               "ota_manifest_checks_total %u\n",
+               (unsigned)snapshot.manifestChecks);
+    out.printf("# HELP ota_manifest_failures_total Version checks that failed.\n"
+               "# TYPE ota_manifest_failures_total counter\n"
+               "ota_manifest_failures_total %u\n",
+               (unsigned)snapshot.manifestFailures);
+    printHistogram(out, "ota_manifest_fetch_seconds", "Duration of a version check request.", snapshot.manifestLatency);
+    printHistogram(out, "ota_network_read_seconds", "Time waited for the data of one download chunk, without the wait for a free slot.", snapshot.readLatency);
+    printHistogram(out, "ota_pipeline_wait_seconds", "Time a download waited for the flash writer to free a slot.", snapshot.slotWait);
+    printHistogram(out, "ota_flash_write_seconds", "Duration of decoding and writing one download chunk to flash.", snapshot.writeLatency);
+
+    out.printf("# HELP ota_download_bytes_total Bytes received for updates.\n"
+               "# TYPE ota_download_bytes_total counter\n"
+               "ota_download_bytes_total %llu\n",
+               (unsigned long long)snapshot.bytes);
+    out.printf("# HELP ota_download_bytes_per_second Throughput of the last update.\n"
+               "# TYPE ota_download_bytes_per_second gauge\n"
+               "ota_download_bytes_per_second %u\n",
+               (unsigned)snapshot.lastBytesPerSecond);
+    out.printf("# HELP ota_download_retries_total Interrupted downloads that were resumed.\n"
+               "# TYPE ota_download_retries_total counter\n"
+               "ota_download_retries_total %u\n",
+               (unsigned)snapshot.retries);
+    out.printf("# HELP ota_updates_total Started updates.\n"
+               "# TYPE ota_updates_total counter\n"
+               "ota_updates_total %u\n",
+               (unsigned)snapshot.updates);
+    out.printf("# HELP ota_update_failures_total Updates that failed.\n"
+               "# TYPE ota_update_failures_total counter\n"
+               "ota_update_failures_total %u\n",
+               (unsigned)snapshot.updateFailures);
+
+    out.print("# HELP ota_update_errors_total Failed begin and end calls by error code.\n"
+              "# TYPE ota_update_errors_total counter\n");
+    for (uint8_t i = 0; i < snapshot.errorCount; i++)
+        out.printf("ota_update_errors_total{stage=\"%s\",code=\"%d\"} %u\n", snapshot.errors[i].stage == OTA_STAGE_BEGIN ? "begin" : "end",
+                   snapshot.errors[i].code, (unsigned)snapshot.errors[i].count);
+    for (uint8_t stage = 0; stage < 2; stage++)
+        if (snapshot.otherErrors[stage])
+            out.printf("ota_update_errors_total{stage=\"%s\",code=\"other\"} %u\n", stage == OTA_STAGE_BEGIN ? "begin" : "end", (unsigned)snapshot.otherErrors[stage]);
+
+    out.printf("# HELP ota_update_min_free_heap_bytes Lowest free heap during the current or last update.\n"
+               "# TYPE ota_update_min_free_heap_bytes gauge\n"
+               "ota_update_min_free_heap_bytes %u\n",
+               (unsigned)snapshot.minFreeHeap);
+}
+
+void OtaMetrics::printHistogram(Print &out, const char *name, const char *help, OtaHistogram &histogram) {
+    out.printf("# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+    uint32_t cumulative = 0;
+    for (uint8_t i = 0; i < OTAMETRICS_BUCKETS; i++) {
+        cumulative += histogram.buckets[i];
+        out.printf("%s_bucket{le=\"%g\"} %u\n", name, histogram.bounds[i] / 1e6, (unsigned)cumulative);
+    }
+    out.printf("%s_bucket{le=\"+Inf\"} %u\n", name, (unsigned)histogram.count);
+    out.printf("%s_sum %.6f\n", name, histogram.sumMicros / 1e6);
+    out.printf("%s_count %u\n", name, (unsigned)histogram.count);
+}
@@ -0,0 +1,116 @@
+/**
+ * @file otaMetrics.h
+ * @author Martin Verges <martin@verges.cc>
+ * @version 0.3
+ * @date 2025-01-06
+ *
+ * @copyright Copyright (c) 2022-2024 by the author alone
+ *
+ * License: CC BY-NC-SA 4.0
+ */
+
+#ifndef OTAMETRICS_h
+#define OTAMETRICS_h
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+
+// Upper bounds of the histogram buckets in microseconds, +Inf is implicit
+#define OTAMETRICS_BUCKETS 8
+
+// Distinct (stage, error code) pairs of failed writer calls that are tracked
+#define OTAMETRICS_ERRORS 8
+
+// Stage of a failed Update / partition writer call
+enum OtaMetricsStage {
+    OTA_STAGE_BEGIN = 0,
+    OTA_STAGE_END = 1,
+};
+
+/**
+ * A Prometheus style histogram with fixed bucket bounds.
+ */
+struct OtaHistogram {
+    const uint32_t *bounds;
+    uint32_t buckets[OTAMETRICS_BUCKETS + 1] = {0}; // not cumulative, the last one is +Inf
+    uint64_t sumMicros = 0;
+    uint32_t count = 0;
+
+    OtaHistogram(const uint32_t *bucketBounds) : bounds(bucketBounds) {}
+    void observe(uint32_t micros);
+};
+
+/**
+ * Counters and histograms of the OTA hot path, exported as text exposition format.
+ *
+ * Observations come from the download task and the flash writer task, so every
+ * update is done in a short critical section. Reading single 32 bit counters for
+ * /api/ota/esp needs no lock.
+ */
+class OtaMetrics {
+  public:
+    OtaMetrics();
+
+    // Duration of a version check request including the parsing
+    void observeManifest(uint32_t micros, bool success);
+
+    // Time the download waited for a chunk of data, from the previous chunk to
+    // the end of the socket read without the wait for a free slot, and its length
+    void observeRead(uint32_t micros, size_t bytes);
+
+    // Time the download waited for the writer task to free a slot
+    void observeSlotWait(uint32_t micros);
+
+    // Time the writer task spent on one slot (decode + flash)
+    void observeWrite(uint32_t micros);
+
+    // A download was resumed after an interruption
+    void countRetry();
+
+    // A download or upload started, resets the heap low-water mark
+    void updateStarted();
+
+    // A download or upload finished or was aborted, after updateStarted()
+    void updateFinished(bool success, size_t bytes, uint32_t micros);
+
+    // A begin or end call of the writer failed with the given code
+    void countError(OtaMetricsStage stage, int code);
+
+    // Track the lowest free heap while an update is running
+    void sampleHeap();
+
+    // Write all metrics in Prometheus text format
+    void print(Print &out);
+
+    // Simple counters, shared with /api/ota/esp
+    uint32_t manifestChecks = 0;
+    uint32_t manifestFailures = 0;
+    uint32_t updates = 0; // started ones
+    uint32_t updateFailures = 0;
+    uint32_t retries = 0;
+    uint64_t bytes = 0;
+    uint32_t lastBytesPerSecond = 0;
+    uint32_t minFreeHeap = 0; // during the current or last update, 0 if there was none
+
+  private:
+    void printHistogram(Print &out, const char *name, const char *help, OtaHistogram &histogram);
+
+    struct ErrorCount {
+        uint8_t stage;
+        int code;
+        uint32_t count;
+    };
+
+    OtaHistogram manifestLatency;
+    OtaHistogram readLatency;
+    OtaHistogram slotWait;
+    OtaHistogram writeLatency;
+    ErrorCount errors[OTAMETRICS_ERRORS];
+    uint8_t errorCount = 0;
+    uint32_t otherErrors[2] = {0}; // by stage, codes beyond the tracked ones
+    bool updating = false;
+
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+};
+
+#endif // OTAMETRICS_h
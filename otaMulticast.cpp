@@ -0,0 +1,601 @@
+/**
+ * OTA multicast distribution
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#include "otaMulticast.h"
+#include "otaPartitionWriter.h"
+
+#include <esp_ota_ops.h>
+#include <esp_random.h>
+#include <esp_timer.h>
+#include <string.h>
+
+#define OTAMULTICAST_MAGIC "OTM1"
+
+// Time the nodes get to erase their partition after the announcement
+#define OTAMULTICAST_ERASE_RATE (128 * 1024) // bytes per second
+
+// Time to collect the repair requests at the end of a round
+#define OTAMULTICAST_REPAIR_WAIT 1500 // ms
+
+// Blocks received between two NVS checkpoints of a node
+#define OTAMULTICAST_CHECKPOINT 64
+
+static uint32_t readLe32(const uint8_t *buf) {
+    return buf[0] | buf[1] << 8 | buf[2] << 16 | (uint32_t)buf[3] << 24;
+}
+
+static void writeLe32(uint8_t *buf, uint32_t value) {
+    buf[0] = value;
+    buf[1] = value >> 8;
+    buf[2] = value >> 16;
+    buf[3] = value >> 24;
+}
+
+static void writeHeader(uint8_t *buf, uint8_t type, uint32_t session, uint32_t argument) {
+    memcpy(buf, OTAMULTICAST_MAGIC, 4);
+    buf[4] = type;
+    buf[5] = buf[6] = buf[7] = 0;
+    writeLe32(buf + 8, session);
+    writeLe32(buf + 12, argument);
+}
+
+/**
+ * @brief Send an image to all nodes listening on the LAN
+ * @param partition The partition holding the image
+ * @param size Bytes of the image
+ * @param sha256Hex SHA-256 of the image, the nodes verify it
+ * @param signatureBase64 Signature of the SHA-256, empty if unsigned
+ * @return true if no node misses a block after the last round
+ *
+ * Runs in the calling task and takes about size / rate seconds, plus the time
+ * the nodes need to erase their partition.
+ */
+bool OtaMulticastSender::send(const esp_partition_t *partition, size_t size, const String &sha256Hex, const String &signatureBase64) {
+    error = "";
+    result = OtaMulticastStats();
+    if (!partition || !size || size > partition->size)
+        return fail("invalid image");
+    if (sha256Hex.length() != 64)
+        return fail("the image needs a sha256");
+    if (34 + signatureBase64.length() > OTAMULTICAST_BLOCK_SIZE)
+        return fail("signature is too long");
+
+    source = partition;
+    length = size;
+    result.session = esp_random();
+    result.blocks = (size + OTAMULTICAST_BLOCK_SIZE - 1) / OTAMULTICAST_BLOCK_SIZE;
+    packet = (uint8_t *)malloc(OTAMULTICAST_PACKET_SIZE);
+    parity = (uint8_t *)malloc(OTAMULTICAST_BLOCK_SIZE);
+    uint8_t *bitmap = (uint8_t *)calloc((result.blocks + 7) / 8, 1);
+    portENTER_CRITICAL(&missingLock);
+    missing = bitmap;
+    portEXIT_CRITICAL(&missingLock);
+    if (!packet || !parity || !bitmap)
+        return fail("out of memory");
+    if (!udp.listen(OTAMULTICAST_PORT + 1))
+        return fail("unable to open the socket");
+    udp.onPacket([this](AsyncUDPPacket &packet) { onPacket(packet); });
+
+    for (uint8_t i = 0; i < 3; i++) {
+        sendAnnouncement(sha256Hex, signatureBase64);
+        vTaskDelay(pdMS_TO_TICKS(200));
+    }
+    vTaskDelay(pdMS_TO_TICKS(1000 + (uint64_t)size * 1000 / OTAMULTICAST_ERASE_RATE));
+
+    // first round, every group of blocks is followed by its parity
+    uint64_t start = esp_timer_get_time();
+    uint64_t bytes = 0;
+    memset(parity, 0, OTAMULTICAST_BLOCK_SIZE);
+    for (uint32_t i = 0; i < result.blocks; i++) {
+        if (!sendBlock(i))
+            return fail("unable to read the image");
+        size_t len = i == result.blocks - 1 ? size - i * OTAMULTICAST_BLOCK_SIZE : OTAMULTICAST_BLOCK_SIZE;
+        for (size_t b = 0; b < len; b++)
+            parity[b] ^= packet[OTAMULTICAST_HEADER_SIZE + b];
+        bytes += OTAMULTICAST_PACKET_SIZE;
+        pace(start, bytes);
+
+        if (i % OTAMULTICAST_GROUP_SIZE == OTAMULTICAST_GROUP_SIZE - 1 || i == result.blocks - 1) {
+            sendPacket(OTA_MULTICAST_PARITY, i / OTAMULTICAST_GROUP_SIZE, parity, OTAMULTICAST_BLOCK_SIZE);
+            memset(parity, 0, OTAMULTICAST_BLOCK_SIZE);
+            bytes += OTAMULTICAST_PACKET_SIZE;
+            pace(start, bytes);
+        }
+    }
+
+    // repair rounds, only the blocks some node asked for
+    bool complete = false;
+    for (uint8_t round = 0; round <= repairRounds && !complete; round++) {
+        result.rounds = round + 1;
+
+        // announce again, nodes that joined late start with the next round
+        sendAnnouncement(sha256Hex, signatureBase64);
+        for (uint8_t i = 0; i < 3; i++) {
+            sendPacket(OTA_MULTICAST_END, round, NULL, 0);
+            vTaskDelay(pdMS_TO_TICKS(OTAMULTICAST_REPAIR_WAIT / 3));
+        }
+
+        complete = true;
+        start = esp_timer_get_time();
+        bytes = 0;
+        for (uint32_t i = 0; i < result.blocks; i++) {
+            uint8_t bit = 1 << (i % 8);
+            portENTER_CRITICAL(&missingLock);
+            bool wanted = missing[i / 8] & bit;
+            missing[i / 8] &= ~bit;
+            portEXIT_CRITICAL(&missingLock);
+            if (!wanted)
+                continue;
+            complete = false;
+            if (!sendBlock(i))
+                return fail("unable to read the image");
+            bytes += OTAMULTICAST_PACKET_SIZE;
+            pace(start, bytes);
+        }
+    }
+
+    // give the last nodes time to verify and report
+    vTaskDelay(pdMS_TO_TICKS(OTAMULTICAST_REPAIR_WAIT));
+    release();
+    if (!complete)
+        error = "nodes still miss blocks after the last round";
+    return complete;
+}
+
+/**
+ * @brief Announce the session: raw sha256, uint16 signature length, base64 signature
+ */
+void OtaMulticastSender::sendAnnouncement(const String &sha256Hex, const String &signatureBase64) {
+    uint8_t *payload = packet + OTAMULTICAST_HEADER_SIZE;
+    for (uint8_t i = 0; i < 32; i++) {
+        char hex[3] = {sha256Hex[i * 2], sha256Hex[i * 2 + 1], 0};
+        payload[i] = strtoul(hex, NULL, 16);
+    }
+    payload[32] = signatureBase64.length();
+    payload[33] = signatureBase64.length() >> 8;
+    memcpy(payload + 34, signatureBase64.c_str(), signatureBase64.length());
+    sendPacket(OTA_MULTICAST_ANNOUNCE, length, payload, 34 + signatureBase64.length());
+}
+
+/**
+ * @brief Send a packet to the multicast group
+ * @param payload Payload, may point into the packet buffer already
+ *
+ * A full lwIP buffer is retried shortly, a lost packet is repaired later.
+ */
+bool OtaMulticastSender::sendPacket(uint8_t type, uint32_t argument, const uint8_t *payload, size_t len) {
+    if (payload && len && payload != packet + OTAMULTICAST_HEADER_SIZE)
+        memcpy(packet + OTAMULTICAST_HEADER_SIZE, payload, len);
+    writeHeader(packet, type, result.session, argument);
+    for (uint8_t attempt = 0; attempt < 3; attempt++) {
+        if (udp.writeTo(packet, OTAMULTICAST_HEADER_SIZE + len, OTAMULTICAST_GROUP, OTAMULTICAST_PORT))
+            return true;
+        vTaskDelay(1);
+    }
+    return false;
+}
+
+/**
+ * @brief Read a block of the image and send it
+ * @return false on a flash read error
+ */
+bool OtaMulticastSender::sendBlock(uint32_t index) {
+    size_t offset = index * OTAMULTICAST_BLOCK_SIZE;
+    size_t len = length - offset < OTAMULTICAST_BLOCK_SIZE ? length - offset : OTAMULTICAST_BLOCK_SIZE;
+    if (esp_partition_read(source, offset, packet + OTAMULTICAST_HEADER_SIZE, len) != ESP_OK)
+        return false;
+    sendPacket(OTA_MULTICAST_DATA, index, packet + OTAMULTICAST_HEADER_SIZE, len);
+    result.sent++;
+    return true;
+}
+
+/**
+ * @brief Sleep until the data rate is back below the limit
+ */
+void OtaMulticastSender::pace(uint64_t start, uint64_t bytes) {
+    int64_t ahead = (int64_t)(start + bytes * 1000000 / rate) - esp_timer_get_time();
+    if (ahead >= portTICK_PERIOD_MS * 1000)
+        vTaskDelay(ahead / 1000 / portTICK_PERIOD_MS);
+}
+
+/**
+ * @brief Collect the repair requests and results of the nodes, runs in the UDP task
+ */
+void OtaMulticastSender::onPacket(AsyncUDPPacket &udpPacket) {
+    const uint8_t *data = udpPacket.data();
+    size_t len = udpPacket.length();
+    if (len < OTAMULTICAST_HEADER_SIZE || memcmp(data, OTAMULTICAST_MAGIC, 4) != 0 || readLe32(data + 8) != result.session)
+        return;
+
+    uint32_t argument = readLe32(data + 12);
+    if (data[4] == OTA_MULTICAST_NACK && argument % 8 == 0) {
+        size_t bitmapLen = (result.blocks + 7) / 8;
+        portENTER_CRITICAL(&missingLock);
+        for (size_t i = 0; missing && i < len - OTAMULTICAST_HEADER_SIZE && argument / 8 + i < bitmapLen; i++)
+            missing[argument / 8 + i] |= data[OTAMULTICAST_HEADER_SIZE + i];
+        portEXIT_CRITICAL(&missingLock);
+        result.nacks++;
+    } else if (data[4] == OTA_MULTICAST_DONE) {
+        if (argument == 0)
+            result.done++;
+        else
+            result.rejected++;
+    }
+}
+
+void OtaMulticastSender::release() {
+    udp.close();
+    portENTER_CRITICAL(&missingLock);
+    uint8_t *bitmap = missing;
+    missing = NULL;
+    portEXIT_CRITICAL(&missingLock);
+    free(bitmap);
+    free(packet);
+    free(parity);
+    packet = parity = NULL;
+}
+
+bool OtaMulticastSender::fail(const char *msg) {
+    release();
+    error = msg;
+    return false;
+}
+
+/**
+ * @brief Join the multicast group and wait for announcements
+ * @param nvs Namespace to keep the progress of a session in
+ * @param accept Decides if an announced image is installed
+ * @param wake Optional callback from the UDP task for each queued packet
+ * @param port Port of the group
+ * @return false if the buffers can not be allocated or the network is down
+ */
+bool OtaMulticastReceiver::begin(const char *nvs, AcceptCheck accept, Wake wake, uint16_t port) {
+#if OTAWEBUPDATER_USE_NVS == true
+    NVS = nvs;
+#endif
+    acceptCheck = accept;
+    wakeCallback = wake;
+    listenPort = port;
+    if (!queue)
+        queue = xQueueCreate(OTAMULTICAST_QUEUE_LENGTH, sizeof(Packet));
+    if (!incoming)
+        incoming = (Packet *)malloc(sizeof(Packet));
+    if (!work)
+        work = (Packet *)malloc(sizeof(Packet));
+    if (!block)
+        block = (uint8_t *)malloc(OTAMULTICAST_BLOCK_SIZE);
+    if (!queue || !incoming || !work || !block) {
+        error = "out of memory";
+        return false;
+    }
+
+    if (listening)
+        return true;
+    if (!udp.listenMulticast(OTAMULTICAST_GROUP, listenPort))
+        return false;
+    udp.onPacket([this](AsyncUDPPacket &packet) { onPacket(packet); });
+    listening = true;
+    return true;
+}
+
+/**
+ * @brief Leave the group, an unfinished session can be resumed after begin()
+ */
+void OtaMulticastReceiver::end() {
+    abort();
+    if (listening)
+        udp.close();
+    listening = false;
+    if (queue)
+        vQueueDelete(queue);
+    queue = NULL;
+    free(incoming);
+    free(work);
+    free(block);
+    incoming = work = NULL;
+    block = NULL;
+}
+
+/**
+ * @brief Queue a packet for poll(), runs in the UDP task
+ */
+void OtaMulticastReceiver::onPacket(AsyncUDPPacket &packet) {
+    size_t len = packet.length();
+    if (len < OTAMULTICAST_HEADER_SIZE || len > OTAMULTICAST_PACKET_SIZE || memcmp(packet.data(), OTAMULTICAST_MAGIC, 4) != 0)
+        return;
+    if (rejected && readLe32(packet.data() + 8) == rejected)
+        return; // a session we do not take part in
+
+    incoming->len = len;
+    incoming->from = (uint32_t)packet.remoteIP();
+    incoming->port = packet.remotePort();
+    memcpy(incoming->data, packet.data(), len);
+    if (xQueueSend(queue, incoming, 0) == pdTRUE && wakeCallback)
+        wakeCallback();
+}
+
+/**
+ * @brief Write the queued packets to the flash
+ * @param waitMs Time to wait for the first packet
+ * @param publicKeyPem Key to verify the signature of the image, NULL to accept unsigned ones
+ * @return OTA_MULTICAST_COMPLETE once the image is set as boot partition
+ */
+OtaMulticastState OtaMulticastReceiver::poll(uint32_t waitMs, const char *publicKeyPem) {
+    if (!queue || xQueueReceive(queue, work, pdMS_TO_TICKS(waitMs)) != pdTRUE)
+        return OTA_MULTICAST_IDLE;
+    do {
+        OtaMulticastState state = handle(*work, publicKeyPem);
+        if (state != OTA_MULTICAST_RECEIVING)
+            return state;
+    } while (xQueueReceive(queue, work, 0) == pdTRUE);
+    return OTA_MULTICAST_RECEIVING;
+}
+
+OtaMulticastState OtaMulticastReceiver::handle(Packet &pkt, const char *publicKeyPem) {
+    uint8_t type = pkt.data[4];
+    uint32_t id = readLe32(pkt.data + 8);
+    uint32_t argument = readLe32(pkt.data + 12);
+    const uint8_t *payload = pkt.data + OTAMULTICAST_HEADER_SIZE;
+    size_t len = pkt.len - OTAMULTICAST_HEADER_SIZE;
+
+    if (type == OTA_MULTICAST_ANNOUNCE && id != session && id != rejected && !announce(pkt, publicKeyPem))
+        return *error ? fail(error) : OTA_MULTICAST_RECEIVING;
+    if (!partition || id != session)
+        return OTA_MULTICAST_RECEIVING;
+
+    switch (type) {
+    case OTA_MULTICAST_DATA:
+        if (argument < blocks && len == blockLength(argument) && !hasBlock(argument) && !writeBlock(argument, payload))
+            return fail("unable to write the image");
+        break;
+    case OTA_MULTICAST_PARITY:
+        if (len == OTAMULTICAST_BLOCK_SIZE && !repairGroup(argument, payload))
+            return fail("unable to restore a block");
+        break;
+    case OTA_MULTICAST_END:
+        if (received < blocks && argument != repairRound) {
+            repairRound = argument;
+            requestRepair(pkt);
+        }
+        break;
+    }
+
+    if (received == blocks)
+        return finish(pkt, publicKeyPem);
+    return OTA_MULTICAST_RECEIVING;
+}
+
+/**
+ * @brief Start a new session, or resume it from NVS
+ * @param publicKeyPem Key the announced signature has to match, NULL to accept unsigned images
+ * @return false if the image is not wanted, error is set if it can not be received
+ *
+ * With a key, the signature is checked before anything is erased, so a forged
+ * announcement can neither wipe the partition nor end a running session.
+ */
+bool OtaMulticastReceiver::announce(const Packet &pkt, const char *publicKeyPem) {
+    const uint8_t *payload = pkt.data + OTAMULTICAST_HEADER_SIZE;
+    size_t len = pkt.len - OTAMULTICAST_HEADER_SIZE;
+    error = "";
+    size_t signatureLen = len < 34 ? 0 : payload[32] | payload[33] << 8;
+    if (len < 34 || 34 + signatureLen > len)
+        return false;
+
+    uint32_t id = readLe32(pkt.data + 8);
+    size_t imageSize = readLe32(pkt.data + 12);
+    String imageSha256 = OtaImageVerifier::toHex(payload);
+    String imageSignature = String((const char *)payload + 34, signatureLen);
+    if (publicKeyPem) {
+        OtaImageVerifier verifier;
+        if (!verifier.begin(imageSha256, imageSignature, publicKeyPem) || !verifier.checkSignature(payload)) {
+            rejected = id;
+            return false;
+        }
+    }
+    const esp_partition_t *target = esp_ota_get_next_update_partition(NULL);
+    if (!target || !imageSize || imageSize > target->size || (acceptCheck && !acceptCheck(imageSha256, imageSize))) {
+        rejected = id;
+        return false;
+    }
+
+    // a new image replaces an unfinished session
+    abort();
+    session = id;
+    size = imageSize;
+    blocks = (size + OTAMULTICAST_BLOCK_SIZE - 1) / OTAMULTICAST_BLOCK_SIZE;
+    sha256 = imageSha256;
+    signature = imageSignature;
+    received = unsaved = 0;
+    repairRound = UINT32_MAX;
+    bitmap = (uint8_t *)calloc((blocks + 7) / 8, 1);
+    if (!bitmap) {
+        error = "out of memory";
+        return false;
+    }
+    partition = target;
+
+#if OTAWEBUPDATER_USE_NVS == true
+    if (preferences.begin(NVS, true)) {
+        if (preferences.getUInt("mcSession", 0) == session && preferences.getBytesLength("mcBitmap") == (blocks + 7) / 8)
+            preferences.getBytes("mcBitmap", bitmap, (blocks + 7) / 8);
+        preferences.end();
+    }
+    for (uint32_t i = 0; i < blocks; i++)
+        if (hasBlock(i))
+            received++;
+    if (received)
+        return true;
+#endif
+
+    // packets arriving meanwhile are lost and requested again at the end of the round
+    size_t sector = OtaPartitionWriter::SECTOR_SIZE;
+    if (esp_partition_erase_range(partition, 0, (size + sector - 1) / sector * sector) != ESP_OK) {
+        partition = NULL;
+        error = "unable to erase the partition";
+        return false;
+    }
+    saveProgress();
+    return true;
+}
+
+/**
+ * @brief Write a block to the partition and mark it received
+ */
+bool OtaMulticastReceiver::writeBlock(uint32_t index, const uint8_t *data) {
+    if (esp_partition_write(partition, index * OTAMULTICAST_BLOCK_SIZE, data, blockLength(index)) != ESP_OK)
+        return false;
+    bitmap[index / 8] |= 1 << (index % 8);
+    received++;
+    if (++unsaved >= OTAMULTICAST_CHECKPOINT)
+        saveProgress();
+    return true;
+}
+
+/**
+ * @brief Restore the only missing block of a group from its parity
+ * @return false on a flash error
+ *
+ * The other blocks of the group are read back from the flash, a group with
+ * more than one missing block is left to the repair rounds.
+ */
+bool OtaMulticastReceiver::repairGroup(uint32_t group, const uint8_t *parity) {
+    uint32_t first = group * OTAMULTICAST_GROUP_SIZE;
+    if (first >= blocks)
+        return true;
+    uint32_t last = first + OTAMULTICAST_GROUP_SIZE < blocks ? first + OTAMULTICAST_GROUP_SIZE : blocks;
+    uint32_t lost = 0;
+    uint8_t lostCount = 0;
+    for (uint32_t i = first; i < last; i++) {
+        if (!hasBlock(i)) {
+            lost = i;
+            lostCount++;
+        }
+    }
+    if (lostCount != 1)
+        return true;
+
+    uint8_t chunk[64];
+    memcpy(block, parity, OTAMULTICAST_BLOCK_SIZE);
+    for (uint32_t i = first; i < last; i++) {
+        if (i == lost)
+            continue;
+        size_t len = blockLength(i);
+        for (size_t pos = 0; pos < len; pos += sizeof(chunk)) {
+            size_t take = len - pos < sizeof(chunk) ? len - pos : sizeof(chunk);
+            if (esp_partition_read(partition, i * OTAMULTICAST_BLOCK_SIZE + pos, chunk, take) != ESP_OK)
+                return false;
+            for (size_t b = 0; b < take; b++)
+                block[pos + b] ^= chunk[b];
+        }
+    }
+    return writeBlock(lost, block);
+}
+
+/**
+ * @brief Report the missing blocks to the sender
+ *
+ * The bitmap is sent in packets of up to OTAMULTICAST_BLOCK_SIZE bytes, each
+ * starting at a multiple of 8 blocks. A random delay spreads the answers of
+ * many nodes.
+ */
+void OtaMulticastReceiver::requestRepair(const Packet &pkt) {
+    saveProgress();
+    vTaskDelay(pdMS_TO_TICKS(esp_random() % 100));
+    size_t bitmapLen = (blocks + 7) / 8;
+    for (size_t start = 0; start < bitmapLen; start += OTAMULTICAST_BLOCK_SIZE) {
+        size_t len = bitmapLen - start < OTAMULTICAST_BLOCK_SIZE ? bitmapLen - start : OTAMULTICAST_BLOCK_SIZE;
+        bool any = false;
+        for (size_t i = 0; i < len; i++) {
+            block[i] = ~bitmap[start + i];
+            if (start + i == bitmapLen - 1 && blocks % 8)
+                block[i] &= (1 << (blocks % 8)) - 1;
+            any |= block[i] != 0;
+        }
+        if (any)
+            reply(pkt, OTA_MULTICAST_NACK, start * 8, block, len);
+    }
+}
+
+/**
+ * @brief Verify the complete image and make it bootable
+ */
+OtaMulticastState OtaMulticastReceiver::finish(const Packet &pkt, const char *publicKeyPem) {
+    OtaImageVerifier verifier;
+    if (!verifier.begin(sha256, signature, publicKeyPem) || !verifier.updateFromPartition(partition, size) || !verifier.finish()) {
+        reply(pkt, OTA_MULTICAST_DONE, 1, NULL, 0);
+        return fail(verifier.errorString());
+    }
+    if (esp_ota_set_boot_partition(partition) != ESP_OK) {
+        reply(pkt, OTA_MULTICAST_DONE, 1, NULL, 0);
+        return fail("image is not bootable");
+    }
+    reply(pkt, OTA_MULTICAST_DONE, 0, NULL, 0);
+    clearProgress();
+    free(bitmap);
+    bitmap = NULL;
+    partition = NULL;
+    return OTA_MULTICAST_COMPLETE;
+}
+
+/**
+ * @brief Send a packet back to the sender of pkt
+ */
+void OtaMulticastReceiver::reply(const Packet &pkt, uint8_t type, uint32_t argument, const uint8_t *payload, size_t len) {
+    uint8_t out[OTAMULTICAST_PACKET_SIZE];
+    writeHeader(out, type, session, argument);
+    if (len)
+        memcpy(out + OTAMULTICAST_HEADER_SIZE, payload, len);
+    udp.writeTo(out, OTAMULTICAST_HEADER_SIZE + len, IPAddress(pkt.from), pkt.port);
+}
+
+/**
+ * @brief Stop receiving, the progress stays in NVS for a resume
+ */
+void OtaMulticastReceiver::abort() {
+    if (partition)
+        saveProgress();
+    free(bitmap);
+    bitmap = NULL;
+    partition = NULL;
+    session = 0;
+}
+
+void OtaMulticastReceiver::saveProgress() {
+    unsaved = 0;
+#if OTAWEBUPDATER_USE_NVS == true
+    if (preferences.begin(NVS, false)) {
+        preferences.putUInt("mcSession", session);
+        preferences.putBytes("mcBitmap", bitmap, (blocks + 7) / 8);
+        preferences.end();
+    }
+#endif
+}
+
+void OtaMulticastReceiver::clearProgress() {
+#if OTAWEBUPDATER_USE_NVS == true
+    if (preferences.begin(NVS, false)) {
+        preferences.remove("mcSession");
+        preferences.remove("mcBitmap");
+        preferences.end();
+    }
+#endif
+}
+
+size_t OtaMulticastReceiver::blockLength(uint32_t index) {
+    return index == blocks - 1 ? size - index * OTAMULTICAST_BLOCK_SIZE : OTAMULTICAST_BLOCK_SIZE;
+}
+
+OtaMulticastState OtaMulticastReceiver::fail(const char *msg) {
+    error = msg;
+    clearProgress();
+    free(bitmap);
+    bitmap = NULL;
+    partition = NULL;
+    rejected = session;
+    return OTA_MULTICAST_FAILED;
+}
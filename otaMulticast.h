@@ -0,0 +1,225 @@
+/**
+ * @file otaMulticast.h
+ * @author Martin Verges <martin@verges.cc>
+ * @version 0.3
+ * @date 2025-01-06
+ *
+ * @copyright Copyright (c) 2022-2024 by the author alone
+ *
+ * License: CC BY-NC-SA 4.0
+ */
+
+#ifndef OTAMULTICAST_h
+#define OTAMULTICAST_h
+
+#include "otaImageVerifier.h"
+
+#include <Arduino.h>
+#include <AsyncUDP.h>
+#include <esp_partition.h>
+#include <functional>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+#ifndef OTAWEBUPDATER_USE_NVS
+#define OTAWEBUPDATER_USE_NVS true
+#endif
+#if OTAWEBUPDATER_USE_NVS == true
+#include <Preferences.h>
+#endif
+
+// Group and port the images are sent to, repairs are requested from OTAMULTICAST_PORT + 1
+#define OTAMULTICAST_GROUP IPAddress(239, 255, 32, 32)
+#define OTAMULTICAST_PORT 3232
+
+#define OTAMULTICAST_BLOCK_SIZE 1024 // payload of a data packet, fits into one frame
+#define OTAMULTICAST_GROUP_SIZE 16   // data packets protected by one parity packet
+#define OTAMULTICAST_HEADER_SIZE 16
+#define OTAMULTICAST_PACKET_SIZE (OTAMULTICAST_HEADER_SIZE + OTAMULTICAST_BLOCK_SIZE)
+
+// Packets buffered between the UDP task and the flash writes
+#define OTAMULTICAST_QUEUE_LENGTH 16
+
+// Kind of a packet, byte 4 of the header
+enum OtaMulticastType {
+    OTA_MULTICAST_ANNOUNCE = 1, // image size, sha256 and signature of a session
+    OTA_MULTICAST_DATA = 2,     // one block of the image
+    OTA_MULTICAST_PARITY = 3,   // XOR of the blocks of a group
+    OTA_MULTICAST_END = 4,      // end of a round, nodes answer with a NACK
+    OTA_MULTICAST_NACK = 5,     // node to sender: bitmap of the missing blocks
+    OTA_MULTICAST_DONE = 6,     // node to sender: image verified or rejected
+};
+
+// Result of OtaMulticastReceiver::poll()
+enum OtaMulticastState {
+    OTA_MULTICAST_IDLE,      // nothing received within the wait time
+    OTA_MULTICAST_RECEIVING, // packets of a session were processed
+    OTA_MULTICAST_COMPLETE,  // the image is verified and set as boot partition
+    OTA_MULTICAST_FAILED,    // the session was aborted, see errorString()
+};
+
+// Statistics of the last OtaMulticastSender::send()
+struct OtaMulticastStats {
+    uint32_t session = 0;
+    uint32_t blocks = 0;   // blocks of the image
+    uint32_t sent = 0;     // data packets sent, including repairs
+    uint8_t rounds = 0;    // the first transmission plus the repair rounds
+    uint32_t nacks = 0;    // repair requests received
+    uint32_t done = 0;     // nodes that installed the image
+    uint32_t rejected = 0; // nodes that failed to verify it
+};
+
+/**
+ * Sends an image from a partition to all nodes of the LAN at once.
+ *
+ * Each packet is sent once for all nodes, so the airtime does not grow with
+ * the number of nodes. Every group of blocks is followed by a parity packet,
+ * which lets a node restore a single lost block of the group. At the end of
+ * each round the nodes report the blocks still missing, only those are sent
+ * again in the next round.
+ *
+ * Packet layout (little endian): "OTM1", uint8 type, uint8 reserved[3],
+ * uint32 session, uint32 argument, then the payload.
+ */
+class OtaMulticastSender {
+  public:
+    // Limit the data rate, the default leaves room for other traffic
+    void setRate(uint32_t bytesPerSecond) { rate = bytesPerSecond; }
+
+    // Give up after this many repair rounds
+    void setRepairRounds(uint8_t rounds) { repairRounds = rounds; }
+
+    // Send size bytes of the partition, blocks until all nodes are served or the rounds are used up
+    bool send(const esp_partition_t *partition, size_t size, const String &sha256Hex, const String &signatureBase64);
+
+    // Statistics of the last or the running transmission
+    const OtaMulticastStats &stats() { return result; }
+
+    // Description of the last error
+    const char *errorString() { return error; }
+
+  private:
+    void sendAnnouncement(const String &sha256Hex, const String &signatureBase64);
+    bool sendPacket(uint8_t type, uint32_t argument, const uint8_t *payload, size_t len);
+    bool sendBlock(uint32_t index);
+    void pace(uint64_t start, uint64_t bytes);
+    void onPacket(AsyncUDPPacket &packet);
+    void release();
+    bool fail(const char *msg);
+
+    AsyncUDP udp;
+    const esp_partition_t *source = NULL;
+    size_t length = 0;
+    uint32_t rate = 200 * 1024;
+    uint8_t repairRounds = 10;
+    uint8_t *packet = NULL; // OTAMULTICAST_PACKET_SIZE, allocated while sending
+    uint8_t *parity = NULL; // OTAMULTICAST_BLOCK_SIZE
+    uint8_t *missing = NULL; // blocks requested by any node
+    portMUX_TYPE missingLock = portMUX_INITIALIZER_UNLOCKED;
+    OtaMulticastStats result;
+    const char *error = "";
+};
+
+/**
+ * Receives a multicast image into the next update partition.
+ *
+ * The UDP task only copies packets into a queue, poll() writes the blocks from
+ * the calling task in any order. The bitmap of the received blocks is kept in
+ * NVS, so a node that restarts resumes the session where it stopped. The
+ * complete image is verified against the announced sha256 and signature
+ * before it is set as boot partition. With a key, an announcement is only
+ * accepted if its signature is valid.
+ */
+class OtaMulticastReceiver {
+  public:
+    // Decide if the announced image should be installed
+    typedef std::function<bool(const String &sha256Hex, size_t size)> AcceptCheck;
+    // Called from the UDP task when a packet was queued
+    typedef std::function<void()> Wake;
+
+    virtual ~OtaMulticastReceiver() { end(); }
+
+    // Join the multicast group, retry once the network is up
+    bool begin(const char *nvs, AcceptCheck accept, Wake wake = NULL, uint16_t port = OTAMULTICAST_PORT);
+
+    // Leave the group and free the buffers
+    void end();
+
+    // Is the group joined
+    bool isListening() { return listening; }
+
+    // Is an image being received
+    bool isActive() { return partition != NULL; }
+
+    // Are packets waiting for poll()
+    bool available() { return queue && uxQueueMessagesWaiting(queue); }
+
+    // Process the queued packets, waits up to waitMs for the first one
+    OtaMulticastState poll(uint32_t waitMs, const char *publicKeyPem = NULL);
+
+    // Abort the current session, the received blocks are kept for a resume
+    void abort();
+
+    // Progress of the current session
+    uint32_t receivedBlocks() { return received; }
+    uint32_t totalBlocks() { return blocks; }
+
+    // Hex SHA-256 of the announced image
+    const String &imageSha256() { return sha256; }
+
+    // Description of the last error
+    const char *errorString() { return error; }
+
+  private:
+    struct Packet {
+        uint16_t len;
+        uint32_t from; // IPv4 address and port of the sender
+        uint16_t port;
+        uint8_t data[OTAMULTICAST_PACKET_SIZE];
+    };
+
+    void onPacket(AsyncUDPPacket &packet);
+    OtaMulticastState handle(Packet &pkt, const char *publicKeyPem);
+    bool announce(const Packet &pkt, const char *publicKeyPem);
+    bool writeBlock(uint32_t index, const uint8_t *data);
+    bool repairGroup(uint32_t group, const uint8_t *parity);
+    void requestRepair(const Packet &pkt);
+    OtaMulticastState finish(const Packet &pkt, const char *publicKeyPem);
+    void reply(const Packet &pkt, uint8_t type, uint32_t argument, const uint8_t *payload, size_t len);
+    void saveProgress();
+    void clearProgress();
+    size_t blockLength(uint32_t index);
+    bool hasBlock(uint32_t index) { return bitmap[index / 8] & (1 << (index % 8)); }
+    OtaMulticastState fail(const char *msg);
+
+    AsyncUDP udp;
+    AcceptCheck acceptCheck = NULL;
+    Wake wakeCallback = NULL;
+    QueueHandle_t queue = NULL;
+    Packet *incoming = NULL; // filled by the UDP task
+    Packet *work = NULL;     // the packet processed by poll()
+    uint16_t listenPort = OTAMULTICAST_PORT;
+    volatile bool listening = false;
+
+    const esp_partition_t *partition = NULL;
+    uint32_t session = 0;
+    volatile uint32_t rejected = 0; // session that is ignored
+    uint32_t repairRound = 0;       // last round answered with a NACK
+    size_t size = 0;
+    uint32_t blocks = 0;
+    uint32_t received = 0;
+    uint32_t unsaved = 0; // blocks received since the last NVS checkpoint
+    uint8_t *bitmap = NULL;
+    String sha256 = "";
+    String signature = "";
+    uint8_t *block = NULL; // OTAMULTICAST_BLOCK_SIZE, to restore a block from its group
+    const char *error = "";
+
+#if OTAWEBUPDATER_USE_NVS == true
+    Preferences preferences;
+    const char *NVS = NULL;
+#endif
+};
+
+#endif // OTAMULTICAST_h
@@ -0,0 +1,95 @@
+/**
+ * OTA background partition eraser
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#include "otaPartitionEraser.h"
+#include "otaPartitionWriter.h"
+
+/**
+ * @brief Start erasing the partition in the background
+ * @param partition The partition, must not be in use
+ * @param size Bytes from the partition start, rounded up to whole sectors
+ * @param done Optional callback once everything is erased
+ * @return false if the task could not be started
+ */
+bool OtaPartitionEraser::begin(const esp_partition_t *partition, size_t size, Done done) {
+    cancel();
+    if (!partition || !size)
+        return false;
+    if (!finished)
+        finished = xSemaphoreCreateBinary();
+    if (!finished)
+        return false;
+    xSemaphoreTake(finished, 0); // left over from a task nobody waited for
+
+    size_t sector = OtaPartitionWriter::SECTOR_SIZE;
+    target = partition;
+    length = (size + sector - 1) / sector * sector;
+    if (length > partition->size)
+        length = partition->size;
+    erased = 0;
+    stop = false;
+    doneCallback = done;
+    running = true;
+
+    // idle priority on core 0, the same as the OtaWebUpdater task
+    if (xTaskCreatePinnedToCore(eraseTask, "OtaErase", 2048, this, tskIDLE_PRIORITY, NULL, 0) != pdPASS) {
+        running = false;
+        target = NULL;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Stop a running erase and forget the erased range
+ */
+void OtaPartitionEraser::cancel() {
+    if (running) {
+        stop = true;
+        xSemaphoreTake(finished, portMAX_DELAY);
+    }
+    target = NULL;
+    erased = length = 0;
+}
+
+/**
+ * @brief Hand the erased range over to a writer
+ * @param partition The partition the writer is about to write
+ * @return Erased bytes from the partition start, 0 if it was not prepared
+ *
+ * Writing makes the erased state stale, so the range can only be taken once.
+ */
+size_t OtaPartitionEraser::take(const esp_partition_t *partition) {
+    if (running) {
+        stop = true;
+        xSemaphoreTake(finished, portMAX_DELAY);
+    }
+    size_t bytes = partition && target && partition->address == target->address ? erased : 0;
+    cancel();
+    return bytes;
+}
+
+/**
+ * @brief Erase sector by sector until done or stopped
+ * @param param The OtaPartitionEraser instance
+ */
+void OtaPartitionEraser::eraseTask(void *param) {
+    OtaPartitionEraser *eraser = (OtaPartitionEraser *)param;
+    while (!eraser->stop && eraser->erased < eraser->length) {
+        if (esp_partition_erase_range(eraser->target, eraser->erased, OtaPartitionWriter::SECTOR_SIZE) != ESP_OK)
+            break;
+        eraser->erased += OtaPartitionWriter::SECTOR_SIZE;
+        vTaskDelay(1); // leave the flash and the core to everyone else
+    }
+    if (!eraser->stop && eraser->erased == eraser->length && eraser->doneCallback)
+        eraser->doneCallback();
+
+    eraser->running = false;
+    xSemaphoreGive(eraser->finished);
+    vTaskDelete(NULL);
+}
@@ -0,0 +1,68 @@
+/**
+ * @file otaPartitionEraser.h
+ * @author Martin Verges <martin@verges.cc>
+ * @version 0.3
+ * @date 2025-01-06
+ *
+ * @copyright Copyright (c) 2022-2024 by the author alone
+ *
+ * License: CC BY-NC-SA 4.0
+ */
+
+#ifndef OTAPARTITIONERASER_h
+#define OTAPARTITIONERASER_h
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <functional>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+/**
+ * Erases the start of a partition in the background, before an update starts.
+ *
+ * A task at idle priority on core 0 erases one sector at a time and yields in
+ * between, so it only uses otherwise idle time and keeps every flash operation
+ * short. The erased range is handed to OtaPartitionWriter::setErased() through
+ * take(), which also stops the task, the download then only writes.
+ */
+class OtaPartitionEraser {
+  public:
+    // Called from the erase task once the range is erased
+    typedef std::function<void()> Done;
+
+    OtaPartitionEraser() {}
+    virtual ~OtaPartitionEraser() { cancel(); }
+
+    // Start erasing size bytes from the partition start
+    bool begin(const esp_partition_t *partition, size_t size, Done done = NULL);
+
+    // Stop the task and forget the erased range
+    void cancel();
+
+    // Stop the task and return the erased bytes of the partition, the range is forgotten
+    size_t take(const esp_partition_t *partition);
+
+    // Is the erase task running
+    bool isRunning() { return running; }
+
+    // Has the task ended, after erasing everything or on a flash error
+    bool isFinished() { return target && !running; }
+
+    // Bytes erased so far
+    size_t erasedBytes() { return erased; }
+
+  private:
+    static void eraseTask(void *param);
+
+    const esp_partition_t *target = NULL;
+    size_t length = 0;
+    volatile size_t erased = 0;
+    volatile bool running = false;
+    volatile bool stop = false;
+    Done doneCallback = NULL;
+    SemaphoreHandle_t finished = NULL;
+};
+
+#endif // OTAPARTITIONERASER_h
@@ -0,0 +1,159 @@
+/**
+ * OTA partition writer
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#include "otaPartitionWriter.h"
+
+#include <esp_image_format.h>
+#include <esp_ota_ops.h>
+
+/**
+ * @brief Open the target partition
+ * @param command U_FLASH for the next app partition, U_SPIFFS for the filesystem
+ * @param offset Where to continue writing, rounded down to the sector start
+ * @return true if the partition was found and the offset is valid
+ */
+bool OtaPartitionWriter::begin(int command, size_t offset) {
+    abort();
+    app = command != U_SPIFFS;
+    if (app)
+        target = esp_ota_get_next_update_partition(NULL);
+    else
+        target = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, NULL);
+
+    if (!target) {
+        error = ESP_ERR_NOT_FOUND;
+        return false;
+    }
+
+    offset -= offset % SECTOR_SIZE;
+    if (offset >= target->size) {
+        error = ESP_ERR_INVALID_SIZE;
+        return false;
+    }
+
+    buffer = (uint8_t *)malloc(SECTOR_SIZE);
+    if (!buffer) {
+        error = ESP_ERR_NO_MEM;
+        return false;
+    }
+
+    position = flushedUntil = offset;
+    erasedUntil = offset ? offset : preErased - preErased % SECTOR_SIZE;
+    preErased = 0;
+    bufLen = 0;
+    error = ESP_OK;
+    active = true;
+    return true;
+}
+
+/**
+ * @brief Append data at the current offset
+ * @param data Bytes to write
+ * @param len Number of bytes
+ * @return false if the data does not fit or the flash reported an error
+ */
+bool OtaPartitionWriter::write(const uint8_t *data, size_t len) {
+    if (!active)
+        return false;
+    if (position + len > target->size) {
+        error = ESP_ERR_INVALID_SIZE;
+        return false;
+    }
+    if (app && position == 0 && len && data[0] != ESP_IMAGE_HEADER_MAGIC) {
+        error = ESP_ERR_OTA_VALIDATE_FAILED;
+        return false;
+    }
+
+    while (len) {
+        size_t take = SECTOR_SIZE - bufLen < len ? SECTOR_SIZE - bufLen : len;
+        memcpy(buffer + bufLen, data, take);
+        bufLen += take;
+        data += take;
+        len -= take;
+        position += take;
+        if (bufLen == SECTOR_SIZE && !flush())
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Write the buffered sector, erasing ahead if needed
+ * @return false if the flash reported an error
+ */
+bool OtaPartitionWriter::flush() {
+    if (!bufLen)
+        return true;
+    size_t start = position - bufLen;
+    if (start + bufLen > erasedUntil) {
+        size_t eraseEnd = (erasedUntil / eraseAhead + 1) * eraseAhead;
+        if (eraseEnd > target->size)
+            eraseEnd = target->size;
+        error = esp_partition_erase_range(target, erasedUntil, eraseEnd - erasedUntil);
+        if (error != ESP_OK)
+            return false;
+        erasedUntil = eraseEnd;
+    }
+
+    error = esp_partition_write(target, start, buffer, bufLen);
+    if (error != ESP_OK)
+        return false;
+    flushedUntil = start + bufLen;
+    bufLen = 0;
+    return true;
+}
+
+/**
+ * @brief Stop writing and release the sector buffer
+ */
+void OtaPartitionWriter::abort() {
+    active = false;
+    free(buffer);
+    buffer = NULL;
+    bufLen = 0;
+}
+
+/**
+ * @brief Finish writing the partition
+ * @param activate Select the app image for the next boot
+ * @return true if the data was accepted
+ *
+ * For app partitions the image is verified by esp_ota_set_boot_partition()
+ * (header, segment checksums and the appended SHA-256) before it becomes the
+ * boot partition. Without activation it is verified the same way and can be
+ * selected later with activate().
+ */
+bool OtaPartitionWriter::end(bool activate) {
+    if (!active)
+        return false;
+    bool flushed = flush();
+    abort();
+    if (!flushed)
+        return false;
+
+    if (!app)
+        return true;
+    if (activate)
+        return this->activate();
+
+    esp_partition_pos_t pos = {target->address, target->size};
+    esp_image_metadata_t data;
+    error = esp_image_verify(ESP_IMAGE_VERIFY, &pos, &data);
+    return error == ESP_OK;
+}
+
+/**
+ * @brief Make the written app image the boot partition
+ * @return true if the image is valid and was selected
+ */
+bool OtaPartitionWriter::activate() {
+    if (!app || !target)
+        return false;
+    error = esp_ota_set_boot_partition(target);
+    return error == ESP_OK;
+}
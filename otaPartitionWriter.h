@@ -0,0 +1,95 @@
+/**
+ * @file otaPartitionWriter.h
+ * @author Martin Verges <martin@verges.cc>
+ * @version 0.3
+ * @date 2025-01-06
+ *
+ * @copyright Copyright (c) 2022-2024 by the author alone
+ *
+ * License: CC BY-NC-SA 4.0
+ */
+
+#ifndef OTAPARTITIONWRITER_h
+#define OTAPARTITIONWRITER_h
+
+#include <Arduino.h>
+#include <Update.h> // U_FLASH, U_SPIFFS
+#include <esp_err.h>
+#include <esp_partition.h>
+
+/**
+ * Sequential writer into the inactive app or the spiffs/littlefs partition.
+ *
+ * Unlike Update, writing can start at any sector aligned offset, which allows
+ * an interrupted download to continue where the last checkpoint was taken.
+ * An app image is only made bootable in end(), after the bootloader checks passed.
+ *
+ * Writes of any size are collected into a sector buffer, the flash only sees
+ * whole, aligned sectors (and the rest in end()). Sectors are erased right
+ * before they are written for the first time, or eraseAhead bytes at once, which
+ * lets the flash driver use its faster 64 KB block erase.
+ */
+class OtaPartitionWriter {
+  public:
+    static const size_t SECTOR_SIZE = 4096;
+    static const size_t BLOCK_SIZE = 64 * 1024;
+
+    OtaPartitionWriter() {}
+    virtual ~OtaPartitionWriter() { abort(); }
+
+    // Open the target partition for U_FLASH or U_SPIFFS at a sector aligned offset
+    bool begin(int command, size_t offset = 0);
+
+    // Append data at the current offset
+    bool write(const uint8_t *data, size_t len);
+
+    // Finish writing, verify an app image and select it for the next boot unless activate is false
+    bool end(bool activate = true);
+
+    // Select a verified app image written before for the next boot
+    bool activate();
+
+    // Stop writing, buffered data is dropped and the partition content stays as it is
+    void abort();
+
+    // The first bytes of the partition are erased already, used by the next begin() at offset 0
+    void setErased(size_t bytes) { preErased = bytes; }
+
+    // Erase this many bytes (a multiple of SECTOR_SIZE) in one go, set before begin()
+    void setEraseAhead(size_t bytes) { eraseAhead = bytes < SECTOR_SIZE ? SECTOR_SIZE : bytes - bytes % SECTOR_SIZE; }
+
+    // Bytes accepted so far, the last ones may still be in the sector buffer
+    size_t offset() { return position; }
+
+    // Bytes written to the flash, a sector aligned point to resume from
+    size_t flushed() { return flushedUntil; }
+
+    // Is the writer open
+    bool isActive() { return active; }
+
+    // The partition written to
+    const esp_partition_t *partition() { return target; }
+
+    // Last error
+    esp_err_t lastError() { return error; }
+    const char *errorString() { return esp_err_to_name(error); }
+
+  private:
+    bool flush();
+
+    const esp_partition_t *target = NULL;
+    bool app = true;
+    bool active = false;
+    volatile size_t position = 0;
+    volatile size_t flushedUntil = 0; // advanced after esp_partition_write() succeeded
+    size_t erasedUntil = 0;
+    size_t preErased = 0;
+    size_t eraseAhead = SECTOR_SIZE;
+    esp_err_t error = ESP_OK;
+
+    // the sector at position - bufLen, allocated in begin()
+    uint8_t *buffer = NULL;
+    size_t bufLen = 0;
+};
+
+#endif // OTAPARTITIONWRITER_h
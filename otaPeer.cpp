@@ -0,0 +1,70 @@
+/**
+ * OTA peer discovery
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#include "otaPeer.h"
+
+#include <ESPmDNS.h>
+#include <WiFi.h>
+#include <esp_random.h>
+#include <mdns.h>
+
+/**
+ * @brief Announce the running image on the LAN
+ * @param port Port of the webserver
+ * @param path Path of the peer endpoint, without the filename
+ * @param sha256 Hex SHA-256 of the running image
+ * @return false if mDNS is not running
+ */
+bool OtaPeerDiscovery::advertise(uint16_t port, const String &path, const String &sha256) {
+    if (!MDNS.addService(OTAPEER_SERVICE, "tcp", port))
+        return false;
+    MDNS.addServiceTxt(OTAPEER_SERVICE, "tcp", "path", path);
+    MDNS.addServiceTxt(OTAPEER_SERVICE, "tcp", "sha256", sha256);
+    advertised = true;
+    return true;
+}
+
+/**
+ * @brief Stop announcing this device
+ */
+void OtaPeerDiscovery::withdraw() {
+    if (advertised)
+        mdns_service_remove("_" OTAPEER_SERVICE, "_tcp");
+    advertised = false;
+}
+
+/**
+ * @brief Look up peers that serve an image
+ * @param sha256 Hex SHA-256 the image must have
+ * @param baseUrls Receives up to max urls like http://10.0.0.7:80/api/ota/peer
+ * @param max Size of baseUrls
+ * @return Number of peers found
+ *
+ * The order is shuffled, so a site does not pull from the first peer only.
+ * Blocks for the mDNS query timeout.
+ */
+uint8_t OtaPeerDiscovery::find(const String &sha256, String *baseUrls, uint8_t max) {
+    int results = MDNS.queryService(OTAPEER_SERVICE, "tcp");
+    uint8_t found = 0;
+    for (int i = 0; i < results && found < max; i++) {
+        if (!sha256.equalsIgnoreCase(MDNS.txt(i, "sha256")))
+            continue;
+        IPAddress ip = MDNS.IP(i);
+        if (ip == WiFi.localIP())
+            continue;
+        baseUrls[found++] = "http://" + ip.toString() + ":" + String(MDNS.port(i)) + MDNS.txt(i, "path");
+    }
+
+    for (uint8_t i = found; i > 1; i--) {
+        uint8_t j = esp_random() % i;
+        String swap = baseUrls[i - 1];
+        baseUrls[i - 1] = baseUrls[j];
+        baseUrls[j] = swap;
+    }
+    return found;
+}
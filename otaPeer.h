@@ -0,0 +1,53 @@
+/**
+ * @file otaPeer.h
+ * @author Martin Verges <martin@verges.cc>
+ * @version 0.3
+ * @date 2025-01-06
+ *
+ * @copyright Copyright (c) 2022-2024 by the author alone
+ *
+ * License: CC BY-NC-SA 4.0
+ */
+
+#ifndef OTAPEER_h
+#define OTAPEER_h
+
+#include <Arduino.h>
+
+// mDNS service of devices serving their firmware, "_otapeer._tcp"
+#define OTAPEER_SERVICE "otapeer"
+
+// Peers collected by a single lookup
+#define OTAPEER_MAX_PEERS 8
+
+// Downloads a device serves at the same time, others get a 503
+#define OTAPEER_MAX_TRANSFERS 2
+
+/**
+ * Finds devices on the LAN that serve a firmware image, and announces this one.
+ *
+ * A device announces the SHA-256 of its running image and the path to download
+ * it in the TXT records. Peers only trust the announcement to pick a source, the
+ * downloaded image is still verified against the hash of the manifest.
+ *
+ * MDNS.begin() has to be called by the application.
+ */
+class OtaPeerDiscovery {
+  public:
+    // Announce the running image, served at http://<ip>:<port><path>/firmware.bin
+    bool advertise(uint16_t port, const String &path, const String &sha256);
+
+    // Remove the announcement
+    void withdraw();
+
+    // Is this device announced
+    bool isAdvertised() { return advertised; }
+
+    // Find peers serving the image with this hash, returns their base urls in random order
+    uint8_t find(const String &sha256, String *baseUrls, uint8_t max);
+
+  private:
+    bool advertised = false;
+};
+
+#endif // OTAPEER_h
@@ -0,0 +1,216 @@
+/**
+ * OTA download pipeline
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#include "otaPipeline.h"
+
+#include <new> // std::nothrow
+
+OtaPipeline::OtaPipeline() {}
+
+OtaPipeline::~OtaPipeline() {
+    abort();
+}
+
+/**
+ * @brief Allocate the slots and start the writer task
+ * @param output Called from the writer task for every committed slot
+ * @param count Number of slots in the ring (2..254)
+ * @param size Size of each slot in bytes
+ * @param strategy Where to allocate the slots, see OtaBufferPool
+ * @return true if the pipeline is ready to use
+ *
+ * The pool may hand out fewer or smaller slots than requested on tight heaps,
+ * use slots() and slotSize() to get the actual layout.
+ *
+ * The writer task is pinned to the core the caller is not running on, unless
+ * setCore() picked one. On single core chips both tasks share the only core
+ * and the pipeline still decouples socket reads from flash writes through the
+ * queued slots.
+ */
+bool OtaPipeline::begin(Sink output, size_t count, size_t size, OtaBufferStrategy strategy) {
+    abort();
+    if (count < 2 || count >= STOP_MARKER || size == 0)
+        return false;
+
+    sink = output;
+    writeFailed = false;
+    bytesWritten = 0;
+
+    pool.heapReserve = OTABUFFERPOOL_HEAP_RESERVE + extraReserve;
+    if (!pool.begin(count, size, strategy))
+        return false;
+    slot = new (std::nothrow) Slot[pool.count()];
+    if (!slot) {
+        release();
+        return false;
+    }
+    slotLen = pool.size();
+    for (slotCount = 0; slotCount < pool.count(); slotCount++) {
+        slot[slotCount].data = pool.get(slotCount);
+        slot[slotCount].len = 0;
+    }
+
+    emptySlots = xQueueCreate(slotCount, sizeof(uint8_t));
+    filledSlots = xQueueCreate(slotCount + 1, sizeof(uint8_t));
+    writerDone = xSemaphoreCreateBinary();
+    if (!emptySlots || !filledSlots || !writerDone) {
+        release();
+        return false;
+    }
+    for (uint8_t i = 0; i < slotCount; i++)
+        xQueueSend(emptySlots, &i, 0);
+
+    BaseType_t core = writerCore;
+    if (core < 0) {
+        core = 0;
+#if !CONFIG_FREERTOS_UNICORE
+        core = xPortGetCoreID() == 0 ? 1 : 0;
+#endif
+    }
+    BaseType_t xReturned = xTaskCreatePinnedToCore(
+        writerTask,
+        "OtaFlashWriter",
+        4096,                    // Stack size
+        this,                    // Task input parameter
+        uxTaskPriorityGet(NULL), // Same priority as the producer
+        &writer,                 // Task handle.
+        core                     // Core where the task should run
+    );
+    if (xReturned != pdPASS) {
+        writer = NULL;
+        release();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Get an empty slot to fill
+ * @param wait Ticks to wait for the writer to return a slot
+ * @return Pointer to a buffer of slotSize() bytes, or NULL
+ */
+uint8_t *OtaPipeline::acquire(TickType_t wait) {
+    if (!emptySlots || writeFailed)
+        return NULL;
+
+    uint8_t idx;
+    if (xQueueReceive(emptySlots, &idx, wait) != pdTRUE)
+        return NULL;
+    if (writeFailed) {
+        xQueueSend(emptySlots, &idx, 0);
+        return NULL;
+    }
+    return slot[idx].data;
+}
+
+/**
+ * @brief Hand a filled slot over to the writer task
+ * @param data A pointer returned by acquire()
+ * @param len Number of valid bytes in the slot
+ * @return false if the slot is unknown or the writer already failed
+ */
+bool OtaPipeline::commit(uint8_t *data, size_t len) {
+    for (uint8_t i = 0; i < slotCount; i++) {
+        if (slot[i].data != data)
+            continue;
+        if (len == 0) {
+            xQueueSend(emptySlots, &i, 0); // nothing to write, give it back
+            return !writeFailed;
+        }
+        slot[i].len = len > slotLen ? slotLen : len;
+        xQueueSend(filledSlots, &i, portMAX_DELAY);
+        return !writeFailed;
+    }
+    return false;
+}
+
+/**
+ * @brief Flush all committed slots and stop the writer task
+ * @return true if every slot was written successfully
+ */
+bool OtaPipeline::finish() {
+    if (!writer)
+        return false;
+
+    uint8_t stop = STOP_MARKER;
+    xQueueSend(filledSlots, &stop, portMAX_DELAY);
+    xSemaphoreTake(writerDone, portMAX_DELAY);
+    writer = NULL; // the task deleted itself
+
+    bool success = !writeFailed;
+    release();
+    return success;
+}
+
+/**
+ * @brief Stop the writer without waiting for pending data to be written
+ */
+void OtaPipeline::abort() {
+    if (writer) {
+        writeFailed = true; // writer skips the remaining slots
+        finish();
+    }
+    release();
+}
+
+/**
+ * @brief Free all resources of the pipeline
+ */
+void OtaPipeline::release() {
+    if (slot) {
+        delete[] slot;
+        slot = NULL;
+    }
+    pool.release();
+    slotCount = 0;
+    slotLen = 0;
+
+    if (emptySlots) {
+        vQueueDelete(emptySlots);
+        emptySlots = NULL;
+    }
+    if (filledSlots) {
+        vQueueDelete(filledSlots);
+        filledSlots = NULL;
+    }
+    if (writerDone) {
+        vSemaphoreDelete(writerDone);
+        writerDone = NULL;
+    }
+}
+
+/**
+ * @brief Writer task draining the filled slots into the sink
+ * @param param needs to be a valid OtaPipeline instance
+ */
+void OtaPipeline::writerTask(void *param) {
+    OtaPipeline *pipeline = (OtaPipeline *)param;
+    uint8_t idx;
+
+    for (;;) {
+        if (xQueueReceive(pipeline->filledSlots, &idx, portMAX_DELAY) != pdTRUE)
+            continue;
+        if (idx == STOP_MARKER)
+            break;
+
+        Slot &current = pipeline->slot[idx];
+        if (!pipeline->writeFailed) {
+            if (pipeline->sink && pipeline->sink(current.data, current.len))
+                pipeline->bytesWritten += current.len;
+            else
+                pipeline->writeFailed = true;
+        }
+        current.len = 0;
+        xQueueSend(pipeline->emptySlots, &idx, portMAX_DELAY);
+        if (pipeline->released)
+            pipeline->released();
+    }
+
+    xSemaphoreGive(pipeline->writerDone);
+    vTaskDelete(NULL);
+}
@@ -0,0 +1,116 @@
+/**
+ * @file otaPipeline.h
+ * @author Martin Verges <martin@verges.cc>
+ * @version 0.3
+ * @date 2025-01-06
+ *
+ * @copyright Copyright (c) 2022-2024 by the author alone
+ *
+ * License: CC BY-NC-SA 4.0
+ */
+
+#ifndef OTAPIPELINE_h
+#define OTAPIPELINE_h
+
+#include "otaBufferPool.h"
+
+#include <Arduino.h>
+#include <functional>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+/**
+ * Producer/consumer ring of buffer slots between the network and the flash.
+ *
+ * The producer (the task running updateFile()) acquires an empty slot, fills it
+ * from the socket and commits it. A writer task, pinned to the other core if
+ * there is one, drains committed slots in order into the sink (Update.write).
+ * With two or more slots the radio keeps receiving while the flash is busy.
+ */
+class OtaPipeline {
+  public:
+    // Write a chunk to its final destination, return false to abort the pipeline
+    typedef std::function<bool(uint8_t *data, size_t len)> Sink;
+
+    // Called from the writer task whenever a slot became empty again
+    typedef std::function<void()> Released;
+
+    OtaPipeline();
+    virtual ~OtaPipeline();
+
+    // Pin the writer task to this core, -1 for the core the caller is not running on
+    void setCore(BaseType_t core) { writerCore = core; }
+
+    // Internal heap the slots leave free on top of the pool reserve, e.g. for a decoder that is started later, set before begin()
+    void reserveHeap(size_t bytes) { extraReserve = bytes; }
+
+    // Allocate the slots and start the writer task
+    bool begin(Sink output, size_t slotCount, size_t slotSize, OtaBufferStrategy strategy = OTA_BUFFER_AUTO);
+
+    // Get an empty slot to fill, NULL on timeout or if the writer failed
+    uint8_t *acquire(TickType_t wait = portMAX_DELAY);
+
+    // Hand a filled slot over to the writer task
+    bool commit(uint8_t *slot, size_t len);
+
+    // Wait until all committed slots are written and stop the writer task
+    bool finish();
+
+    // Drop all pending slots and stop the writer task
+    void abort();
+
+    // Did the sink report an error
+    bool failed() { return writeFailed; }
+
+    // Number of empty slots that can be acquired without waiting
+    size_t available() { return emptySlots ? uxQueueMessagesWaiting(emptySlots) : 0; }
+
+    // Get notified when the writer returns a slot, set before begin()
+    void onReleased(Released callback) { released = callback; }
+
+    // Size of a single slot
+    size_t slotSize() { return slotLen; }
+
+    // Number of slots in the ring
+    size_t slots() { return slotCount; }
+
+    // Are the slots located in PSRAM
+    bool inPsram() { return pool.inPsram(); }
+
+    // Bytes handed to the sink so far
+    size_t written() { return bytesWritten; }
+
+  private:
+    struct Slot {
+        uint8_t *data;
+        size_t len;
+    };
+
+    // Marker pushed to the writer queue to end the writer task
+    static const uint8_t STOP_MARKER = 0xFF;
+
+    static void writerTask(void *param);
+    void release();
+
+    Sink sink = NULL;
+    Released released = NULL;
+    OtaBufferPool pool;
+    Slot *slot = NULL;
+    size_t slotCount = 0;
+    size_t slotLen = 0;
+
+    QueueHandle_t emptySlots = NULL;
+    QueueHandle_t filledSlots = NULL;
+    SemaphoreHandle_t writerDone = NULL;
+    TaskHandle_t writer = NULL;
+    BaseType_t writerCore = -1;
+    size_t extraReserve = 0;
+
+    volatile bool writeFailed = false;
+    volatile size_t bytesWritten = 0;
+};
+
+#endif // OTAPIPELINE_h
@@ -0,0 +1,191 @@
+/**
+ * OTA upload writer
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#include "otaUploadWriter.h"
+
+#include <lwip/priv/tcp_priv.h> // tcp_active_pcbs
+#include <lwip/tcp.h>
+#include <lwip/tcpip.h>
+#include <string.h>
+
+OtaUploadWriter::~OtaUploadWriter() {
+    abort();
+}
+
+/**
+ * @brief Allocate the slots and start the writer task
+ * @param sink Receives the upload in order, called from the writer task
+ * @param uploadClient The connection of the upload, used for the flow control
+ * @param slots Number of slots in the ring
+ * @param size Size of each slot in bytes
+ * @param strategy Where to allocate the slots, see OtaBufferPool
+ * @return true if the writer is ready
+ *
+ * Must be called from the AsyncTCP task, i.e. the upload handler.
+ */
+bool OtaUploadWriter::begin(OtaPipeline::Sink sink, AsyncClient *uploadClient, size_t slots, size_t size, OtaBufferStrategy strategy) {
+    abort();
+    paused = false;
+    slot = NULL;
+    slotFill = 0;
+
+    pipeline.onReleased([this]() { released(); });
+    active = pipeline.begin(sink, slots, size, strategy);
+    if (active && uploadClient) {
+        client = uploadClient;
+        pcb = uploadClient->pcb();
+    }
+    return active;
+}
+
+/**
+ * @brief Copy a chunk of the upload into the slots
+ * @param data The chunk, only valid during the upload callback
+ * @param len Number of bytes
+ * @return false if the writer failed
+ */
+bool OtaUploadWriter::write(const uint8_t *data, size_t len) {
+    if (!active)
+        return false;
+
+    // The held back data must be acknowledged before this packet is held as well
+    resume();
+
+    while (len) {
+        if (!slot) {
+            slot = pipeline.acquire(0);
+            if (!slot) // the sender ignored the closed window
+                return false;
+            slotFill = 0;
+        }
+
+        size_t take = pipeline.slotSize() - slotFill;
+        if (take > len)
+            take = len;
+        memcpy(slot + slotFill, data, take);
+        slotFill += take;
+        data += take;
+        len -= take;
+
+        if (slotFill == pipeline.slotSize()) {
+            if (!pipeline.commit(slot, slotFill))
+                return false;
+            slot = NULL;
+        }
+    }
+
+    // Close the window while the rest of it still fits, AsyncTCP asks again for every packet
+    if (client && freeSpace() < holdSpace()) {
+        client->ackLater();
+        paused = true;
+    }
+    return !pipeline.failed();
+}
+
+/**
+ * @brief Bytes that can be queued without waiting for the writer
+ */
+size_t OtaUploadWriter::freeSpace() {
+    return pipeline.available() * pipeline.slotSize() + (slot ? pipeline.slotSize() - slotFill : 0);
+}
+
+/**
+ * @brief Free space below which the data is held back, at most the whole ring
+ */
+size_t OtaUploadWriter::holdSpace() {
+    size_t ring = pipeline.slots() * pipeline.slotSize();
+    return OTAUPLOAD_HOLD_SPACE < ring ? OTAUPLOAD_HOLD_SPACE : ring;
+}
+
+/**
+ * @brief Acknowledge the held back data once there is room, called from the AsyncTCP task
+ */
+void OtaUploadWriter::resume() {
+    if (!paused || !client)
+        return;
+    if (active && freeSpace() < holdSpace())
+        return;
+    if (paused.exchange(false))
+        client->ack(0xFFFFFFFF); // everything that was held back
+}
+
+/**
+ * @brief The writer task returned a slot, reopen a closed window if the ring has room again
+ *
+ * AsyncClient is not thread-safe, so the window is opened on the pcb in the
+ * lwIP thread. Without this the held data would wait for the next data packet,
+ * which does not come while the window is closed.
+ */
+void OtaUploadWriter::released() {
+    if (!paused || !pcb || pipeline.available() * pipeline.slotSize() < holdSpace())
+        return;
+    if (!reopenPending.exchange(true) && tcpip_callback(reopenWindow, this) != ERR_OK)
+        reopenPending = false; // retried with the next slot
+}
+
+/**
+ * @brief Open the receive window of the upload completely, runs in the lwIP thread
+ *
+ * The pcb is only used if it is still an active connection, it may have been
+ * closed and freed since the call was queued. tcp_recved() caps the window, so
+ * data acknowledged by the client as well is not counted twice.
+ */
+void OtaUploadWriter::reopenWindow(void *arg) {
+    OtaUploadWriter *writer = (OtaUploadWriter *)arg;
+    writer->reopenPending = false;
+    tcp_pcb *target = writer->pcb;
+    if (!target || !writer->paused)
+        return;
+    for (tcp_pcb *listed = tcp_active_pcbs; listed; listed = listed->next) {
+        if (listed == target) {
+            tcp_recved(listed, TCP_WND_MAX(listed) - listed->rcv_wnd);
+            writer->paused = false;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Write the last partial slot and wait for the writer task
+ * @return true if everything was handed to the sink successfully
+ */
+bool OtaUploadWriter::end() {
+    if (!active)
+        return false;
+    active = false;
+
+    bool success = true;
+    if (slot)
+        success = pipeline.commit(slot, slotFill);
+    slot = NULL;
+    success = pipeline.finish() && success;
+    resume();
+    detach();
+    return success;
+}
+
+/**
+ * @brief Stop the writer task without writing the queued data
+ */
+void OtaUploadWriter::abort() {
+    active = false;
+    if (slot)
+        pipeline.commit(slot, 0);
+    slot = NULL;
+    pipeline.abort();
+    detach(); // the connection is dropped or answered with an error, nothing to acknowledge
+}
+
+/**
+ * @brief Stop using the client, required before it is deleted
+ */
+void OtaUploadWriter::detach() {
+    pcb = NULL;
+    client = NULL;
+    paused = false;
+}
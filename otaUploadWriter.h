@@ -0,0 +1,90 @@
+/**
+ * @file otaUploadWriter.h
+ * @author Martin Verges <martin@verges.cc>
+ * @version 0.3
+ * @date 2025-01-06
+ *
+ * @copyright Copyright (c) 2022-2024 by the author alone
+ *
+ * License: CC BY-NC-SA 4.0
+ */
+
+#ifndef OTAUPLOADWRITER_h
+#define OTAUPLOADWRITER_h
+
+#include "otaPipeline.h"
+
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <atomic>
+#include <lwip/opt.h>
+
+struct tcp_pcb;
+
+// Free ring space below which received data is no longer acknowledged. The
+// sender can still fill one TCP window after that, which then fits as well.
+#define OTAUPLOAD_HOLD_SPACE (2 * TCP_WND)
+
+/**
+ * Moves browser uploads from the AsyncTCP task into the flash writer task.
+ *
+ * The chunks of the upload handler are packed into pipeline slots, so the TCP
+ * task only copies memory and never waits for a flash erase. Once the free
+ * space of the ring falls below OTAUPLOAD_HOLD_SPACE, the received data is not
+ * acknowledged (AsyncClient::ackLater). The TCP window closes before the ring
+ * is full, so the upload callback never has to wait for a slot. As soon as the
+ * writer task freed enough space, it reopens the window from the lwIP thread
+ * (tcpip_callback), the next upload callback acknowledges through the client.
+ * The callbacks of the client itself are left to the AsyncWebServerRequest.
+ */
+class OtaUploadWriter {
+  public:
+    OtaUploadWriter() {}
+    virtual ~OtaUploadWriter();
+
+    // Start the writer task for a new upload of the given client
+    bool begin(OtaPipeline::Sink sink, AsyncClient *client, size_t slots, size_t slotSize, OtaBufferStrategy strategy = OTA_BUFFER_AUTO);
+
+    // Queue the next chunk, never blocks, false if the writer failed or the sender overran the window
+    bool write(const uint8_t *data, size_t len);
+
+    // Flush all queued data and stop the writer task
+    bool end();
+
+    // Drop all queued data
+    void abort();
+
+    // Forget the client, e.g. if it disconnected
+    void detach();
+
+    // Is an upload running
+    bool isActive() { return active; }
+
+    // Size of a single slot
+    size_t slotSize() { return pipeline.slotSize(); }
+
+    // Did the sink report an error
+    bool failed() { return pipeline.failed(); }
+
+  private:
+    size_t freeSpace();
+    size_t holdSpace();
+    void resume();
+    void released();
+    static void reopenWindow(void *arg);
+
+    OtaPipeline pipeline;
+    uint8_t *slot = NULL;
+    size_t slotFill = 0;
+    bool active = false;
+
+    // Only used from the AsyncTCP task
+    AsyncClient *client = NULL;
+
+    // Shared with the writer task and the lwIP thread
+    std::atomic<tcp_pcb *> pcb{NULL};
+    std::atomic<bool> paused{false};
+    std::atomic<bool> reopenPending{false}; // a reopenWindow() call is queued
+};
+
+#endif // OTAUPLOADWRITER_h
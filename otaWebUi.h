@@ -0,0 +1,426 @@
+/**
+ * @file otaWebUi.h
+ * @brief gzip compressed web UI, generated by tools/embedUi.py from ui/index.html
+ *
+ * Do not edit, run "python3 tools/embedUi.py" instead.
+ *
+ * License: CC BY-NC-SA 4.0
+ */
+
+#ifndef OTAWEBUI_h
+#define OTAWEBUI_h
+
+#include <Arduino.h>
+
+#if OTAWEBUPDATER_USE_NVS == true
+#define OTAWEBUI_ETAG "\"9d971e56a00a6529\""
+#define OTAWEBUI_SIZE 3181
+const uint8_t OTAWEBUI_HTML_GZ[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xcd, 0x1b, 0x69, 0x73, 0xdb, 0xb8,
+    0xf5, 0xbb, 0x7f, 0x05, 0x56, 0xd9, 0x1d, 0x49, 0x5d, 0x89, 0x3a, 0x7c, 0xc4, 0x71, 0x2c, 0x4f,
+    0x13, 0x27, 0x9e, 0xa4, 0xcd, 0xe1, 0x89, 0xed, 0xed, 0x35, 0x9d, 0x06, 0x22, 0x41, 0x09, 0x0d,
+    0x45, 0x72, 0x41, 0xd0, 0xb2, 0x93, 0xf1, 0x7f, 0xea, 0x6f, 0xe8, 0x2f, 0xeb, 0x7b, 0xe0, 0x21,
+    0x12, 0x04, 0x29, 0xd9, 0x56, 0xba, 0xab, 0x9d, 0x6c, 0x48, 0xe2, 0xe1, 0x5d, 0x78, 0x17, 0x1e,
+    0x90, 0xe3, 0x1f, 0x5e, 0x7d, 0x3c, 0xbd, 0xfc, 0xdb, 0xf9, 0x6b, 0x32, 0x97, 0x0b, 0xef, 0x64,
+    0xe7, 0x18, 0xff, 0x22, 0x1e, 0xf5, 0x67, 0x93, 0x16, 0xf3, 0x5b, 0xf8, 0x81, 0x51, 0xe7, 0x64,
+    0x87, 0xc0, 0xef, 0x78, 0xc1, 0x24, 0x25, 0xf6, 0x9c, 0x8a, 0x88, 0xc9, 0x49, 0xeb, 0xea, 0xf2,
+    0xac, 0x7f, 0xd8, 0x2a, 0x0e, 0xf9, 0x74, 0xc1, 0x26, 0xad, 0x6b, 0xce, 0x96, 0x61, 0x20, 0x64,
+    0x8b, 0xd8, 0x81, 0x2f, 0x99, 0x0f, 0xa0, 0x4b, 0xee, 0xc8, 0xf9, 0xc4, 0x61, 0xd7, 0xdc, 0x66,
+    0x7d, 0xf5, 0xd2, 0x23, 0xdc, 0xe7, 0x92, 0x53, 0xaf, 0x1f, 0xd9, 0xd4, 0x63, 0x93, 0x91, 0x35,
+    0xcc, 0x50, 0x49, 0x2e, 0x3d, 0x76, 0xf2, 0xfa, 0xe2, 0x7c, 0x77, 0x4c, 0x3e, 0x5e, 0xbe, 0x20,
+    0x57, 0xa1, 0x43, 0x25, 0x13, 0xc7, 0x83, 0x64, 0x20, 0x01, 0x8a, 0xe4, 0x6d, 0xf6, 0x8c, 0xbf,
+    0x23, 0x11, 0x04, 0x92, 0x7c, 0xcb, 0xdf, 0xf1, 0xd7, 0xef, 0x87, 0x82, 0x2f, 0xa8, 0xb8, 0xed,
+    0xdb, 0x81, 0x17, 0x88, 0x23, 0xf2, 0x64, 0xbc, 0x7f, 0xb0, 0xcb, 0xa6, 0xcf, 0x35, 0xa8, 0x28,
+    0xb6, 0x6d, 0x16, 0x45, 0x39, 0xd4, 0xe8, 0x80, 0xee, 0xee, 0x51, 0x1d, 0x6a, 0x49, 0x85, 0xcf,
+    0xfd, 0x59, 0x0e, 0x65, 0xd3, 0x43, 0x3a, 0xdc, 0xd3, 0xa1, 0x98, 0x10, 0x81, 0xc8, 0x61, 0x1c,
+    0x7b, 0x7c, 0x30, 0x3e, 0xd0, 0x61, 0xa6, 0x2b, 0x24, 0xee, 0xa1, 0x4b, 0x5d, 0x5b, 0x07, 0xb0,
+    0xa9, 0x70, 0x00, 0x0a, 0xc7, 0xd5, 0x4f, 0x1f, 0x97, 0xec, 0x46, 0xae, 0xb8, 0x65, 0xe3, 0x67,
+    0xbb, 0x15, 0x99, 0xa6, 0x81, 0x70, 0xd8, 0x8a, 0x11, 0x36, 0x66, 0x87, 0xee, 0x70, 0x05, 0x74,
+    0xb7, 0x93, 0x3f, 0x4e, 0x03, 0xe7, 0x56, 0x53, 0x9c, 0x0b, 0xcb, 0xd6, 0x77, 0xe9, 0x82, 0x7b,
+    0xb7, 0x47, 0x24, 0xba, 0x8d, 0x24, 0x5b, 0xf4, 0x63, 0xde, 0x23, 0x7d, 0x1a, 0x86, 0x1e, 0xeb,
+    0x27, 0x5f, 0x7a, 0x24, 0xa2, 0x7e, 0xd4, 0x8f, 0x98, 0xe0, 0x1a, 0x83, 0x53, 0x6a, 0x7f, 0x99,
+    0x89, 0x20, 0xf6, 0x9d, 0x23, 0x72, 0x4d, 0x45, 0x67, 0x25, 0x71, 0xb7, 0x0c, 0x98, 0x72, 0x97,
+    0xc0, 0xac, 0x84, 0xd2, 0xa0, 0x60, 0x05, 0x67, 0xdc, 0x3f, 0x22, 0xc3, 0xf2, 0xe7, 0x90, 0x3a,
+    0x0e, 0xac, 0xc7, 0x11, 0x19, 0x1d, 0x84, 0x37, 0xe5, 0x21, 0x8f, 0xfb, 0xac, 0x3f, 0x67, 0x7c,
+    0x36, 0x97, 0x30, 0x6c, 0xed, 0x1b, 0xe5, 0xb6, 0xd0, 0x38, 0x29, 0x40, 0x0a, 0x4d, 0xfa, 0x05,
+    0xbd, 0x49, 0x4c, 0xf4, 0x88, 0x1c, 0x0e, 0x87, 0x3a, 0xee, 0x9c, 0x1b, 0x42, 0x63, 0x19, 0xd4,
+    0x60, 0x86, 0xf5, 0xd3, 0x90, 0x56, 0x75, 0x92, 0x2e, 0xb2, 0x26, 0x6c, 0xba, 0x6e, 0x82, 0x3a,
+    0x3c, 0x8e, 0x80, 0x01, 0x9d, 0x7c, 0x83, 0xd4, 0x09, 0x67, 0xb0, 0xf2, 0x52, 0x06, 0x0b, 0x13,
+    0xc0, 0x34, 0xb8, 0xe9, 0x47, 0x73, 0xea, 0x04, 0x4b, 0x64, 0x7f, 0x14, 0xde, 0x90, 0x5d, 0xf8,
+    0x23, 0x66, 0x53, 0xda, 0x19, 0xf6, 0xd4, 0x7f, 0xd6, 0xc8, 0xc8, 0xce, 0x91, 0x02, 0x8e, 0x02,
+    0x8f, 0x3b, 0xd9, 0x82, 0x16, 0xcc, 0xab, 0x6b, 0x54, 0xc2, 0x7c, 0xd4, 0x23, 0xf3, 0x71, 0x45,
+    0xb5, 0x99, 0xf2, 0x86, 0x8a, 0x3f, 0x7d, 0x4d, 0xd7, 0x1b, 0x44, 0x51, 0xcd, 0x71, 0xe8, 0x05,
+    0xd4, 0xe9, 0x7f, 0x0d, 0x7c, 0xa6, 0x6b, 0x3b, 0x65, 0x7b, 0x0c, 0x24, 0x1c, 0x1a, 0xcd, 0xd9,
+    0x1a, 0xbe, 0xef, 0xa5, 0xf9, 0xdd, 0xb1, 0x3e, 0xa4, 0x38, 0xa5, 0x1e, 0x9f, 0x81, 0x68, 0x36,
+    0xc4, 0x3b, 0x26, 0x34, 0xb1, 0x62, 0x11, 0xa1, 0x5c, 0x61, 0xc0, 0xab, 0x83, 0x52, 0x80, 0x1b,
+    0x41, 0x24, 0x0c, 0x60, 0x32, 0xf5, 0x3c, 0x32, 0xb4, 0xc6, 0xd1, 0x5a, 0x79, 0x8f, 0xe6, 0xc1,
+    0x75, 0xc5, 0x70, 0xcb, 0x3e, 0x9f, 0x08, 0x5c, 0x8a, 0x80, 0xdd, 0x7a, 0x3f, 0xad, 0x44, 0xa2,
+    0x1a, 0xc2, 0x96, 0x23, 0xe8, 0xac, 0xbf, 0x6d, 0xe2, 0xcc, 0x75, 0x0f, 0x8a, 0x61, 0xae, 0x18,
+    0x9e, 0x62, 0x30, 0x67, 0x7f, 0xad, 0x37, 0x35, 0x91, 0x4a, 0x79, 0x5a, 0xce, 0xb9, 0x64, 0x66,
+    0xf3, 0xf6, 0x41, 0xb2, 0x9a, 0xd5, 0x06, 0x3b, 0x30, 0xba, 0x52, 0xc9, 0x58, 0xf6, 0xf4, 0xf1,
+    0xc6, 0x15, 0x57, 0xe1, 0x35, 0xe2, 0x5f, 0x19, 0x38, 0x82, 0x75, 0xf8, 0x74, 0x5f, 0xb0, 0x45,
+    0xbd, 0x49, 0x04, 0x21, 0xb5, 0xb9, 0xbc, 0xad, 0x37, 0x8b, 0x44, 0x41, 0x46, 0x83, 0x48, 0xe7,
+    0x22, 0x99, 0x67, 0x4d, 0x73, 0x1d, 0x1e, 0xd1, 0xa9, 0xc7, 0x9c, 0xfa, 0xe9, 0xfb, 0x66, 0xf1,
+    0xfc, 0x00, 0xed, 0xde, 0x0b, 0x96, 0xcc, 0x31, 0x5b, 0x4e, 0x24, 0xa9, 0x8c, 0x23, 0x0d, 0x6f,
+    0x51, 0xb7, 0xf7, 0x53, 0x6b, 0x16, 0x3f, 0x0e, 0xab, 0xa1, 0x03, 0x64, 0x08, 0x3d, 0x7a, 0xab,
+    0xaf, 0x65, 0x95, 0x19, 0x4b, 0xa5, 0xe8, 0x06, 0x83, 0x7a, 0xe2, 0x32, 0x48, 0x97, 0x63, 0xa3,
+    0x0d, 0x3d, 0x79, 0xf6, 0x6c, 0x34, 0x1d, 0x4d, 0x6b, 0x48, 0x4f, 0xbd, 0xc0, 0xfe, 0xd2, 0x48,
+    0x3b, 0x2d, 0x35, 0x9a, 0xa8, 0x3b, 0xb6, 0x6b, 0xb3, 0xa7, 0x66, 0xea, 0xa3, 0x83, 0x83, 0xfd,
+    0xdd, 0xbd, 0x07, 0x53, 0xe7, 0xbe, 0x1b, 0x34, 0x91, 0x66, 0x43, 0x77, 0xec, 0x32, 0x33, 0xe9,
+    0xe1, 0xd3, 0xfd, 0x67, 0x87, 0xfb, 0xf7, 0x27, 0x3d, 0x13, 0x5c, 0xb7, 0xab, 0x7c, 0x1a, 0x8e,
+    0x95, 0x31, 0xe2, 0x17, 0x08, 0xfc, 0x0b, 0x18, 0x97, 0x0c, 0x9d, 0x39, 0x5e, 0xf8, 0x60, 0x08,
+    0x82, 0x85, 0x8c, 0xca, 0x0e, 0x66, 0xdc, 0xbe, 0xcb, 0x65, 0x8f, 0x2c, 0xb8, 0x0f, 0x69, 0xba,
+    0x33, 0xc6, 0xfc, 0xdc, 0x23, 0x23, 0x57, 0x74, 0x35, 0x9f, 0x9f, 0xd1, 0xb0, 0x21, 0x47, 0xca,
+    0xa0, 0x32, 0xaa, 0xab, 0xab, 0xbf, 0x26, 0x89, 0x1b, 0x4b, 0xb7, 0x55, 0x76, 0x1e, 0xaf, 0x31,
+    0xed, 0x9a, 0x88, 0xf2, 0x90, 0x4c, 0x9b, 0xb0, 0xab, 0x6a, 0x63, 0x53, 0x1d, 0xd7, 0x14, 0x68,
+    0xb2, 0xc5, 0x3d, 0xd8, 0x7b, 0xba, 0x77, 0x38, 0x6d, 0x2c, 0x27, 0xf6, 0x1a, 0x95, 0x75, 0x4d,
+    0xbd, 0xd8, 0x48, 0x7d, 0x99, 0x56, 0x61, 0xfb, 0x43, 0x73, 0xf5, 0x69, 0x85, 0x22, 0x98, 0x09,
+    0xac, 0xbe, 0xa7, 0x54, 0x77, 0xca, 0xb4, 0x08, 0x1b, 0x0d, 0x87, 0x3f, 0x95, 0x59, 0xcb, 0x4a,
+    0xbb, 0x4a, 0x7c, 0x28, 0x5b, 0xb3, 0x56, 0xf3, 0x1a, 0x56, 0xa1, 0xb2, 0x4a, 0x18, 0x44, 0x5d,
+    0x0f, 0x0b, 0xa4, 0x39, 0x77, 0x1c, 0xe6, 0x3f, 0xc4, 0x7a, 0x4a, 0x12, 0xe5, 0x6f, 0x66, 0xd9,
+    0xea, 0x24, 0xab, 0xca, 0x7c, 0xbf, 0x94, 0x57, 0xcc, 0x20, 0x8a, 0x14, 0x18, 0xc0, 0x6e, 0x44,
+    0x18, 0x8d, 0xcc, 0xb1, 0x91, 0xfb, 0x61, 0x2c, 0x37, 0x0e, 0xd3, 0xa5, 0x30, 0x5c, 0x9b, 0x1d,
+    0x37, 0xb6, 0xe5, 0x4d, 0x22, 0xbf, 0xaa, 0x5d, 0xf9, 0x57, 0xc5, 0x4f, 0x0a, 0x0b, 0x9f, 0x8c,
+    0xb2, 0x3c, 0x89, 0x96, 0x5c, 0xda, 0xf3, 0x73, 0x2a, 0xa4, 0xd2, 0xc0, 0x4b, 0xb9, 0xbe, 0x7c,
+    0x28, 0x6d, 0xee, 0xea, 0xdc, 0x6c, 0x01, 0xa9, 0x4e, 0x55, 0xa5, 0xdb, 0x72, 0xb3, 0xbb, 0x64,
+    0x2b, 0x3b, 0x48, 0xf7, 0xb2, 0xc7, 0x83, 0x64, 0xab, 0x7d, 0x8c, 0x5b, 0xb2, 0x74, 0x9b, 0xeb,
+    0xf0, 0x6b, 0x62, 0x7b, 0x34, 0x8a, 0x26, 0xad, 0x7c, 0xbf, 0xd2, 0x5a, 0x6d, 0x7b, 0x4b, 0xe3,
+    0x10, 0xb0, 0x0a, 0x43, 0x6a, 0x78, 0x3e, 0x32, 0xed, 0xa3, 0xe1, 0x6b, 0x19, 0x0c, 0xb1, 0x70,
+    0x67, 0xd2, 0x4a, 0xf2, 0x44, 0xeb, 0xe4, 0x78, 0x00, 0x5f, 0xca, 0x30, 0xe6, 0x09, 0x49, 0x65,
+    0xf8, 0x77, 0x48, 0xb9, 0xad, 0x8c, 0x8d, 0x42, 0xb1, 0xa8, 0x71, 0x93, 0xcd, 0x3c, 0x79, 0x05,
+    0x35, 0x24, 0xa1, 0xbe, 0x43, 0x1c, 0x11, 0x84, 0xc4, 0xe5, 0x62, 0x01, 0xfa, 0x67, 0xf0, 0x00,
+    0x11, 0x6c, 0xce, 0xe0, 0x09, 0xf2, 0xb3, 0xed, 0x71, 0xfb, 0x0b, 0x91, 0x01, 0x89, 0x98, 0xc7,
+    0x6c, 0x69, 0xe0, 0x48, 0xa1, 0x4b, 0x0c, 0x57, 0xde, 0x86, 0x6c, 0xd2, 0xc2, 0xf9, 0x2d, 0xc5,
+    0x16, 0x3e, 0xbd, 0xc5, 0x91, 0x16, 0x51, 0xba, 0x9d, 0xb4, 0x4a, 0xe5, 0x41, 0x8b, 0x50, 0x48,
+    0xc3, 0xa1, 0x9c, 0xb4, 0xac, 0x29, 0xf7, 0x6b, 0xb8, 0xcc, 0xe4, 0x29, 0xba, 0xb3, 0x01, 0xb4,
+    0x0e, 0xbc, 0x55, 0xd0, 0xcf, 0x79, 0xf6, 0xed, 0xa4, 0x4e, 0x8c, 0xea, 0xe7, 0xf4, 0x53, 0xf9,
+    0x9b, 0x47, 0xa7, 0xcc, 0x03, 0x7b, 0x13, 0x93, 0x56, 0x20, 0xe9, 0x39, 0x10, 0x5c, 0x06, 0xb8,
+    0xe8, 0x9d, 0x8f, 0x21, 0x5a, 0x3a, 0xf5, 0xba, 0x6a, 0xa1, 0xb3, 0x81, 0xa3, 0xe3, 0x81, 0x9a,
+    0xa1, 0x61, 0x2e, 0xea, 0x0c, 0xcd, 0x39, 0x61, 0xb5, 0x88, 0x10, 0x12, 0xee, 0xaf, 0x31, 0x17,
+    0xcc, 0x29, 0x58, 0x9a, 0xc6, 0xcf, 0x5a, 0xcb, 0x1b, 0x9f, 0x9c, 0x65, 0x0b, 0xfb, 0x16, 0xea,
+    0x0e, 0xb1, 0xa0, 0xc8, 0x22, 0x18, 0xdf, 0xb8, 0xc6, 0xf8, 0x32, 0x3b, 0x40, 0x68, 0xa3, 0xa6,
+    0x8e, 0xd3, 0xbd, 0x80, 0xb2, 0xd4, 0x8a, 0x8f, 0xb7, 0x48, 0xe0, 0x2b, 0xa3, 0xa9, 0x0c, 0x76,
+    0xba, 0xad, 0x93, 0x0b, 0xf5, 0x89, 0xbc, 0xb0, 0x25, 0xbf, 0x66, 0x24, 0x1f, 0x3a, 0x1e, 0x24,
+    0x38, 0x1f, 0x25, 0xe7, 0x85, 0xea, 0x87, 0x6c, 0x28, 0x65, 0xd2, 0x3c, 0x51, 0x32, 0x66, 0x68,
+    0xb1, 0xe8, 0xa9, 0x08, 0xac, 0xbf, 0xae, 0x67, 0xe3, 0x34, 0xf0, 0x5d, 0x3e, 0x8b, 0xc5, 0x3a,
+    0x0e, 0xec, 0x22, 0x5c, 0xa3, 0xa2, 0x57, 0x0a, 0xa5, 0xd7, 0x2c, 0x41, 0xaf, 0x74, 0x09, 0x6f,
+    0xe4, 0x82, 0x49, 0x09, 0x11, 0x33, 0xaa, 0xd5, 0xa0, 0xae, 0xcc, 0xe3, 0xc8, 0x16, 0x3c, 0x94,
+    0x2b, 0x38, 0xe0, 0x23, 0x92, 0xe4, 0xc5, 0xf9, 0xdb, 0x7f, 0xbd, 0x7c, 0x71, 0xf1, 0x9a, 0x4c,
+    0x48, 0x7b, 0x40, 0x43, 0x3e, 0x00, 0x3b, 0x6c, 0xaf, 0x42, 0x64, 0xfe, 0x30, 0x18, 0x80, 0x82,
+    0x55, 0xc3, 0x10, 0x02, 0x2d, 0x91, 0x73, 0x06, 0xf9, 0x69, 0xc6, 0x76, 0x56, 0xf9, 0xd4, 0x77,
+    0x82, 0xa5, 0x05, 0x29, 0xeb, 0xf5, 0x35, 0xec, 0xc0, 0xdf, 0x71, 0xd0, 0x32, 0x84, 0xca, 0x4e,
+    0x1b, 0xfd, 0xaf, 0xdd, 0x23, 0x9d, 0x2e, 0x99, 0x9c, 0x68, 0x71, 0x1b, 0x87, 0xce, 0x0a, 0x46,
+    0xd7, 0xd1, 0x72, 0x12, 0x8e, 0x5f, 0xe4, 0xcb, 0xa5, 0x8f, 0x46, 0x4c, 0xc6, 0xe1, 0x19, 0x04,
+    0x9a, 0x2b, 0xe5, 0xe3, 0xfa, 0x30, 0x77, 0x49, 0xc7, 0x09, 0xec, 0x78, 0x01, 0xdc, 0x58, 0x33,
+    0x26, 0x5f, 0x7b, 0x0c, 0x1f, 0x5f, 0xde, 0xbe, 0x75, 0x3a, 0xed, 0xd2, 0x12, 0xb4, 0xbb, 0x5d,
+    0x02, 0x00, 0x99, 0x7e, 0x0b, 0xe9, 0x01, 0x9e, 0xf3, 0x17, 0x1a, 0xdd, 0xfa, 0x36, 0x71, 0x63,
+    0xdf, 0xc6, 0x39, 0xc5, 0x09, 0x9a, 0x54, 0x52, 0xe8, 0xed, 0xbc, 0x95, 0xb2, 0x21, 0x08, 0x85,
+    0xf0, 0xc0, 0x40, 0xd9, 0x74, 0x49, 0xb9, 0x24, 0x2e, 0x03, 0xaf, 0xe8, 0x7c, 0xfe, 0xf1, 0x5b,
+    0xb6, 0x0c, 0x77, 0x83, 0x84, 0xb7, 0xcf, 0x9a, 0x38, 0x2b, 0x1c, 0x90, 0x43, 0x68, 0x3e, 0x3f,
+    0x43, 0x68, 0xfd, 0x3b, 0x42, 0x3f, 0x7b, 0xbe, 0x53, 0x33, 0x89, 0x25, 0xd2, 0xc3, 0xbc, 0x4d,
+    0x75, 0x52, 0x25, 0x8f, 0x1a, 0x4d, 0xf1, 0x74, 0x0d, 0x12, 0xe2, 0x2f, 0x1d, 0x86, 0x8d, 0x0e,
+    0xac, 0xfd, 0x9b, 0xcb, 0xf7, 0xef, 0x80, 0xe0, 0xe7, 0xb5, 0x21, 0x3b, 0xf1, 0x3f, 0x23, 0x58,
+    0x19, 0x30, 0xdf, 0x17, 0xd4, 0x42, 0x1b, 0x67, 0xa8, 0xd2, 0xbc, 0x75, 0xf2, 0x02, 0x76, 0x2f,
+    0x18, 0x1e, 0xec, 0x34, 0x11, 0x93, 0xab, 0x4f, 0xef, 0x6a, 0xf2, 0x41, 0x03, 0x32, 0x55, 0x69,
+    0x37, 0xd2, 0xaf, 0x8d, 0xf0, 0x53, 0xa8, 0xfe, 0xae, 0x84, 0xd7, 0x22, 0x0a, 0xc7, 0xa4, 0xf5,
+    0xe3, 0x37, 0x5c, 0x4b, 0x2b, 0xfd, 0x7c, 0xd7, 0x2c, 0x54, 0x13, 0xa3, 0xcd, 0x83, 0xdf, 0x4f,
+    0x81, 0x6f, 0xb1, 0xb7, 0x02, 0xc2, 0x40, 0xf9, 0x4a, 0xde, 0x73, 0x3f, 0x96, 0x2c, 0xfa, 0x3f,
+    0x28, 0xd4, 0x8f, 0x17, 0x53, 0x28, 0xc2, 0x94, 0x4a, 0x79, 0xca, 0xc1, 0x2f, 0x4c, 0x44, 0x60,
+    0xb6, 0xa7, 0x73, 0x66, 0x7f, 0xd1, 0xf5, 0x6b, 0x82, 0xf9, 0x3e, 0xca, 0xae, 0x19, 0xfa, 0x5c,
+    0xf5, 0xa5, 0x3b, 0x8c, 0xa7, 0xcc, 0x83, 0x48, 0xf0, 0xe1, 0x97, 0x0b, 0x92, 0xf5, 0x7f, 0x76,
+    0xca, 0x20, 0x36, 0xc5, 0x94, 0xd9, 0x51, 0xfd, 0x12, 0x93, 0xc7, 0x45, 0xf3, 0x60, 0x79, 0xa1,
+    0x2a, 0xc6, 0x4e, 0xfb, 0x8c, 0x72, 0x6c, 0x20, 0x41, 0xbd, 0x86, 0xc1, 0x90, 0x24, 0xce, 0xac,
+    0x7b, 0xf1, 0x9d, 0xa9, 0xae, 0xd6, 0x02, 0x5b, 0x31, 0xd5, 0x94, 0x68, 0x56, 0xe3, 0xda, 0xbd,
+    0x63, 0x5a, 0xaf, 0x22, 0xc4, 0x82, 0xc9, 0x79, 0x00, 0xbb, 0x80, 0xf6, 0xf9, 0xc7, 0x8b, 0xcb,
+    0x76, 0x4f, 0x1b, 0xc5, 0x72, 0x1c, 0x16, 0xed, 0xc8, 0x20, 0x7b, 0xfb, 0x34, 0x39, 0xda, 0xea,
+    0x5f, 0x82, 0x4d, 0xb4, 0x01, 0x01, 0x1e, 0x8d, 0x70, 0x5b, 0x05, 0xaf, 0x01, 0x06, 0xc3, 0xb6,
+    0x36, 0xe5, 0x4e, 0x47, 0x8e, 0x45, 0xfe, 0x11, 0xf9, 0xd3, 0xc5, 0xc7, 0x0f, 0xb0, 0x85, 0x16,
+    0x90, 0x4a, 0xb9, 0x7b, 0xdb, 0xa9, 0x12, 0x4a, 0xbd, 0xf3, 0xa8, 0x3e, 0x70, 0xa6, 0x10, 0xed,
+    0xae, 0xa5, 0xec, 0xae, 0x57, 0x0d, 0x9c, 0x06, 0x03, 0x6c, 0xc0, 0x67, 0x02, 0xcf, 0x90, 0xeb,
+    0x42, 0x75, 0x77, 0x6a, 0x5f, 0xd7, 0xd9, 0x8f, 0xd9, 0x7a, 0x70, 0xf9, 0x8d, 0xd6, 0xb3, 0x89,
+    0xed, 0x54, 0x13, 0xfa, 0x96, 0x73, 0x63, 0x56, 0xa2, 0x0e, 0xb0, 0x93, 0xf6, 0xd0, 0x14, 0xa9,
+    0xcf, 0xa9, 0x7c, 0xa8, 0x5d, 0x99, 0x62, 0x85, 0x0c, 0x2b, 0xb2, 0xc5, 0x2c, 0xf7, 0x90, 0x30,
+    0x5d, 0x1f, 0xa8, 0x0b, 0xe5, 0xf5, 0x9a, 0x68, 0x5c, 0x1f, 0x8f, 0xd3, 0xe0, 0xa9, 0xf6, 0x2f,
+    0x77, 0x6b, 0xf0, 0xac, 0x1b, 0xde, 0xa2, 0x68, 0xa9, 0x53, 0x3c, 0x5e, 0xb0, 0x6c, 0x2d, 0xff,
+    0x75, 0x9d, 0x60, 0xfc, 0x1d, 0xc9, 0xf8, 0x32, 0xe6, 0x9e, 0x43, 0x5e, 0x41, 0x86, 0xdd, 0xa2,
+    0x98, 0x98, 0xb0, 0x1f, 0x21, 0xe3, 0x66, 0xa9, 0xed, 0x51, 0x39, 0x2b, 0xef, 0x43, 0xa0, 0x73,
+    0x43, 0x44, 0x27, 0x3f, 0x13, 0x85, 0xc6, 0x5a, 0xc0, 0xd6, 0x1d, 0xf6, 0x1a, 0x3d, 0xd2, 0x56,
+    0xef, 0x0f, 0xc9, 0x6a, 0xfa, 0x56, 0x62, 0xcb, 0x71, 0x09, 0x40, 0xbe, 0x5b, 0x34, 0x4a, 0x90,
+    0xac, 0xb6, 0xad, 0x6f, 0xf0, 0x7e, 0xc8, 0x26, 0x01, 0x67, 0x13, 0x33, 0xac, 0x33, 0xc1, 0xd3,
+    0xf3, 0xab, 0xfb, 0x1a, 0x7c, 0xd9, 0xee, 0xec, 0x39, 0x0f, 0xad, 0x45, 0xe0, 0x6c, 0x10, 0x3c,
+    0x8a, 0x88, 0xf2, 0x16, 0x5f, 0x19, 0x91, 0x1d, 0x80, 0xde, 0xc0, 0xb8, 0xf0, 0x2f, 0xf2, 0x47,
+    0x52, 0x1a, 0x0a, 0xe3, 0x33, 0xc1, 0x7e, 0x7d, 0xff, 0xe6, 0xeb, 0x1d, 0xfc, 0xb9, 0xbf, 0x05,
+    0x6f, 0x53, 0x6b, 0x97, 0x6c, 0x11, 0x32, 0xd8, 0x40, 0xc5, 0x82, 0x6d, 0x41, 0x7b, 0x72, 0x85,
+    0xcd, 0x92, 0xc1, 0x19, 0xbf, 0x61, 0x4e, 0x67, 0xd4, 0xbd, 0xfb, 0xef, 0x7f, 0x4e, 0x7f, 0x5b,
+    0x29, 0x3f, 0xbd, 0x78, 0x4f, 0xae, 0xd0, 0x21, 0x1f, 0x2c, 0x63, 0x67, 0x34, 0x1c, 0x92, 0xbe,
+    0x72, 0x0c, 0x4b, 0xd0, 0x85, 0x15, 0x23, 0xb6, 0x73, 0x26, 0xf0, 0xec, 0xbe, 0x5b, 0x94, 0xf5,
+    0xa7, 0x07, 0xdb, 0x4e, 0x27, 0x47, 0xee, 0x0a, 0xc6, 0xde, 0x30, 0x1a, 0x0e, 0x46, 0xc3, 0xf1,
+    0x5e, 0x09, 0xfb, 0x9f, 0x5f, 0x12, 0x1c, 0x24, 0x81, 0x4b, 0x8a, 0x13, 0xa0, 0xea, 0x0c, 0x2f,
+    0xf8, 0x57, 0x66, 0x9a, 0xf0, 0xdb, 0x6a, 0xfe, 0x0c, 0x3e, 0xcd, 0x1f, 0xae, 0xf5, 0x24, 0x21,
+    0x20, 0x8e, 0xe4, 0xff, 0xa7, 0x60, 0x65, 0xa9, 0xa0, 0x7b, 0x87, 0xfb, 0x4f, 0x0f, 0x4a, 0xb2,
+    0x92, 0xf7, 0x2f, 0x1f, 0xe7, 0xb8, 0x3a, 0xa1, 0x90, 0x31, 0x07, 0xbd, 0x94, 0xfc, 0xe6, 0x6e,
+    0x7a, 0xf1, 0x05, 0x23, 0x38, 0x41, 0xd1, 0x1f, 0xa9, 0xcc, 0x48, 0x61, 0xfa, 0x7e, 0xf6, 0x9b,
+    0xe2, 0x8f, 0x6a, 0xac, 0xb1, 0x68, 0xb9, 0x29, 0xe8, 0x82, 0xde, 0xfc, 0x3e, 0x6d, 0xf7, 0x03,
+    0x9e, 0xdb, 0xbc, 0xc4, 0x4b, 0x82, 0x9b, 0x56, 0xa7, 0x6b, 0x62, 0xe4, 0x14, 0x70, 0xe5, 0xa8,
+    0x36, 0xac, 0x53, 0x9b, 0x2d, 0xb6, 0x8c, 0x11, 0x9b, 0x0d, 0x77, 0x0f, 0xaa, 0x88, 0x36, 0xdf,
+    0x50, 0xac, 0xb2, 0xba, 0xb6, 0x9d, 0x28, 0xa7, 0xfb, 0x2d, 0x16, 0x59, 0x09, 0xe2, 0xad, 0x94,
+    0x58, 0xab, 0x96, 0x81, 0xde, 0x89, 0x35, 0xf6, 0x09, 0x56, 0x47, 0x55, 0x4d, 0x5d, 0xc8, 0x15,
+    0x54, 0xbb, 0x72, 0x8b, 0x08, 0xb1, 0xe4, 0x27, 0x4b, 0x4d, 0x48, 0x72, 0xa0, 0xb6, 0xde, 0x11,
+    0x5d, 0xa1, 0x37, 0xb4, 0xaa, 0x55, 0xb3, 0x3d, 0xef, 0x55, 0xe7, 0x48, 0x2c, 0xf5, 0xbd, 0xa3,
+    0xdf, 0x70, 0xd8, 0x1c, 0x2f, 0x5e, 0xd9, 0xc2, 0x83, 0x6d, 0x44, 0xcd, 0x0c, 0x7d, 0x70, 0xd5,
+    0x39, 0xb5, 0x42, 0xc1, 0x70, 0xda, 0x2b, 0xe6, 0xd2, 0xd8, 0x93, 0xa6, 0xd2, 0xb0, 0x40, 0x44,
+    0x19, 0x31, 0x52, 0x40, 0x72, 0x09, 0x05, 0x75, 0x29, 0xac, 0xb2, 0x70, 0xf7, 0x52, 0x00, 0xa2,
+    0xf1, 0x18, 0xbd, 0x66, 0x35, 0x0d, 0xfb, 0x5a, 0x26, 0x04, 0x5b, 0x00, 0xf5, 0x2d, 0xf2, 0x11,
+    0x84, 0xdf, 0x45, 0x59, 0x6b, 0xf9, 0x2c, 0x1b, 0x1a, 0xd8, 0x18, 0xb3, 0x30, 0x34, 0x5c, 0xe2,
+    0x71, 0xbe, 0xcb, 0x84, 0x85, 0x5f, 0xa3, 0x7f, 0x0c, 0xff, 0x69, 0xee, 0x8e, 0xe3, 0x68, 0x97,
+    0xcc, 0xa9, 0xef, 0x78, 0x0c, 0xfd, 0x21, 0xf9, 0xb0, 0x46, 0x13, 0x2b, 0x3b, 0x33, 0x58, 0x24,
+    0xe0, 0x9a, 0xb1, 0x26, 0x55, 0x68, 0xcc, 0x4a, 0x2a, 0xc0, 0x19, 0xb6, 0xc4, 0xe6, 0xfa, 0x6d,
+    0x95, 0x8e, 0x43, 0x63, 0x10, 0x89, 0xfd, 0x80, 0x03, 0x16, 0x5e, 0x4c, 0xb7, 0x98, 0xef, 0x44,
+    0x7f, 0xe1, 0x72, 0xde, 0x69, 0xe3, 0xb1, 0x2f, 0x1e, 0xbb, 0x34, 0x87, 0xae, 0x73, 0x0f, 0xef,
+    0x4b, 0xa4, 0x07, 0xd0, 0x84, 0x62, 0x5b, 0x97, 0x3b, 0xda, 0x71, 0x75, 0x07, 0x51, 0x75, 0xdb,
+    0x75, 0x81, 0x0b, 0x7f, 0x02, 0xc2, 0x93, 0xf0, 0xf5, 0x80, 0x66, 0x8a, 0x2d, 0x81, 0x58, 0xbc,
+    0x4a, 0x36, 0x6b, 0x3e, 0x5b, 0x92, 0xb3, 0xf4, 0x55, 0xb7, 0xae, 0x0c, 0xcc, 0xa2, 0x61, 0x08,
+    0x22, 0x25, 0xe1, 0x06, 0x38, 0x48, 0xb5, 0xb8, 0xf1, 0xc6, 0xb2, 0x70, 0xe0, 0xdb, 0x14, 0xcc,
+    0x0a, 0x60, 0x59, 0x17, 0xb0, 0xf6, 0x98, 0xe7, 0x66, 0x2e, 0x52, 0xe6, 0xff, 0xfa, 0xfe, 0xdd,
+    0x1b, 0x29, 0xc3, 0x4f, 0xec, 0xd7, 0x98, 0x45, 0x46, 0x07, 0xc1, 0xc5, 0x29, 0xe0, 0xb6, 0x3c,
+    0xe6, 0xcf, 0xe4, 0xdc, 0x7c, 0xb2, 0x03, 0x78, 0xad, 0x00, 0x84, 0xed, 0xa4, 0x7d, 0x5a, 0x52,
+    0xda, 0xfd, 0x26, 0xae, 0xf6, 0xb9, 0x07, 0xd2, 0xc6, 0x98, 0x42, 0xf0, 0x04, 0xb1, 0x57, 0x14,
+    0xaf, 0x6b, 0x6a, 0x80, 0xab, 0xee, 0xf7, 0x23, 0x89, 0x99, 0x10, 0x57, 0x75, 0x83, 0x08, 0x93,
+    0x69, 0x56, 0xe0, 0xe7, 0xf7, 0x81, 0x26, 0xf5, 0x4e, 0x95, 0x9f, 0x76, 0xa5, 0x4a, 0x39, 0x0d,
+    0x16, 0xe0, 0x9f, 0xd8, 0xa2, 0xaf, 0x3b, 0xf8, 0x5a, 0x2d, 0x41, 0x98, 0x94, 0x81, 0x38, 0xc5,
+    0x63, 0x92, 0x29, 0x32, 0x16, 0xd2, 0x86, 0x24, 0x3c, 0x40, 0x0f, 0x05, 0xbd, 0x78, 0x5d, 0xf2,
+    0x07, 0xbc, 0x62, 0xf4, 0xbc, 0x16, 0xd7, 0x9a, 0xfc, 0x98, 0x5d, 0x68, 0x00, 0x83, 0x50, 0xf7,
+    0x2b, 0xac, 0xe4, 0x8e, 0xd1, 0xa4, 0x42, 0xfd, 0x67, 0xd2, 0xfe, 0xa9, 0x6d, 0x26, 0x73, 0x57,
+    0x55, 0xdd, 0x73, 0xb3, 0xee, 0x02, 0x5f, 0x95, 0x0e, 0x93, 0xdc, 0xef, 0x3b, 0xdd, 0x06, 0xa5,
+    0xe1, 0x8c, 0xf4, 0xda, 0xe9, 0x64, 0x32, 0x21, 0xe3, 0xe1, 0xb0, 0x49, 0x69, 0xa5, 0x52, 0x25,
+    0xf3, 0xec, 0x44, 0x48, 0x50, 0x58, 0x7a, 0x5d, 0xd3, 0x8d, 0x3d, 0xef, 0xd6, 0x22, 0xaf, 0xd4,
+    0x3f, 0x5f, 0x21, 0x4b, 0xee, 0x79, 0xe0, 0xd4, 0x58, 0xad, 0x59, 0x96, 0x85, 0xae, 0x9f, 0x82,
+    0x99, 0x9c, 0xbf, 0x70, 0x7c, 0xfd, 0x89, 0x41, 0xa1, 0x42, 0xf2, 0xf5, 0xc7, 0xdb, 0x61, 0xd4,
+    0x95, 0x4c, 0x20, 0x0f, 0x42, 0x12, 0x87, 0x79, 0xf4, 0xb6, 0x9e, 0x4f, 0x26, 0x2f, 0xf9, 0x82,
+    0x05, 0xb1, 0xec, 0x74, 0x1a, 0xac, 0xe6, 0xb1, 0xeb, 0xd7, 0x1e, 0xd6, 0x2d, 0x57, 0x72, 0x86,
+    0x81, 0xea, 0x1c, 0xd6, 0x88, 0xd9, 0xe0, 0x52, 0x55, 0x5d, 0x27, 0xa5, 0x1a, 0x71, 0x55, 0x75,
+    0x98, 0x54, 0x82, 0xb8, 0x70, 0x59, 0x7b, 0xea, 0x12, 0xea, 0xe2, 0xa6, 0x98, 0x7a, 0x5f, 0x03,
+    0x4a, 0xee, 0xfc, 0x6e, 0x60, 0x41, 0xb5, 0x3c, 0x36, 0x86, 0x78, 0x13, 0xe1, 0x2a, 0x26, 0xee,
+    0xcf, 0xf2, 0xec, 0x91, 0x5a, 0x0e, 0x57, 0xa5, 0xf7, 0x73, 0x23, 0xd7, 0x11, 0x06, 0xf7, 0x2c,
+    0xd8, 0x77, 0x1f, 0x53, 0x83, 0x1b, 0x94, 0xbd, 0xb5, 0xce, 0x66, 0xe5, 0xae, 0xcd, 0x96, 0x5b,
+    0x9b, 0x61, 0x86, 0x79, 0x90, 0x50, 0x32, 0x1c, 0xe2, 0x6d, 0x72, 0x94, 0xb7, 0xf6, 0x40, 0x6f,
+    0xf3, 0x83, 0xbd, 0xde, 0xa6, 0xd6, 0xb8, 0x49, 0x77, 0x15, 0x23, 0x56, 0xde, 0x93, 0x0d, 0xbe,
+    0xd4, 0x99, 0xe5, 0x43, 0x3a, 0xb9, 0x9a, 0x15, 0xa8, 0x2d, 0x66, 0xba, 0xe0, 0x18, 0x97, 0x1f,
+    0x1c, 0xce, 0x2a, 0xa1, 0xc8, 0x0b, 0x12, 0xf5, 0x80, 0xf7, 0x26, 0xfb, 0xaf, 0x1e, 0x5e, 0xf7,
+    0x1d, 0xde, 0x2f, 0xeb, 0x66, 0x32, 0xa2, 0x34, 0xf7, 0x93, 0x11, 0x55, 0x88, 0xe3, 0x99, 0x70,
+    0xf5, 0xe1, 0x5e, 0xce, 0x45, 0xb0, 0x54, 0xe5, 0xc9, 0x6b, 0x34, 0xf7, 0xf2, 0xac, 0x07, 0x05,
+    0x35, 0x1d, 0x63, 0xf1, 0x24, 0x33, 0xb9, 0x71, 0x96, 0xdb, 0xef, 0x3d, 0xc2, 0xd8, 0x56, 0xb6,
+    0xdb, 0x3a, 0xfd, 0xed, 0x6d, 0xb7, 0x57, 0xe4, 0x72, 0x3c, 0xd8, 0xac, 0x30, 0x6f, 0xbb, 0x93,
+    0x54, 0xfc, 0x7a, 0xfd, 0xfd, 0x9f, 0x04, 0x50, 0x67, 0xa5, 0x34, 0xbd, 0xd4, 0xa2, 0x48, 0x69,
+    0x37, 0x81, 0xab, 0x8d, 0xd7, 0x07, 0x28, 0xfd, 0xf1, 0xbc, 0x22, 0xad, 0x09, 0x7e, 0xfc, 0xa6,
+    0x1a, 0x2b, 0x9f, 0x0d, 0xb7, 0x70, 0xd3, 0xfb, 0x69, 0xc7, 0x83, 0xe4, 0xfe, 0xed, 0xf1, 0x20,
+    0xf9, 0x17, 0xb1, 0xff, 0x03, 0x1d, 0x6e, 0xe7, 0x40, 0x22, 0x3b, 0x00, 0x00,
+};
+
+#else
+#define OTAWEBUI_ETAG "\"ea64ca6ad9b96bb6\""
+#define OTAWEBUI_SIZE 3153
+const uint8_t OTAWEBUI_HTML_GZ[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xcd, 0x1b, 0x69, 0x73, 0xdb, 0xb8,
+    0xf5, 0xbb, 0x7f, 0x05, 0x56, 0xd9, 0x1d, 0x49, 0x5d, 0x89, 0x3a, 0x7c, 0xc4, 0x71, 0x2c, 0x4f,
+    0x13, 0x27, 0x9e, 0xa4, 0xcd, 0xe1, 0x89, 0xed, 0xed, 0x35, 0x9d, 0x06, 0x22, 0x41, 0x09, 0x0d,
+    0x45, 0x72, 0x41, 0xd0, 0xb2, 0x93, 0xf1, 0x7f, 0xea, 0x6f, 0xe8, 0x2f, 0xeb, 0x7b, 0xe0, 0x21,
+    0x12, 0x04, 0x29, 0xd9, 0x56, 0xba, 0xab, 0x9d, 0x6c, 0x24, 0xe0, 0xe1, 0x5d, 0x78, 0x17, 0x1e,
+    0x90, 0xe3, 0x1f, 0x5e, 0x7d, 0x3c, 0xbd, 0xfc, 0xdb, 0xf9, 0x6b, 0x32, 0x97, 0x0b, 0xef, 0x64,
+    0xe7, 0x18, 0xff, 0x22, 0x1e, 0xf5, 0x67, 0x93, 0x16, 0xf3, 0x5b, 0x38, 0xc0, 0xa8, 0x73, 0xb2,
+    0x43, 0xe0, 0x73, 0xbc, 0x60, 0x92, 0x12, 0x7b, 0x4e, 0x45, 0xc4, 0xe4, 0xa4, 0x75, 0x75, 0x79,
+    0xd6, 0x3f, 0x6c, 0x15, 0xa7, 0x7c, 0xba, 0x60, 0x93, 0xd6, 0x35, 0x67, 0xcb, 0x30, 0x10, 0xb2,
+    0x45, 0xec, 0xc0, 0x97, 0xcc, 0x07, 0xd0, 0x25, 0x77, 0xe4, 0x7c, 0xe2, 0xb0, 0x6b, 0x6e, 0xb3,
+    0xbe, 0xfa, 0xd1, 0x23, 0xdc, 0xe7, 0x92, 0x53, 0xaf, 0x1f, 0xd9, 0xd4, 0x63, 0x93, 0x91, 0x35,
+    0xcc, 0x50, 0x49, 0x2e, 0x3d, 0x76, 0xf2, 0xfa, 0xe2, 0x7c, 0x77, 0x4c, 0x3e, 0x5e, 0xbe, 0x20,
+    0x57, 0xa1, 0x43, 0x25, 0x13, 0xc7, 0x83, 0x64, 0x22, 0x01, 0x8a, 0xe4, 0x6d, 0xf6, 0x1d, 0x3f,
+    0x47, 0x22, 0x08, 0x24, 0xf9, 0x96, 0xff, 0xc6, 0x4f, 0xbf, 0x1f, 0x0a, 0xbe, 0xa0, 0xe2, 0xb6,
+    0x6f, 0x07, 0x5e, 0x20, 0x8e, 0xc8, 0x93, 0xf1, 0xfe, 0xc1, 0x2e, 0x9b, 0x3e, 0xd7, 0xa0, 0xa2,
+    0xd8, 0xb6, 0x59, 0x14, 0xe5, 0x50, 0xa3, 0x03, 0xba, 0xbb, 0x47, 0x75, 0xa8, 0x25, 0x15, 0x3e,
+    0xf7, 0x67, 0x39, 0x94, 0x4d, 0x0f, 0xe9, 0x70, 0x4f, 0x87, 0x62, 0x42, 0x04, 0x22, 0x87, 0x71,
+    0xec, 0xf1, 0xc1, 0xf8, 0x40, 0x87, 0x99, 0xae, 0x90, 0xb8, 0x87, 0x2e, 0x75, 0x6d, 0x1d, 0xc0,
+    0xa6, 0xc2, 0x01, 0x28, 0x9c, 0x57, 0x1f, 0x7d, 0x5e, 0xb2, 0x1b, 0xb9, 0xe2, 0x96, 0x8d, 0x9f,
+    0xed, 0x56, 0x64, 0x9a, 0x06, 0xc2, 0x61, 0x2b, 0x46, 0xd8, 0x98, 0x1d, 0xba, 0xc3, 0x15, 0xd0,
+    0xdd, 0x4e, 0xfe, 0x75, 0x1a, 0x38, 0xb7, 0x9a, 0xe2, 0x5c, 0xd8, 0xb6, 0xbe, 0x4b, 0x17, 0xdc,
+    0xbb, 0x3d, 0x22, 0xd1, 0x6d, 0x24, 0xd9, 0xa2, 0x1f, 0xf3, 0x1e, 0xe9, 0xd3, 0x30, 0xf4, 0x58,
+    0x3f, 0x19, 0xe9, 0x91, 0x88, 0xfa, 0x51, 0x3f, 0x62, 0x82, 0x6b, 0x0c, 0x4e, 0xa9, 0xfd, 0x65,
+    0x26, 0x82, 0xd8, 0x77, 0x8e, 0xc8, 0x35, 0x15, 0x9d, 0x95, 0xc4, 0xdd, 0x32, 0x60, 0xca, 0x5d,
+    0x02, 0xb3, 0x12, 0x4a, 0x83, 0x82, 0x1d, 0x9c, 0x71, 0xff, 0x88, 0x0c, 0xcb, 0xc3, 0x21, 0x75,
+    0x1c, 0xd8, 0x8f, 0x23, 0x32, 0x3a, 0x08, 0x6f, 0xca, 0x53, 0x1e, 0xf7, 0x59, 0x7f, 0xce, 0xf8,
+    0x6c, 0x2e, 0x61, 0xda, 0xda, 0x37, 0xca, 0x6d, 0xa1, 0x71, 0x52, 0x80, 0x14, 0x9a, 0xf4, 0x0b,
+    0x7a, 0x93, 0x98, 0xe8, 0x11, 0x39, 0x1c, 0x0e, 0x75, 0xdc, 0x39, 0x37, 0x84, 0xc6, 0x32, 0xa8,
+    0xc1, 0x0c, 0xfb, 0xa7, 0x21, 0xad, 0xea, 0x24, 0xdd, 0x64, 0x4d, 0xd8, 0x74, 0xdf, 0x04, 0x75,
+    0x78, 0x1c, 0x01, 0x03, 0x3a, 0xf9, 0x06, 0xa9, 0x13, 0xce, 0x60, 0xe7, 0xa5, 0x0c, 0x16, 0x26,
+    0x80, 0x69, 0x70, 0xd3, 0x8f, 0xe6, 0xd4, 0x09, 0x96, 0xc8, 0xfe, 0x28, 0xbc, 0x21, 0xbb, 0xf0,
+    0x47, 0xcc, 0xa6, 0xb4, 0x33, 0xec, 0xa9, 0xff, 0xac, 0x91, 0x91, 0x9d, 0x23, 0x05, 0x1c, 0x05,
+    0x1e, 0x77, 0xb2, 0x0d, 0x2d, 0x98, 0x57, 0xd7, 0xa8, 0x84, 0xf9, 0xa8, 0x47, 0xe6, 0xe3, 0x8a,
+    0x6a, 0x33, 0xe5, 0x0d, 0x15, 0x7f, 0xfa, 0x9e, 0xae, 0x37, 0x88, 0xa2, 0x9a, 0xe3, 0xd0, 0x0b,
+    0xa8, 0xd3, 0xff, 0x1a, 0xf8, 0x4c, 0xd7, 0x76, 0xca, 0xf6, 0x18, 0x48, 0x38, 0x34, 0x9a, 0xb3,
+    0x35, 0x7c, 0xdf, 0x4b, 0xf3, 0xbb, 0x63, 0x7d, 0x4a, 0x71, 0x4a, 0x3d, 0x3e, 0x03, 0xd1, 0x6c,
+    0x88, 0x77, 0x4c, 0x68, 0x62, 0xc5, 0x22, 0x42, 0xb9, 0xc2, 0x80, 0x57, 0x27, 0xa5, 0x00, 0x37,
+    0x82, 0x48, 0x18, 0xc0, 0x62, 0xea, 0x79, 0x64, 0x68, 0x8d, 0xa3, 0xb5, 0xf2, 0x1e, 0xcd, 0x83,
+    0xeb, 0x8a, 0xe1, 0x96, 0x7d, 0x3e, 0x11, 0xb8, 0x14, 0x01, 0xbb, 0xf5, 0x7e, 0x5a, 0x89, 0x44,
+    0x35, 0x84, 0x2d, 0x47, 0xd0, 0x59, 0x7f, 0xdb, 0xc4, 0x99, 0xeb, 0x1e, 0x14, 0xc3, 0x5c, 0x31,
+    0x3c, 0xc5, 0x60, 0xce, 0xfe, 0x5a, 0x6f, 0x6a, 0x22, 0x95, 0xf2, 0xb4, 0x9c, 0x73, 0xc9, 0xcc,
+    0xe6, 0xed, 0x83, 0x64, 0x35, 0xbb, 0x0d, 0x76, 0x60, 0x74, 0xa5, 0x92, 0xb1, 0xec, 0xe9, 0xf3,
+    0x8d, 0x3b, 0xae, 0xc2, 0x6b, 0xc4, 0xbf, 0x32, 0x70, 0x04, 0xeb, 0xf0, 0xe9, 0xbe, 0x60, 0x8b,
+    0x7a, 0x93, 0x08, 0x42, 0x6a, 0x73, 0x79, 0x5b, 0x6f, 0x16, 0x89, 0x82, 0x8c, 0x06, 0x91, 0xae,
+    0x45, 0x32, 0xcf, 0x9a, 0xd6, 0x3a, 0x3c, 0xa2, 0x53, 0x8f, 0x39, 0xf5, 0xcb, 0xf7, 0xcd, 0xe2,
+    0xf9, 0x01, 0xda, 0xbd, 0x17, 0x2c, 0x99, 0x63, 0xb6, 0x9c, 0x48, 0x52, 0x19, 0x47, 0x1a, 0xde,
+    0xa2, 0x6e, 0xef, 0xa7, 0xd6, 0x2c, 0x7e, 0x1c, 0x56, 0x43, 0x07, 0xc8, 0x10, 0x7a, 0xf4, 0x56,
+    0xdf, 0xcb, 0x2a, 0x33, 0x96, 0x4a, 0xd1, 0x0d, 0x06, 0xf5, 0xc4, 0x65, 0x90, 0x2e, 0xc7, 0x46,
+    0x1b, 0x7a, 0xf2, 0xec, 0xd9, 0x68, 0x3a, 0x9a, 0xd6, 0x90, 0x9e, 0x7a, 0x81, 0xfd, 0xa5, 0x91,
+    0x76, 0x5a, 0x6a, 0x34, 0x51, 0x77, 0x6c, 0xd7, 0x66, 0x4f, 0xcd, 0xd4, 0x47, 0x07, 0x07, 0xfb,
+    0xbb, 0x7b, 0x0f, 0xa6, 0xce, 0x7d, 0x37, 0x68, 0x22, 0xcd, 0x86, 0xee, 0xd8, 0x65, 0x66, 0xd2,
+    0xc3, 0xa7, 0xfb, 0xcf, 0x0e, 0xf7, 0xef, 0x4f, 0x7a, 0x26, 0xb8, 0x6e, 0x57, 0xf9, 0x32, 0x9c,
+    0x2b, 0x63, 0xc4, 0x11, 0x08, 0xfc, 0x0b, 0x98, 0x97, 0x0c, 0x9d, 0x39, 0x5e, 0xf8, 0x60, 0x08,
+    0x82, 0x85, 0x8c, 0xca, 0x0e, 0x66, 0xdc, 0xbe, 0xcb, 0x65, 0x8f, 0x2c, 0xb8, 0x0f, 0x69, 0xba,
+    0x33, 0xc6, 0xfc, 0xdc, 0x23, 0x23, 0x57, 0x74, 0x35, 0x9f, 0x9f, 0xd1, 0xb0, 0x21, 0x47, 0xca,
+    0xa0, 0x32, 0xab, 0xab, 0xab, 0xbf, 0x26, 0x89, 0x1b, 0x4b, 0xb7, 0x55, 0x76, 0x1e, 0xaf, 0x31,
+    0xed, 0x9a, 0x88, 0xf2, 0x90, 0x4c, 0x9b, 0xb0, 0xab, 0x6a, 0x63, 0x53, 0x1d, 0xd7, 0x14, 0x68,
+    0xb2, 0xcd, 0x3d, 0xd8, 0x7b, 0xba, 0x77, 0x38, 0x6d, 0x2c, 0x27, 0xf6, 0x1a, 0x95, 0x75, 0x4d,
+    0xbd, 0xd8, 0x48, 0x7d, 0x99, 0x56, 0x61, 0xfb, 0x43, 0x73, 0xf5, 0x69, 0x85, 0x22, 0x98, 0x09,
+    0xac, 0xbe, 0xa7, 0x54, 0x77, 0xca, 0xb4, 0x08, 0x1b, 0x0d, 0x87, 0x3f, 0x95, 0x59, 0xcb, 0x4a,
+    0xbb, 0x4a, 0x7c, 0x28, 0x5b, 0xb3, 0x56, 0xf3, 0x1a, 0x76, 0xa1, 0xb2, 0x4b, 0x18, 0x44, 0x5d,
+    0x0f, 0x0b, 0xa4, 0x39, 0x77, 0x1c, 0xe6, 0x3f, 0xc4, 0x7a, 0x4a, 0x12, 0xe5, 0xbf, 0xcc, 0xb2,
+    0xd5, 0x49, 0x56, 0x95, 0xf9, 0x7e, 0x29, 0xaf, 0x98, 0x41, 0x14, 0x29, 0x30, 0x80, 0xdd, 0x88,
+    0x30, 0x1a, 0x99, 0x63, 0x23, 0xf7, 0xc3, 0x58, 0x6e, 0x1c, 0xa6, 0x4b, 0x61, 0xb8, 0x36, 0x3b,
+    0x6e, 0x6c, 0xcb, 0x9b, 0x44, 0x7e, 0x55, 0xbb, 0xf2, 0xaf, 0x8a, 0x9f, 0x14, 0x16, 0x86, 0x8c,
+    0xb2, 0x3c, 0x89, 0x96, 0x5c, 0xda, 0xf3, 0x73, 0x2a, 0xa4, 0xd2, 0xc0, 0x4b, 0xb9, 0xbe, 0x7c,
+    0x28, 0x1d, 0xee, 0xea, 0xdc, 0x6c, 0x01, 0xa9, 0x4e, 0x55, 0xa5, 0xdb, 0x72, 0xb3, 0xbb, 0xe4,
+    0x28, 0x3b, 0x48, 0xcf, 0xb2, 0xc7, 0x83, 0xe4, 0xa8, 0x7d, 0x8c, 0x47, 0xb2, 0xf4, 0x98, 0xeb,
+    0xf0, 0x6b, 0x62, 0x7b, 0x34, 0x8a, 0x26, 0xad, 0xfc, 0xbc, 0xd2, 0x5a, 0x1d, 0x7b, 0x4b, 0xf3,
+    0x10, 0xb0, 0x0a, 0x53, 0x6a, 0x7a, 0x3e, 0x32, 0x9d, 0xa3, 0x61, 0xb4, 0x0c, 0x86, 0x58, 0xb8,
+    0x33, 0x69, 0x25, 0x79, 0xa2, 0x75, 0x72, 0x3c, 0x80, 0x91, 0x32, 0x8c, 0x79, 0x41, 0x52, 0x19,
+    0xfe, 0x1d, 0x52, 0x6e, 0x2b, 0x63, 0xa3, 0x50, 0x2c, 0x6a, 0xdc, 0x64, 0x2b, 0x4f, 0x5e, 0x41,
+    0x0d, 0x49, 0xa8, 0xef, 0x10, 0x47, 0x04, 0x21, 0x71, 0xb9, 0x58, 0x80, 0xfe, 0x19, 0x7c, 0x81,
+    0x08, 0x36, 0x67, 0xf0, 0x0d, 0xf2, 0xb3, 0xed, 0x71, 0xfb, 0x0b, 0x91, 0x01, 0x89, 0x98, 0xc7,
+    0x6c, 0x69, 0xe0, 0x48, 0xa1, 0x4b, 0x0c, 0x57, 0xde, 0x86, 0x6c, 0xd2, 0xc2, 0xf5, 0x2d, 0xc5,
+    0x16, 0x7e, 0x7b, 0x8b, 0x33, 0x2d, 0xa2, 0x74, 0x3b, 0x69, 0x95, 0xca, 0x83, 0x16, 0xa1, 0x90,
+    0x86, 0x43, 0x39, 0x69, 0x59, 0x53, 0xee, 0xd7, 0x70, 0x99, 0xc9, 0x53, 0x74, 0x67, 0x03, 0x68,
+    0x1d, 0x78, 0xab, 0xa0, 0x9f, 0xf3, 0x6c, 0xec, 0xa4, 0x4e, 0x8c, 0xea, 0x70, 0x3a, 0x54, 0x1e,
+    0xf3, 0xe8, 0x94, 0x79, 0x60, 0x6f, 0x62, 0xd2, 0x0a, 0x24, 0x3d, 0x07, 0x82, 0xcb, 0x00, 0x37,
+    0xbd, 0xf3, 0x31, 0x44, 0x4b, 0xa7, 0x5e, 0x57, 0x6d, 0x74, 0x36, 0x71, 0x74, 0x3c, 0x50, 0x2b,
+    0x34, 0xcc, 0x45, 0x9d, 0xa1, 0x39, 0x27, 0xac, 0x16, 0x11, 0x42, 0xc2, 0xfd, 0x35, 0xe6, 0x82,
+    0x39, 0x05, 0x4b, 0xd3, 0xf8, 0x59, 0x6b, 0x79, 0xe3, 0x93, 0xb3, 0x6c, 0x63, 0xdf, 0x42, 0xdd,
+    0x21, 0x16, 0x14, 0x59, 0x04, 0xe3, 0x1b, 0xd7, 0x18, 0x5f, 0x66, 0x07, 0x08, 0x6d, 0xd4, 0xd4,
+    0x71, 0x7a, 0x16, 0x50, 0x96, 0x5a, 0xf1, 0xf1, 0x16, 0x09, 0x7c, 0x65, 0x34, 0x95, 0xc9, 0x4e,
+    0xb7, 0x75, 0x72, 0xa1, 0x86, 0xc8, 0x0b, 0x5b, 0xf2, 0x6b, 0x46, 0xf2, 0xa9, 0xe3, 0x41, 0x82,
+    0xf3, 0x51, 0x72, 0x5e, 0xa8, 0x7e, 0xc8, 0x86, 0x52, 0x26, 0xcd, 0x13, 0x25, 0x63, 0x86, 0x16,
+    0x8b, 0x9e, 0x8a, 0xc0, 0x85, 0x9f, 0x45, 0x96, 0x8e, 0x23, 0x5b, 0xf0, 0x50, 0xae, 0xe0, 0x20,
+    0x2a, 0x44, 0x92, 0xbc, 0x38, 0x7f, 0xfb, 0xaf, 0x97, 0x2f, 0x2e, 0x5e, 0x93, 0x09, 0x69, 0x0f,
+    0x68, 0xc8, 0x07, 0xb0, 0x9b, 0xed, 0x55, 0xa0, 0xc9, 0xbf, 0x0c, 0x06, 0xc0, 0xa6, 0x6a, 0xbb,
+    0x41, 0xb8, 0x22, 0x72, 0xce, 0x20, 0xca, 0xcf, 0xd8, 0xce, 0x2a, 0x2b, 0xf9, 0x4e, 0xb0, 0xb4,
+    0x20, 0xf0, 0xbf, 0xbe, 0x86, 0x73, 0xec, 0x3b, 0x0e, 0xbc, 0x42, 0xc0, 0xe9, 0xb4, 0xd1, 0x8a,
+    0xdb, 0x3d, 0xd2, 0xe9, 0x92, 0xc9, 0x89, 0x16, 0xfd, 0x70, 0xea, 0xac, 0xb0, 0x75, 0x1d, 0x2d,
+    0xb2, 0xe3, 0xfc, 0x45, 0x2e, 0xb4, 0x3e, 0x1b, 0x31, 0x19, 0x87, 0x67, 0xe0, 0xae, 0x57, 0xca,
+    0x53, 0xf4, 0x69, 0xee, 0x92, 0x8e, 0x13, 0xd8, 0xf1, 0x02, 0xb8, 0xb1, 0x66, 0x4c, 0xbe, 0xf6,
+    0x18, 0x7e, 0x7d, 0x79, 0xfb, 0xd6, 0xe9, 0xb4, 0x41, 0x74, 0x97, 0xcf, 0x62, 0xa1, 0x54, 0xde,
+    0xee, 0x76, 0x09, 0x00, 0x9c, 0xaa, 0xb1, 0x22, 0x9a, 0x3b, 0xf8, 0x9e, 0xff, 0xa0, 0xd1, 0xad,
+    0x6f, 0x13, 0x37, 0xf6, 0x6d, 0x5c, 0x53, 0x5c, 0xa0, 0x49, 0x25, 0x85, 0xde, 0x14, 0x5b, 0x29,
+    0x1b, 0x5c, 0x39, 0x84, 0x2f, 0x0c, 0x94, 0x4d, 0x97, 0x94, 0x4b, 0xe2, 0x32, 0xb0, 0xad, 0xce,
+    0xe7, 0x1f, 0xbf, 0x65, 0xdb, 0x70, 0x37, 0x48, 0x78, 0xfb, 0xac, 0x89, 0xb3, 0xc2, 0x01, 0x91,
+    0x98, 0xe6, 0xeb, 0x33, 0x84, 0xd6, 0xbf, 0x23, 0xb4, 0xd6, 0xe7, 0x3b, 0x35, 0x8b, 0x58, 0x22,
+    0x3d, 0xac, 0xdb, 0x54, 0x27, 0x55, 0xf2, 0xa8, 0xd1, 0x14, 0x4f, 0xd7, 0x20, 0x21, 0x7e, 0xd2,
+    0x69, 0x38, 0x2e, 0xc0, 0xde, 0xbf, 0xb9, 0x7c, 0xff, 0x0e, 0x08, 0x7e, 0x5e, 0x1b, 0xf8, 0x12,
+    0x2b, 0x36, 0x82, 0x95, 0x01, 0xf3, 0xea, 0xba, 0x16, 0xda, 0xb8, 0x42, 0x15, 0xb8, 0xad, 0x93,
+    0x17, 0x70, 0x06, 0x40, 0x27, 0xb3, 0xd3, 0x74, 0x46, 0xae, 0x3e, 0xbd, 0xab, 0x89, 0xaa, 0x0d,
+    0xc8, 0x54, 0xbd, 0xda, 0x48, 0xbf, 0x36, 0x4e, 0x4e, 0xa1, 0x86, 0xba, 0x12, 0x5e, 0x8b, 0x28,
+    0x1c, 0x93, 0xd6, 0x8f, 0xdf, 0x70, 0x2f, 0xad, 0x74, 0xf8, 0xae, 0x59, 0xa8, 0x26, 0x46, 0x9b,
+    0x27, 0xbf, 0x9f, 0x02, 0xdf, 0x62, 0x87, 0x02, 0x84, 0x81, 0x22, 0x90, 0xbc, 0xe7, 0x7e, 0x2c,
+    0x59, 0xf4, 0x7f, 0x50, 0xa8, 0x1f, 0x2f, 0xa6, 0x50, 0xca, 0x28, 0x95, 0xf2, 0x94, 0x83, 0x5f,
+    0x98, 0x88, 0xc0, 0x6c, 0x4f, 0xe7, 0xcc, 0xfe, 0xa2, 0xeb, 0xd7, 0x04, 0xf3, 0x7d, 0x94, 0x5d,
+    0x33, 0xf5, 0xb9, 0xea, 0x4b, 0x77, 0x18, 0x4f, 0x99, 0x07, 0x91, 0xe0, 0xc3, 0x2f, 0x17, 0x24,
+    0xeb, 0xa2, 0xec, 0x94, 0x41, 0x6c, 0x8a, 0x89, 0xa7, 0xa3, 0xba, 0x0e, 0x26, 0x8f, 0x8b, 0xe6,
+    0xc1, 0xf2, 0x42, 0xd5, 0x5d, 0x9d, 0xf6, 0x19, 0xe5, 0xd8, 0x86, 0x81, 0xaa, 0x07, 0x83, 0x21,
+    0x49, 0x9c, 0x59, 0xf7, 0xe2, 0x3b, 0x53, 0x75, 0xaa, 0x05, 0xb6, 0x88, 0x5e, 0x33, 0x63, 0x64,
+    0xab, 0xc6, 0xb5, 0x7b, 0xc7, 0xb4, 0x5e, 0x45, 0x88, 0x05, 0x93, 0xf3, 0x00, 0x6a, 0xe9, 0xf6,
+    0xf9, 0xc7, 0x8b, 0xcb, 0x76, 0x4f, 0x9b, 0xc5, 0xa2, 0x16, 0x36, 0xed, 0xc8, 0x20, 0x7b, 0xfb,
+    0x34, 0xb9, 0x20, 0xea, 0x5f, 0x82, 0x4d, 0xb4, 0x01, 0x01, 0x5e, 0x30, 0x70, 0x5b, 0x05, 0xaf,
+    0x01, 0x06, 0xc3, 0xb6, 0xb6, 0xe4, 0x4e, 0x47, 0x8e, 0xa5, 0xf2, 0x11, 0xf9, 0xd3, 0xc5, 0xc7,
+    0x0f, 0x70, 0x10, 0x15, 0x50, 0xc2, 0x73, 0xf7, 0xb6, 0x53, 0x25, 0x94, 0x7a, 0xe7, 0x51, 0x7d,
+    0xe0, 0x4c, 0x21, 0xda, 0x5d, 0x4b, 0xd9, 0x5d, 0xaf, 0x1a, 0x38, 0x0d, 0x06, 0xd8, 0x80, 0xcf,
+    0x04, 0x9e, 0x21, 0xd7, 0x85, 0xea, 0xee, 0xd4, 0xfe, 0x5c, 0x67, 0x3f, 0x66, 0xeb, 0xc1, 0xed,
+    0x37, 0x5a, 0xcf, 0x26, 0xb6, 0x53, 0x4d, 0xe8, 0x5b, 0xce, 0x8d, 0x59, 0xa1, 0x37, 0xc0, 0x7e,
+    0xd4, 0x43, 0x53, 0xa4, 0xbe, 0xa6, 0x32, 0x50, 0xbb, 0x33, 0xc5, 0x3a, 0x13, 0x76, 0x64, 0x8b,
+    0x59, 0xee, 0x21, 0x61, 0xba, 0x3e, 0x50, 0x17, 0x8a, 0xd4, 0x35, 0xd1, 0xb8, 0x3e, 0x1e, 0xa7,
+    0xc1, 0x53, 0x9d, 0x02, 0xee, 0xd6, 0xe0, 0x59, 0x37, 0xbd, 0x45, 0xd1, 0x52, 0xa7, 0x78, 0xbc,
+    0x60, 0xd9, 0x5e, 0xfe, 0xeb, 0x3a, 0xc1, 0xf8, 0x3b, 0x92, 0xf1, 0x65, 0xcc, 0x3d, 0x87, 0xbc,
+    0x82, 0x0c, 0xbb, 0x45, 0x31, 0x31, 0x61, 0x3f, 0x42, 0xc6, 0xcd, 0x52, 0xdb, 0xa3, 0x72, 0x56,
+    0x7e, 0x9a, 0x47, 0xe7, 0x86, 0x88, 0x4e, 0x7e, 0x26, 0x0a, 0x8d, 0xb5, 0x80, 0x03, 0x30, 0x9c,
+    0x35, 0x7a, 0xa4, 0xad, 0x7e, 0x3f, 0x24, 0xab, 0xe9, 0x47, 0x89, 0x2d, 0xc7, 0x25, 0x00, 0xf9,
+    0x6e, 0xd1, 0x28, 0x41, 0xb2, 0x3a, 0xfc, 0xbd, 0xc1, 0x57, 0x16, 0x9b, 0x04, 0x9c, 0x4d, 0xcc,
+    0xb0, 0xce, 0x04, 0x4f, 0xcf, 0xaf, 0xee, 0x6b, 0xf0, 0x65, 0xbb, 0xb3, 0xe7, 0x3c, 0xb4, 0x16,
+    0x81, 0xb3, 0x41, 0xf0, 0x28, 0x22, 0xca, 0x1b, 0x65, 0x65, 0x44, 0x76, 0x00, 0x7a, 0x03, 0xe3,
+    0xc2, 0xbf, 0xc8, 0x1f, 0x49, 0x69, 0x2a, 0x8c, 0xcf, 0x04, 0xfb, 0xf5, 0xfd, 0x9b, 0xaf, 0x77,
+    0xf0, 0xe7, 0xfe, 0x16, 0xbc, 0x4d, 0xad, 0x5d, 0xb2, 0x45, 0xc8, 0xe0, 0x00, 0x15, 0x0b, 0xb6,
+    0x05, 0xed, 0xc9, 0x15, 0x36, 0x4b, 0x06, 0x67, 0xfc, 0x86, 0x39, 0x9d, 0x51, 0xf7, 0xee, 0xbf,
+    0xff, 0x39, 0xfd, 0x6d, 0xa5, 0xfc, 0xf4, 0xe2, 0x3d, 0xb9, 0x42, 0x87, 0x7c, 0xb0, 0x8c, 0x9d,
+    0xd1, 0x70, 0x48, 0xfa, 0xca, 0x31, 0x2c, 0x41, 0x17, 0x56, 0x8c, 0xd8, 0xce, 0x99, 0xc0, 0x1b,
+    0xf0, 0x6e, 0x51, 0xd6, 0x9f, 0x1e, 0x6c, 0x3b, 0x9d, 0x1c, 0xb9, 0x2b, 0x18, 0x7b, 0xc3, 0x68,
+    0x38, 0x18, 0x0d, 0xc7, 0x7b, 0x25, 0xec, 0x7f, 0x7e, 0x49, 0x70, 0x92, 0x04, 0x2e, 0x29, 0x2e,
+    0x80, 0xaa, 0x33, 0xbc, 0xe0, 0x5f, 0x99, 0x69, 0xc1, 0x6f, 0xab, 0xf9, 0x33, 0x18, 0x9a, 0x3f,
+    0x5c, 0xeb, 0x49, 0x42, 0x40, 0x1c, 0xc9, 0xff, 0x4f, 0xc1, 0xca, 0x52, 0x41, 0xf7, 0x0e, 0xf7,
+    0x9f, 0x1e, 0x94, 0x64, 0x25, 0xef, 0x5f, 0x3e, 0xce, 0x71, 0x75, 0x42, 0x21, 0x63, 0x0e, 0x7a,
+    0x29, 0xf9, 0xcd, 0xdd, 0xf4, 0xe2, 0x0b, 0x46, 0x70, 0x82, 0xa2, 0x3f, 0x52, 0x99, 0x91, 0xc2,
+    0xf4, 0xfd, 0xec, 0x37, 0xc5, 0x1f, 0xd5, 0x58, 0x63, 0xd1, 0x72, 0x53, 0xd0, 0x05, 0xbd, 0xf9,
+    0x7d, 0xda, 0xee, 0x07, 0xbc, 0xfd, 0x78, 0x89, 0x4f, 0xed, 0x36, 0xad, 0x4e, 0xd7, 0xc4, 0xc8,
+    0x29, 0xe0, 0xca, 0x51, 0x6d, 0x58, 0xa7, 0x36, 0x5b, 0x6c, 0x19, 0x23, 0x36, 0x1b, 0xee, 0x1e,
+    0x54, 0x11, 0x6d, 0x7e, 0xa0, 0x58, 0x65, 0x75, 0xed, 0x38, 0x51, 0x4e, 0xf7, 0x5b, 0x2c, 0xb2,
+    0x12, 0xc4, 0x5b, 0x29, 0xb1, 0x56, 0x2d, 0x03, 0xbd, 0x13, 0x6b, 0xec, 0x13, 0xac, 0x2e, 0x7c,
+    0x9a, 0xba, 0x90, 0x2b, 0xa8, 0x76, 0xe5, 0x2d, 0x0e, 0x62, 0xc9, 0xef, 0x67, 0x9a, 0x90, 0xe4,
+    0x40, 0x6d, 0xbd, 0x23, 0xba, 0x42, 0x6f, 0x68, 0x55, 0xab, 0x3b, 0x80, 0xbc, 0x57, 0x9d, 0x23,
+    0xb1, 0xd4, 0x78, 0x47, 0x7f, 0x27, 0xb0, 0x39, 0x5e, 0x7c, 0xf8, 0x84, 0xd7, 0xc3, 0x88, 0x9a,
+    0x19, 0xfa, 0xe0, 0xaa, 0x73, 0x6a, 0x85, 0x82, 0xe1, 0xb2, 0x57, 0xcc, 0xa5, 0xb1, 0x27, 0x4d,
+    0xa5, 0x61, 0x81, 0x88, 0x32, 0x62, 0xa4, 0x80, 0xe4, 0x12, 0x0a, 0xea, 0x69, 0x55, 0x65, 0xe3,
+    0xee, 0xa5, 0x00, 0x44, 0xe3, 0x31, 0x7a, 0xcd, 0x6a, 0x1a, 0xf6, 0xb5, 0x4c, 0x08, 0xb6, 0x00,
+    0xea, 0x5b, 0xe4, 0x23, 0x08, 0xbf, 0x8b, 0xb2, 0xd6, 0xf2, 0x59, 0x36, 0x34, 0xb0, 0x31, 0x66,
+    0x61, 0x68, 0xb8, 0xc4, 0x4b, 0x71, 0x97, 0x09, 0x0b, 0x47, 0xa3, 0x7f, 0x0c, 0xff, 0x69, 0xee,
+    0x8e, 0xe3, 0x6c, 0x97, 0xcc, 0xa9, 0xef, 0x78, 0x0c, 0xfd, 0x21, 0x19, 0x58, 0xa3, 0x89, 0x95,
+    0x9d, 0x19, 0x2c, 0x12, 0x70, 0xcd, 0x58, 0x93, 0x2a, 0x34, 0x66, 0x25, 0x15, 0xe0, 0x0c, 0x5b,
+    0x62, 0x73, 0xfd, 0xb1, 0x4a, 0xc7, 0xa1, 0x31, 0x88, 0xc4, 0x7e, 0xc0, 0x09, 0x0b, 0x9f, 0x77,
+    0x5b, 0xcc, 0x77, 0xa2, 0xbf, 0x70, 0x39, 0xef, 0xb4, 0xf1, 0xf2, 0x14, 0xaf, 0x5d, 0x9a, 0x43,
+    0xd7, 0xb9, 0x87, 0xaf, 0x0e, 0xd2, 0x6b, 0x5c, 0x42, 0xb1, 0xad, 0xcb, 0x1d, 0xed, 0xd2, 0xb7,
+    0x83, 0xa8, 0xba, 0xed, 0xba, 0xc0, 0x85, 0x1f, 0x01, 0xe1, 0x49, 0xf8, 0x7a, 0x40, 0x33, 0xc5,
+    0x96, 0x40, 0x2c, 0x5e, 0x25, 0x87, 0x35, 0x9f, 0x2d, 0xc9, 0x59, 0xfa, 0x53, 0xb7, 0xae, 0x0c,
+    0xcc, 0xa2, 0x61, 0x08, 0x22, 0x25, 0xe1, 0x06, 0x38, 0x48, 0xb5, 0xb8, 0xf1, 0xc1, 0xb2, 0x70,
+    0x6d, 0xda, 0x14, 0xcc, 0x0a, 0x60, 0x59, 0x17, 0xb0, 0xf6, 0x9a, 0xe7, 0x66, 0x2e, 0x52, 0xe6,
+    0xff, 0xfa, 0xfe, 0xdd, 0x1b, 0x29, 0xc3, 0x4f, 0xec, 0xd7, 0x98, 0x45, 0x46, 0x07, 0xc1, 0xcd,
+    0x29, 0xe0, 0xb6, 0x3c, 0xe6, 0xcf, 0xe4, 0xdc, 0x7c, 0xb3, 0x03, 0x78, 0xad, 0x00, 0x84, 0xed,
+    0xa4, 0x7d, 0x5a, 0x52, 0x3a, 0xfd, 0x26, 0xae, 0xf6, 0xb9, 0x07, 0xd2, 0xc6, 0x98, 0x42, 0xf0,
+    0x06, 0xb1, 0x57, 0x14, 0xaf, 0x6b, 0x6a, 0x80, 0xab, 0xee, 0xf7, 0x23, 0x89, 0x99, 0x10, 0x57,
+    0x75, 0x83, 0x08, 0x93, 0x65, 0x56, 0xe0, 0xe7, 0xaf, 0x6a, 0x26, 0xf5, 0x4e, 0x95, 0xdf, 0x76,
+    0xa5, 0x4a, 0x39, 0x0d, 0x16, 0xe0, 0x9f, 0xd8, 0xa2, 0xaf, 0xbb, 0xf8, 0x5a, 0x6d, 0x41, 0x98,
+    0x94, 0x81, 0xb8, 0xc4, 0x63, 0x92, 0x29, 0x32, 0x16, 0xd2, 0x86, 0x24, 0x3c, 0x40, 0x0f, 0x05,
+    0xbd, 0x78, 0x5d, 0xf2, 0x07, 0x7c, 0xa8, 0xf3, 0xbc, 0x16, 0xd7, 0x9a, 0xfc, 0x98, 0x3d, 0x0b,
+    0x00, 0x83, 0x50, 0xaf, 0x14, 0xac, 0xe4, 0xa5, 0xce, 0xa4, 0x42, 0xfd, 0x67, 0xd2, 0xfe, 0xa9,
+    0x6d, 0x26, 0x73, 0x57, 0x55, 0xdd, 0x73, 0xb3, 0xee, 0x02, 0x5f, 0x95, 0x0e, 0x93, 0xdc, 0xef,
+    0x3b, 0xdd, 0x06, 0xa5, 0xe1, 0x8a, 0xf4, 0xf1, 0xe6, 0x64, 0x32, 0x21, 0xe3, 0xe1, 0xb0, 0x49,
+    0x69, 0xa5, 0x52, 0x25, 0xf3, 0xec, 0x44, 0x48, 0x50, 0x58, 0xfa, 0xe8, 0xd1, 0x8d, 0x3d, 0xef,
+    0xd6, 0x22, 0xaf, 0xd4, 0x3f, 0x02, 0x21, 0x4b, 0xee, 0x79, 0xe0, 0xd4, 0x58, 0xad, 0x59, 0x96,
+    0x85, 0xae, 0x9f, 0x82, 0x99, 0x9c, 0xbf, 0x70, 0x7d, 0xfd, 0x89, 0x41, 0xa1, 0x42, 0xf2, 0xfd,
+    0xc7, 0x37, 0x56, 0xd4, 0x95, 0x4c, 0x20, 0x0f, 0x42, 0x12, 0x87, 0x79, 0xf4, 0xb6, 0x9e, 0x4f,
+    0x26, 0x2f, 0xf9, 0x82, 0x05, 0xb1, 0xec, 0x74, 0x1a, 0xac, 0xe6, 0xb1, 0xfb, 0xd7, 0x1e, 0xd6,
+    0x6d, 0x57, 0x72, 0x87, 0x81, 0xea, 0x1c, 0xd6, 0x88, 0xd9, 0xe0, 0x52, 0x55, 0x5d, 0x27, 0xa5,
+    0x1a, 0x71, 0x55, 0x75, 0x98, 0x54, 0x82, 0xb8, 0x71, 0x59, 0x7b, 0xea, 0x12, 0xea, 0xe2, 0xa6,
+    0x98, 0x7a, 0x5f, 0x03, 0x4a, 0x5e, 0xce, 0x6e, 0x60, 0x41, 0xb5, 0x3c, 0x36, 0x86, 0x78, 0x13,
+    0xe1, 0x2a, 0x26, 0xee, 0xcf, 0xf2, 0xec, 0x91, 0x5a, 0x0e, 0x57, 0xa5, 0xf7, 0x73, 0x23, 0xd7,
+    0x11, 0x06, 0xf7, 0x2c, 0xd8, 0x77, 0x1f, 0x53, 0x83, 0x1b, 0x94, 0xbd, 0xb5, 0xce, 0x66, 0xe5,
+    0xc5, 0xca, 0x96, 0x5b, 0x9b, 0x61, 0x86, 0x79, 0x90, 0x50, 0x32, 0x5c, 0xe2, 0x6d, 0x72, 0x95,
+    0xb7, 0xf6, 0x42, 0x6f, 0xf3, 0x8b, 0xbd, 0xde, 0xa6, 0xd6, 0xb8, 0x49, 0x77, 0x15, 0x23, 0x56,
+    0xde, 0x93, 0x0d, 0xbe, 0xd4, 0x99, 0xe5, 0x43, 0x3a, 0xb9, 0x9a, 0x15, 0xa8, 0x23, 0x66, 0xba,
+    0xe1, 0x18, 0x97, 0x1f, 0x1c, 0xce, 0x2a, 0xa1, 0xc8, 0x0b, 0x12, 0xf5, 0x80, 0xf7, 0x26, 0xe7,
+    0xaf, 0x1e, 0x3e, 0x9a, 0x1d, 0xde, 0x2f, 0xeb, 0x66, 0x32, 0xa2, 0x34, 0xf7, 0x93, 0x11, 0x55,
+    0x88, 0xf3, 0x99, 0x70, 0xf5, 0xe1, 0x5e, 0xce, 0x45, 0xb0, 0x54, 0xe5, 0xc9, 0x6b, 0x34, 0xf7,
+    0xf2, 0xaa, 0x07, 0x05, 0x35, 0x1d, 0x63, 0xf1, 0x26, 0x33, 0x79, 0xb7, 0x95, 0xdb, 0xef, 0x3d,
+    0xc2, 0xd8, 0x56, 0x8e, 0xdb, 0x3a, 0xfd, 0xed, 0x1d, 0xb7, 0x57, 0xe4, 0x72, 0x3c, 0xd8, 0xac,
+    0x30, 0x1f, 0xbb, 0x93, 0x54, 0xfc, 0x7a, 0xfd, 0xfb, 0x9f, 0x04, 0x50, 0x67, 0xa5, 0xb4, 0xbc,
+    0xd4, 0xa2, 0x48, 0x69, 0x37, 0x81, 0xab, 0x83, 0xd7, 0x07, 0x28, 0xfd, 0xf1, 0xbe, 0x22, 0xad,
+    0x09, 0x7e, 0xfc, 0xa6, 0x1a, 0x2b, 0x9f, 0x0d, 0x6f, 0x59, 0xd3, 0xf7, 0x69, 0xc7, 0x83, 0xe4,
+    0x15, 0xeb, 0xf1, 0x20, 0xf9, 0x77, 0xa5, 0xff, 0x03, 0x2b, 0x5c, 0xe7, 0x00, 0x68, 0x3a, 0x00,
+    0x00,
+};
+
+#endif
+
+#endif // OTAWEBUI_h
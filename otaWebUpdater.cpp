@@ -7,14 +7,18 @@
  **/
 
 #include "otaWebUpdater.h"
+#include "otaWebUi.h"
 
 #include <AsyncJson.h>
 #include <HTTPClient.h>
 #include <Update.h>
 #include <WiFi.h>
 #include <esp_err.h>
+#include <esp_image_format.h>
 #include <esp_ota_ops.h>
-#include <new> // ::operator new[]
+#include <esp_random.h>
+#include <esp_timer.h>
+#include <new> // std::nothrow
 
 #if OTAWEBUPDATER_USE_NVS == true
 #include <Preferences.h>
@@ -29,8 +33,22 @@
  * This function is a simple wrapper around Serial.print() to write a message
  * to the serial console. It can be overwritten by a custom implementation for
  * enhanced logging.
+ *
+ * Once a logger is set, the message is only copied into the log buffer and
+ * written by a low priority task, so a slow Serial does not stall the caller.
  */
 void OTAWEBUPDATER::logMessage(String msg, bool showtime) {
+    if (logBuffer.running()) {
+        logBuffer.push(msg.c_str(), msg.length(), showtime);
+        return;
+    }
+    writeLogLine(msg.c_str(), showtime);
+}
+
+/**
+ * @brief Pass a message to the logger callbacks
+ */
+void OTAWEBUPDATER::writeLogLine(const char *msg, bool showtime) {
     if (logLine && logLinePart) {
         if (logTime && showtime) {
             logLinePart(logTime() + " ");
@@ -49,9 +67,12 @@ void OTAWEBUPDATER::logMessagePart(String msg, bool showtime) {
 }
 
 void OTAWEBUPDATER::setLogger(std::function<void(String)> logLineCallback, std::function<void(String)> logLinePartCallback, std::function<String()> logTimeCallback) {
+    logBuffer.end();
     logLine = logLineCallback;
     logLinePart = logLinePartCallback;
     logTime = logTimeCallback;
+    if (logLine && logLinePart)
+        logBuffer.begin([this](const char *msg, bool showtime) { writeLogLine(msg, showtime); });
 }
 
 /**
@@ -65,41 +86,173 @@ void OTAWEBUPDATER::setBaseUrl(String newUrl) {
 #if OTAWEBUPDATER_USE_NVS == true
     if (preferences.begin(NVS, true)) {
         if (preferences.putString("baseUrl", newUrl)) {
-            logMessage("[OTA] Updated baseUrl in NVS to " + newUrl);
+            OTA_LOG_INFO("[OTA] Updated baseUrl in NVS to " + newUrl);
         } else
-            logMessage("[OTA] Failed to update baseUrl in NVS");
+            OTA_LOG_ERROR("[OTA] Failed to update baseUrl in NVS");
         preferences.end();
     }
 #endif
     baseUrl = newUrl;
 }
 
+/**
+ * @brief Set a different check interval
+ * @param minutes Minutes between two version checks
+ *
+ * The running check timer is rescheduled to the new interval.
+ */
 void OTAWEBUPDATER::setVersionCheckInterval(uint32_t minutes) {
 #if OTAWEBUPDATER_USE_NVS == true
     if (preferences.begin(NVS, true)) {
         if (preferences.putULong64("VersChkIntvl", minutes * 60 * 1000)) {
-            logMessage("[OTA] Updated VersionCheckInterval in NVS to " + String(minutes) + " minutes");
+            OTA_LOG_INFO("[OTA] Updated VersionCheckInterval in NVS to " + String(minutes) + " minutes");
         } else
-            logMessage("[OTA] Failed to update VersionCheckInterval in NVS");
+            OTA_LOG_ERROR("[OTA] Failed to update VersionCheckInterval in NVS");
         preferences.end();
     }
 #endif
     intervalVersionCheckMillis = minutes * 60 * 1000;
+    if (initialCheck)
+        nextVersionCheckMillis = lastVersionCheckMillis + intervalVersionCheckMillis + deviceJitter(intervalVersionCheckMillis);
+    scheduleVersionCheck();
+}
+
+/**
+ * @brief Set the window used to spread version checks of a fleet
+ * @param seconds Maximum per-device delay, 0 disables the jitter
+ *
+ * Every device waits a fixed, MAC derived fraction of this window before its
+ * first check and adds the same fraction to every later check. Devices powered
+ * up at the same moment therefore do not hit the update server at once.
+ */
+void OTAWEBUPDATER::setCheckJitter(uint32_t seconds) {
+    checkJitterMillis = (uint64_t)seconds * 1000;
+    if (!initialCheck)
+        nextVersionCheckMillis = deviceJitter(checkJitterMillis);
+    scheduleVersionCheck();
+}
+
+/**
+ * @brief Accept any certificate of a https server without a CA certificate
+ * @param allow true to give up the server authentication, for tests only
+ *
+ * Anyone able to intercept the connection could then serve firmware and
+ * manifests, unless the images are signed (setSigningKey()).
+ */
+void OTAWEBUPDATER::setInsecure(bool allow) {
+    httpSession.setInsecure(allow);
+    if (allow)
+        OTA_LOG_ERROR("[OTA] Warning: https server certificates are not verified");
+}
+
+/**
+ * @brief Milliseconds since boot, without the 49 day wrap of millis()
+ */
+uint64_t OTAWEBUPDATER::nowMillis() {
+    return esp_timer_get_time() / 1000;
+}
+
+/**
+ * @brief Get the per-device share of a delay
+ * @param delay The delay to add jitter to
+ * @return A deterministic value between 0 and min(delay, checkJitterMillis)
+ */
+uint64_t OTAWEBUPDATER::deviceJitter(uint64_t delay) {
+    uint64_t window = delay < checkJitterMillis ? delay : checkJitterMillis;
+    return window * deviceHash / 0x100000000ULL;
+}
+
+/**
+ * @brief Plan the next regular check after a version check
+ * @param success The check was answered by the server
+ *
+ * After a success the next check follows the interval, or the Cache-Control
+ * max-age if the server asked for longer. Failures are retried with exponential
+ * backoff, starting at retryBackoffMillis and capped at the interval. A
+ * Retry-After header always takes precedence if it is longer.
+ */
+void OTAWEBUPDATER::planNextVersionCheck(bool success) {
+    uint64_t delay = intervalVersionCheckMillis;
+    if (success) {
+        checkFailures = 0;
+        if (serverMaxAgeMillis > delay)
+            delay = serverMaxAgeMillis;
+        if (rolloutWaitMillis && rolloutWaitMillis < delay)
+            delay = rolloutWaitMillis; // wake up when the release becomes available
+    } else {
+        if (checkFailures < 16)
+            checkFailures++;
+        uint64_t backoff = retryBackoffMillis << (checkFailures - 1);
+        if (backoff < delay)
+            delay = backoff;
+    }
+    if (serverRetryAfterMillis > delay)
+        delay = serverRetryAfterMillis;
+
+    delay += deviceJitter(delay);
+    nextVersionCheckMillis = lastVersionCheckMillis + delay;
+    OTA_LOG_DEBUG("[OTA] Next version check in " + String((uint32_t)(delay / 1000)) + " seconds");
+}
+
+/**
+ * @brief Read the scheduling hints of the update server
+ * @param http The client holding the response headers
+ */
+void OTAWEBUPDATER::parseServerHints(HTTPClient &http) {
+    // Retry-After: <seconds>, the HTTP-date form is not supported
+    String retryAfter = http.header("Retry-After");
+    retryAfter.trim();
+    serverRetryAfterMillis = (uint64_t)retryAfter.toInt() * 1000;
+
+    // Cache-Control: public, max-age=<seconds>
+    String cacheControl = http.header("Cache-Control");
+    cacheControl.toLowerCase();
+    int maxAge = cacheControl.indexOf("max-age=");
+    serverMaxAgeMillis = maxAge < 0 ? 0 : (uint64_t)cacheControl.substring(maxAge + 8).toInt() * 1000;
+
+    // Date: time source for rollouts on devices without a set clock
+    uint32_t date = parseHttpDate(http.header("Date"));
+    if (date) {
+        serverDate = date;
+        serverDateMillis = nowMillis();
+    }
 }
 
 void OTAWEBUPDATER::setOtaPassword(String newPass) {
 #if OTAWEBUPDATER_USE_NVS == true
     if (preferences.begin(NVS, true)) {
         if (preferences.putString("OtaPassword", newPass)) {
-            logMessage("[OTA] Updated OtaPassword in NVS to " + newPass);
+            OTA_LOG_INFO("[OTA] Updated OtaPassword in NVS to " + newPass);
         } else
-            logMessage("[OTA] Failed to update OtaPassword in NVS");
+            OTA_LOG_ERROR("[OTA] Failed to update OtaPassword in NVS");
         preferences.end();
     }
 #endif
     otaPassword = newPass;
 }
 
+/**
+ * @brief Exchange the firmware with other devices on the LAN
+ * @param enable Serve the running firmware and download from peers before the baseUrl
+ * @param port Port of the attached webserver, announced to the peers
+ */
+void OTAWEBUPDATER::setPeerUpdates(bool enable, uint16_t port) {
+    peerUpdates = enable;
+    peerPort = port;
+    if (!enable)
+        peerDiscovery.withdraw();
+}
+
+/**
+ * @brief Install images a gateway sends to the multicast group
+ * @param enable Join the group once the network is up, see sendMulticast()
+ */
+void OTAWEBUPDATER::setMulticastUpdates(bool enable) {
+    multicastUpdates = enable;
+    if (!enable)
+        multicastReceiver.end();
+}
+
 /**
  * @brief Construct a new OTAWEBUPDATER::OtaWebUpdater object
  *
@@ -118,33 +271,56 @@ OTAWEBUPDATER::OTAWEBUPDATER(const char *ns) {
     NVS = (char *)ns;
     if (preferences.begin(NVS, true)) {
         baseUrl = preferences.getString("baseUrl", baseUrl);
-        logMessage("[OTA] Loaded baseUrl from NVS: " + baseUrl);
+        OTA_LOG_INFO("[OTA] Loaded baseUrl from NVS: " + baseUrl);
 
         intervalVersionCheckMillis = preferences.getULong64("VersChkIntvl", intervalVersionCheckMillis);
-        logMessage("[OTA] Loaded VersionCheckInterval from NVS: " + String(intervalVersionCheckMillis / 60 / 1000) + " minutes");
+        OTA_LOG_INFO("[OTA] Loaded VersionCheckInterval from NVS: " + String(intervalVersionCheckMillis / 60 / 1000) + " minutes");
 
         otaPassword = preferences.getString("OtaPassword", otaPassword);
-        logMessage("[OTA] Loaded OtaPassword from NVS: " + otaPassword);
+        OTA_LOG_INFO("[OTA] Loaded OtaPassword from NVS: " + otaPassword);
 
         preferences.end();
     }
+    loadManifestCache();
 #else
-    logMessage("[OTA] NVS is not used, ignoring namespace '" + String(ns) + "' settings");
+    OTA_LOG_INFO("[OTA] NVS is not used, ignoring namespace '" + String(ns) + "' settings");
 #endif
 
     temp_sensor_config_t tsens_config = TSENS_CONFIG_DEFAULT();
     temp_sensor_set_config(tsens_config);
 
     auto data = esp_ota_get_running_partition();
-    logMessage("[OTA] Running partition: " + String(data->label) + " (" + String(data->subtype) + ")");
-
-    logMessage("[OTA] Created, registering WiFi events");
+    OTA_LOG_INFO("[OTA] Running partition: " + String(data->label) + " (" + String(data->subtype) + ")");
+
+    // Count the boot of a new image as early as possible, a crash later on still counts
+    bootGuard.begin(ns);
+    if (bootGuard.state() == OTA_BOOT_TRIAL)
+        OTA_LOG_INFO("[OTA] New image on trial, boot " + String(bootGuard.boots()));
+    else if (bootGuard.state() == OTA_BOOT_REVERTED)
+        OTA_LOG_ERROR("[OTA] The new image failed, running the previous one again");
+
+    // Spread the checks of a fleet by a MAC derived fraction of the jitter window
+    uint64_t mac = ESP.getEfuseMac();
+    mac ^= mac >> 33;
+    mac *= 0xff51afd7ed558ccdULL;
+    mac ^= mac >> 33;
+    mac *= 0xc4ceb9fe1a85ec53ULL;
+    mac ^= mac >> 33;
+    deviceHash = (uint32_t)mac;
+    nextVersionCheckMillis = deviceJitter(checkJitterMillis);
+
+    // Wake sources of the background task
+    otaEvents = xEventGroupCreate();
+    checkTimer = xTimerCreate("OtaCheckTimer", 1, pdFALSE, this, otaTimerCallback);
+
+    OTA_LOG_DEBUG("[OTA] Created, registering WiFi events");
     if (WiFi.isConnected())
         networkReady = true;
 
     auto eventHandlerUp = [&](WiFiEvent_t event, WiFiEventInfo_t info) {
-        logMessage("[OTA][WIFI] onEvent() Network connected");
+        OTA_LOG_INFO("[OTA][WIFI] onEvent() Network connected");
         networkReady = true;
+        notify(OTA_EVENT_NETWORK);
     };
     WiFi.onEvent(eventHandlerUp, ARDUINO_EVENT_WIFI_STA_GOT_IP);
     WiFi.onEvent(eventHandlerUp, ARDUINO_EVENT_WIFI_STA_GOT_IP6);
@@ -152,12 +328,11 @@ OTAWEBUPDATER::OTAWEBUPDATER(const char *ns) {
     WiFi.onEvent(eventHandlerUp, ARDUINO_EVENT_ETH_GOT_IP6);
 
     auto eventHandlerDown = [&](WiFiEvent_t event, WiFiEventInfo_t info) {
-        logMessage("[OTA][WIFI] onEvent() Network disconnected");
+        OTA_LOG_INFO("[OTA][WIFI] onEvent() Network disconnected");
         networkReady = false;
     };
-    WiFi.onEvent(eventHandlerUp, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
-    WiFi.onEvent(eventHandlerUp, ARDUINO_EVENT_WIFI_AP_STADISCONNECTED);
-    WiFi.onEvent(eventHandlerUp, ARDUINO_EVENT_ETH_DISCONNECTED);
+    WiFi.onEvent(eventHandlerDown, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    WiFi.onEvent(eventHandlerDown, ARDUINO_EVENT_ETH_DISCONNECTED);
 }
 
 /**
@@ -166,9 +341,36 @@ OTAWEBUPDATER::OTAWEBUPDATER(const char *ns) {
  */
 OTAWEBUPDATER::~OTAWEBUPDATER() {
     stopBackgroundTask();
+    if (checkTimer)
+        xTimerDelete(checkTimer, portMAX_DELAY);
+    if (otaEvents)
+        vEventGroupDelete(otaEvents);
     // FIXME: get rid of the registered Webserver AsyncCallbackWebHandlers
 }
 
+/**
+ * @brief Send a document as MessagePack if the client accepts it, as JSON otherwise
+ * @param request The request to answer
+ * @param doc The response
+ * @param code HTTP status code
+ *
+ * Clients select MessagePack with "Accept: application/msgpack".
+ */
+void OTAWEBUPDATER::sendDocument(AsyncWebServerRequest *request, const JsonDocument &doc, int code) {
+    bool msgpack = request->hasHeader("Accept") && request->header("Accept").indexOf("msgpack") > -1;
+    AsyncResponseStream *response;
+    if (msgpack) {
+        response = request->beginResponseStream("application/msgpack", measureMsgPack(doc));
+        serializeMsgPack(doc, *response);
+    } else {
+        response = request->beginResponseStream("application/json", measureJson(doc));
+        serializeJson(doc, *response);
+    }
+    response->setCode(code);
+    response->addHeader("Vary", "Accept");
+    request->send(response);
+}
+
 /**
  * @brief Attach to a webserver and register the API routes
  */
@@ -176,35 +378,36 @@ void OTAWEBUPDATER::attachWebServer(AsyncWebServer *srv) {
     webServer = srv; // store it in the class for later use
 
     webServer->on((apiPrefix + "/config").c_str(), HTTP_GET, [&](AsyncWebServerRequest *request) {
-        String output;
         JsonDocument doc;
         doc["baseUrl"] = getBaseUrl();
         doc["otaPassword"] = "";
         doc["intervalVersionCheck"] = intervalVersionCheckMillis / 60 / 1000;
-        serializeJson(doc, output);
-        request->send(200, "application/json", output);
+        sendDocument(request, doc);
     });
 
     webServer->on((apiPrefix + "/config").c_str(), HTTP_POST, [&](AsyncWebServerRequest *request) {}, NULL,
                   [&](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
                       JsonDocument jsonBuffer;
-                      deserializeJson(jsonBuffer, (const char *)data);
+                      if (request->contentType().indexOf("msgpack") > -1)
+                          deserializeMsgPack(jsonBuffer, data, len);
+                      else
+                          deserializeJson(jsonBuffer, (const char *)data, len);
                       auto resp = request;
                       auto changes = 0;
 
                       if (jsonBuffer["baseUrl"].is<String>()) {
                           setBaseUrl(jsonBuffer["baseUrl"].as<String>());
-                          logMessage("[OTA][CONFIG] baseUrl changed to " + baseUrl);
+                          OTA_LOG_INFO("[OTA][CONFIG] baseUrl changed to " + baseUrl);
                           changes++;
                       }
                       if (jsonBuffer["otaPassword"].is<String>()) {
                           setOtaPassword(jsonBuffer["otaPassword"].as<String>());
-                          logMessage("[OTA][CONFIG] otaPassword changed to " + otaPassword);
+                          OTA_LOG_INFO("[OTA][CONFIG] otaPassword changed to " + otaPassword);
                           changes++;
                       }
                       if (jsonBuffer["intervalVersionCheck"].is<int>()) {
                           setVersionCheckInterval(jsonBuffer["intervalVersionCheck"].as<int>());
-                          logMessage("[OTA][CONFIG] intervalVersionCheck changed to " + String(intervalVersionCheckMillis / 60 / 1000) + " minutes");
+                          OTA_LOG_INFO("[OTA][CONFIG] intervalVersionCheck changed to " + String(intervalVersionCheckMillis / 60 / 1000) + " minutes");
                           changes++;
                       }
 
@@ -215,9 +418,17 @@ void OTAWEBUPDATER::attachWebServer(AsyncWebServer *srv) {
                       }
                   });
 
+    webServer->on((apiPrefix + "/check").c_str(), HTTP_POST, [&](AsyncWebServerRequest *request) {
+        if (baseUrl.isEmpty())
+            return request->send(422, "application/json", "{\"message\":\"No baseUrl configured\"}");
+        if (!otaCheckTask)
+            return request->send(503, "application/json", "{\"message\":\"Background task is not running\"}");
+        requestVersionCheck();
+        request->send(202, "application/json", "{\"message\":\"Version check requested\"}");
+    });
+
     webServer->on((apiPrefix + "/firmware/info").c_str(), HTTP_GET, [&](AsyncWebServerRequest *request) {
         auto data = esp_ota_get_running_partition();
-        String output;
         JsonDocument doc;
         doc["partition_type"] = data->type;
         doc["partition_subtype"] = data->subtype;
@@ -227,149 +438,384 @@ void OTAWEBUPDATER::attachWebServer(AsyncWebServer *srv) {
         doc["encrypted"] = data->encrypted;
         doc["firmware_version"] = currentFwRelease;
         doc["firmware_date"] = currentFwDate;
-        serializeJson(doc, output);
-        request->send(200, "application/json", output);
+        const char *bootStates[] = {"confirmed", "trial", "reverted"};
+        doc["boot_state"] = bootStates[bootGuard.state()];
+        if (!bootGuard.rejectedImage().isEmpty())
+            doc["rejected_image"] = bootGuard.rejectedImage();
+        sendDocument(request, doc);
     });
 
     webServer->on((apiPrefix + "/partition/switch").c_str(), HTTP_POST, [&](AsyncWebServerRequest *request) {
-        logMessage("[OTA] Switching boot partition");
+        OTA_LOG_INFO("[OTA] Switching boot partition");
         auto next = esp_ota_get_next_update_partition(NULL);
         auto error = esp_ota_set_boot_partition(next);
         if (error == ESP_OK) {
-            logMessage("[OTA] New partition ready for boot");
+            OTA_LOG_INFO("[OTA] New partition ready for boot");
+            bootGuard.arm(); // the other slot may hold anything, let it prove its health as well
             request->send(200, "application/json", "{\"message\":\"New partition ready for boot. Rebooting....\"}");
             yield();
             delay(250);
 
-            logMessage("[OTA] Rebooting now!");
+            OTA_LOG_INFO("[OTA] Rebooting now!");
+            logBuffer.flush();
             Serial.flush();
             ESP.restart();
         } else {
-            logMessage("[OTA] Error switching boot partition - " + String(esp_err_to_name(error)));
+            OTA_LOG_ERROR("[OTA] Error switching boot partition - " + String(esp_err_to_name(error)));
             request->send(500, "application/json", String("{\"message\":\"Error switching boot partition - ") + String(esp_err_to_name(error)) + "\"}");
         }
     });
 
     webServer->on((apiPrefix + "/esp").c_str(), HTTP_GET, [&](AsyncWebServerRequest *request) {
+        if (espStaticInfo.isEmpty())
+            buildEspStaticInfo();
+        sampleEspInfo();
+
+        char dynamicInfo[640];
+        int len = snprintf(dynamicInfo, sizeof(dynamicInfo),
+                           ",\"cycleCount\":%u,\"temperature\":%.1f}"
+                           ",\"ram\":{\"heapSize\":%u,\"freeHeap\":%u,\"usagePercent\":%.2f,\"minFreeHeap\":%u,\"maxAllocHeap\":%u}"
+                           ",\"spi\":{\"psramSize\":%u,\"freePsram\":%u,\"minFreePsram\":%u,\"maxAllocPsram\":%u}"
+                           ",\"ota\":{\"manifestChecks\":%u,\"manifestFailures\":%u,\"updates\":%u,\"updateFailures\":%u,\"retries\":%u"
+                           ",\"bytes\":%llu,\"bytesPerSecond\":%u,\"minFreeHeap\":%u}}",
+                           (unsigned)ESP.getCycleCount(), espSample.temperature,
+                           (unsigned)espSample.heapSize, (unsigned)espSample.freeHeap, (float)espSample.freeHeap / (float)espSample.heapSize * 100.f,
+                           (unsigned)espSample.minFreeHeap, (unsigned)espSample.maxAllocHeap,
+                           (unsigned)espSample.psramSize, (unsigned)espSample.freePsram, (unsigned)espSample.minFreePsram, (unsigned)espSample.maxAllocPsram,
+                           (unsigned)metrics.manifestChecks, (unsigned)metrics.manifestFailures, (unsigned)metrics.updates, (unsigned)metrics.updateFailures,
+                           (unsigned)metrics.retries, (unsigned long long)metrics.bytes, (unsigned)metrics.lastBytesPerSecond, (unsigned)metrics.minFreeHeap);
+
+        AsyncResponseStream *response = request->beginResponseStream("application/json", espStaticInfo.length() + len);
+        response->write((const uint8_t *)espStaticInfo.c_str(), espStaticInfo.length());
+        response->write((const uint8_t *)dynamicInfo, len);
+        request->send(response);
+    });
+
+    webServer->on((apiPrefix + "/metrics").c_str(), HTTP_GET, [&](AsyncWebServerRequest *request) {
+        AsyncResponseStream *response = request->beginResponseStream("text/plain; version=0.0.4", 4096);
+        metrics.print(*response);
+        request->send(response);
+    });
+
+    webServer->on((apiPrefix + "/benchmark").c_str(), HTTP_GET, [&](AsyncWebServerRequest *request) {
+        auto phase = [](JsonObject obj, const OtaBenchmarkPhase &p) {
+            obj["count"] = p.count;
+            obj["p50"] = p.p50;
+            obj["p90"] = p.p90;
+            obj["p99"] = p.p99;
+            obj["max"] = p.max;
+        };
         String output;
-        JsonDocument json;
-
-        JsonObject booting = json["booting"].to<JsonObject>();
-        booting["rebootReason"] = esp_reset_reason();
-        booting["partitionCount"] = esp_ota_get_app_partition_count();
-
-        auto partition = esp_ota_get_boot_partition();
-        JsonObject bootPartition = json["bootPartition"].to<JsonObject>();
-        bootPartition["address"] = partition->address;
-        bootPartition["size"] = partition->size;
-        bootPartition["label"] = partition->label;
-        bootPartition["encrypted"] = partition->encrypted;
-        switch (partition->type) {
-        case ESP_PARTITION_TYPE_APP:
-            bootPartition["type"] = "app";
-            break;
-        case ESP_PARTITION_TYPE_DATA:
-            bootPartition["type"] = "data";
-            break;
-        default:
-            bootPartition["type"] = "any";
+        JsonDocument doc;
+        doc["running"] = benchmark.running;
+        doc["mode"] = OtaBenchmarkResult::modeName(benchmark.mode);
+        doc["success"] = benchmark.success;
+        if (!benchmark.error.isEmpty())
+            doc["error"] = benchmark.error;
+        doc["bytes"] = benchmark.bytes;
+        doc["seconds"] = benchmark.micros / 1e6;
+        doc["mbps"] = benchmark.mbps();
+        if (benchmark.mode != OTA_BENCHMARK_FLASH) {
+            doc["firstByteMs"] = benchmark.firstByteMicros / 1000;
+            phase(doc["read"].to<JsonObject>(), benchmark.read);
+        } else {
+            phase(doc["erase"].to<JsonObject>(), benchmark.erase);
         }
-        bootPartition["subtype"] = partition->subtype;
-
-        partition = esp_ota_get_running_partition();
-        JsonObject runningPartition = json["runningPartition"].to<JsonObject>();
-        runningPartition["address"] = partition->address;
-        runningPartition["size"] = partition->size;
-        runningPartition["label"] = partition->label;
-        runningPartition["encrypted"] = partition->encrypted;
-        switch (partition->type) {
-        case ESP_PARTITION_TYPE_APP:
-            runningPartition["type"] = "app";
-            break;
-        case ESP_PARTITION_TYPE_DATA:
-            runningPartition["type"] = "data";
-            break;
-        default:
-            runningPartition["type"] = "any";
+        phase(doc["write"].to<JsonObject>(), benchmark.write);
+        serializeJson(doc, output);
+        request->send(200, "application/json", output);
+    });
+
+    webServer->on((apiPrefix + "/benchmark").c_str(), HTTP_POST, [&](AsyncWebServerRequest *request) {
+        if (otaPassword.length() && !request->authenticate("ota", otaPassword.c_str()))
+            return request->send(401, "application/json", "{\"message\":\"Invalid OTA password provided!\"}");
+        if (!otaCheckTask)
+            return request->send(503, "application/json", "{\"message\":\"Background task is not running\"}");
+        if (otaIsRunning || benchmarkRequested)
+            return request->send(409, "application/json", "{\"message\":\"An update or benchmark is running\"}");
+
+        String mode = request->hasParam("mode") ? request->getParam("mode")->value() : "discard";
+        if (mode == "discard")
+            benchmarkMode = OTA_BENCHMARK_DISCARD;
+        else if (mode == "write")
+            benchmarkMode = OTA_BENCHMARK_WRITE;
+        else if (mode == "flash")
+            benchmarkMode = OTA_BENCHMARK_FLASH;
+        else
+            return request->send(400, "application/json", "{\"message\":\"mode must be discard, write or flash\"}");
+        if (benchmarkMode != OTA_BENCHMARK_FLASH && baseUrl.isEmpty())
+            return request->send(422, "application/json", "{\"message\":\"No baseUrl configured\"}");
+
+        benchmarkFile = request->hasParam("file") ? request->getParam("file")->value() : "firmware.bin";
+        benchmarkSize = request->hasParam("size") ? request->getParam("size")->value().toInt() : 1024 * 1024;
+        benchmark = OtaBenchmarkResult();
+        benchmark.mode = benchmarkMode;
+        benchmark.running = true;
+        benchmarkRequested = true;
+        notify(OTA_EVENT_BENCHMARK);
+        request->send(202, "application/json", "{\"message\":\"Benchmark requested\"}");
+    });
+
+    webServer->on((apiPrefix + "/peer/firmware.bin").c_str(), HTTP_GET, [&](AsyncWebServerRequest *request) {
+        if (!peerUpdates || peerSha256.isEmpty())
+            return request->send(404, "application/json", "{\"message\":\"Peer updates are disabled\"}");
+        if (peerTransfers >= OTAPEER_MAX_TRANSFERS) {
+            AsyncWebServerResponse *busy = request->beginResponse(503, "application/json", "{\"message\":\"Too many downloads\"}");
+            busy->addHeader("Retry-After", "30");
+            return request->send(busy);
+        }
+
+        // "bytes=N-" continues an interrupted download, see downloadRange()
+        size_t total = peerImageSize;
+        size_t first = 0;
+        if (request->hasHeader("Range")) {
+            String range = request->header("Range");
+            if (range.startsWith("bytes="))
+                first = range.substring(6).toInt();
+            if (first >= total)
+                return request->send(416, "application/json", "{\"message\":\"Range not satisfiable\"}");
         }
-        runningPartition["subtype"] = partition->subtype;
-
-        JsonObject build = json["build"].to<JsonObject>();
-        build["date"] = __DATE__;
-        build["time"] = __TIME__;
-
-        JsonObject ram = json["ram"].to<JsonObject>();
-        ram["heapSize"] = ESP.getHeapSize();
-        ram["freeHeap"] = ESP.getFreeHeap();
-        ram["usagePercent"] = (float)ESP.getFreeHeap() / (float)ESP.getHeapSize() * 100.f;
-        ram["minFreeHeap"] = ESP.getMinFreeHeap();
-        ram["maxAllocHeap"] = ESP.getMaxAllocHeap();
-
-        JsonObject spi = json["spi"].to<JsonObject>();
-        spi["psramSize"] = ESP.getPsramSize();
-        spi["freePsram"] = ESP.getFreePsram();
-        spi["minFreePsram"] = ESP.getMinFreePsram();
-        spi["maxAllocPsram"] = ESP.getMaxAllocPsram();
-
-        JsonObject chip = json["chip"].to<JsonObject>();
-        chip["revision"] = ESP.getChipRevision();
-        chip["model"] = ESP.getChipModel();
-        chip["cores"] = ESP.getChipCores();
-        chip["cpuFreqMHz"] = ESP.getCpuFreqMHz();
-        chip["cycleCount"] = ESP.getCycleCount();
-        chip["sdkVersion"] = ESP.getSdkVersion();
-        chip["efuseMac"] = ESP.getEfuseMac();
-        float temperature_c;
-        temp_sensor_read_celsius(&temperature_c);
-        chip["temperature"] = temperature_c;
-
-        JsonObject flash = json["flash"].to<JsonObject>();
-        flash["flashChipSize"] = ESP.getFlashChipSize();
-        flash["flashChipRealSize"] = spi_flash_get_chip_size();
-        flash["flashChipSpeedMHz"] = ESP.getFlashChipSpeed() / 1000000;
-        flash["flashChipMode"] = ESP.getFlashChipMode();
-        flash["sdkVersion"] = ESP.getFlashChipSize();
-
-        JsonObject sketch = json["sketch"].to<JsonObject>();
-        sketch["size"] = ESP.getSketchSize();
-        sketch["maxSize"] = ESP.getFreeSketchSpace();
-        sketch["usagePercent"] = (float)ESP.getSketchSize() / (float)ESP.getFreeSketchSpace() * 100.f;
-        sketch["md5"] = ESP.getSketchMD5();
-
-        serializeJson(json, output);
+
+        const esp_partition_t *running = esp_ota_get_running_partition();
+        AsyncWebServerResponse *response = request->beginResponse("application/octet-stream", total - first,
+                                                                  [running, first, total](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                                                                      size_t len = total - first - index < maxLen ? total - first - index : maxLen;
+                                                                      if (esp_partition_read(running, first + index, buffer, len) != ESP_OK)
+                                                                          return 0;
+                                                                      return len;
+                                                                  });
+        if (first) {
+            response->setCode(206);
+            response->addHeader("Content-Range", "bytes " + String(first) + "-" + String(total - 1) + "/" + String(total));
+        }
+        response->addHeader("Accept-Ranges", "bytes");
+        response->addHeader("ETag", "\"" + peerSha256 + "\"");
+        peerTransfers++;
+        request->onDisconnect([this]() { peerTransfers--; });
+        request->send(response);
+    });
+
+    webServer->on((apiPrefix + "/multicast").c_str(), HTTP_GET, [&](AsyncWebServerRequest *request) {
+        const OtaMulticastStats &stats = multicastSender.stats();
+        String output;
+        JsonDocument doc;
+        JsonObject sender = doc["sender"].to<JsonObject>();
+        sender["running"] = (bool)multicastRequested;
+        sender["session"] = stats.session;
+        sender["blocks"] = stats.blocks;
+        sender["sent"] = stats.sent;
+        sender["rounds"] = stats.rounds;
+        sender["nacks"] = stats.nacks;
+        sender["done"] = stats.done;
+        sender["rejected"] = stats.rejected;
+        if (*multicastSender.errorString())
+            sender["error"] = multicastSender.errorString();
+        JsonObject receiver = doc["receiver"].to<JsonObject>();
+        receiver["listening"] = multicastReceiver.isListening();
+        receiver["active"] = multicastReceiver.isActive();
+        receiver["received"] = multicastReceiver.receivedBlocks();
+        receiver["blocks"] = multicastReceiver.totalBlocks();
+        if (*multicastReceiver.errorString())
+            receiver["error"] = multicastReceiver.errorString();
+        serializeJson(doc, output);
         request->send(200, "application/json", output);
     });
 
+    webServer->on((apiPrefix + "/multicast").c_str(), HTTP_POST, [&](AsyncWebServerRequest *request) {
+        if (otaPassword.length() && !request->authenticate("ota", otaPassword.c_str()))
+            return request->send(401, "application/json", "{\"message\":\"Invalid OTA password provided!\"}");
+        if (!otaCheckTask)
+            return request->send(503, "application/json", "{\"message\":\"Background task is not running\"}");
+        if (otaIsRunning || multicastRequested)
+            return request->send(409, "application/json", "{\"message\":\"An update or multicast is running\"}");
+        multicastRequested = true;
+        notify(OTA_EVENT_MULTICAST);
+        request->send(202, "application/json", "{\"message\":\"Multicast requested\"}");
+    });
+
+    webServer->on((apiPrefix + "/gateway/push").c_str(), HTTP_GET, [&](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        doc["running"] = gatewayPush.isRunning() || pushRequested;
+        doc["size"] = gatewayPush.imageSize();
+        doc["concurrency"] = gatewayPush.lastConcurrency();
+        doc["queued"] = gatewayPush.countState(OTA_PUSH_QUEUED);
+        doc["sending"] = gatewayPush.countState(OTA_PUSH_SENDING);
+        doc["done"] = gatewayPush.countState(OTA_PUSH_DONE);
+        doc["failed"] = gatewayPush.countState(OTA_PUSH_FAILED);
+        if (*gatewayPush.errorString())
+            doc["error"] = gatewayPush.errorString();
+        const char *states[] = {"queued", "sending", "done", "failed"};
+        JsonArray targets = doc["targets"].to<JsonArray>();
+        for (uint8_t i = 0; i < gatewayPush.targetCount(); i++) {
+            const OtaPushTarget &target = gatewayPush.target(i);
+            JsonObject entry = targets.add<JsonObject>();
+            entry["host"] = target.host + ":" + String(target.port);
+            entry["state"] = states[target.state];
+            entry["sent"] = (size_t)target.sent;
+            if (target.httpCode)
+                entry["code"] = target.httpCode;
+            if (*target.error)
+                entry["error"] = target.error;
+        }
+        sendDocument(request, doc);
+    });
+
+    webServer->on((apiPrefix + "/gateway/push").c_str(), HTTP_POST,
+                  [&](AsyncWebServerRequest *request) {
+                      if (otaPassword.length() && !request->authenticate("ota", otaPassword.c_str()))
+                          return request->send(401, "application/json", "{\"message\":\"Invalid OTA password provided!\"}");
+                      if (request->contentLength() > OTAWEBUPDATER_PUSH_BODY_MAX)
+                          return request->send(413, "application/json", "{\"message\":\"Request too large\"}");
+                      if (!request->_tempObject)
+                          return request->send(400, "application/json", "{\"message\":\"Invalid data\"}");
+                      if (!otaCheckTask)
+                          return request->send(503, "application/json", "{\"message\":\"Background task is not running\"}");
+                      if (otaIsRunning || pushRequested || gatewayPush.isRunning())
+                          return request->send(409, "application/json", "{\"message\":\"An update or push is running\"}");
+
+                      JsonDocument body;
+                      const char *data = (const char *)request->_tempObject;
+                      if (request->contentType().indexOf("msgpack") > -1 ? deserializeMsgPack(body, data, request->contentLength()) : deserializeJson(body, data, request->contentLength()))
+                          return request->send(400, "application/json", "{\"message\":\"Invalid data\"}");
+                      JsonArray targets = body["targets"].as<JsonArray>();
+                      if (targets.isNull() || !targets.size())
+                          return request->send(422, "application/json", "{\"message\":\"No targets given\"}");
+
+                      gatewayPush.clearTargets();
+                      for (JsonVariant target : targets) {
+                          if (!gatewayPush.addTarget(target.as<String>()))
+                              return request->send(422, "application/json", "{\"message\":\"Invalid target or too many targets\"}");
+                      }
+                      // the fleet usually shares the password of the gateway
+                      gatewayPush.setPassword(body["password"].is<String>() ? body["password"].as<String>() : otaPassword);
+                      if (body["concurrency"].is<int>())
+                          gatewayPush.setConcurrency(body["concurrency"].as<int>());
+
+                      pushRequested = true;
+                      notify(OTA_EVENT_PUSH);
+                      request->send(202, "application/json", "{\"message\":\"Push requested\"}");
+                  },
+                  NULL,
+                  [&](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+                      // collect the body, the request handler answers once it is complete
+                      if (total > OTAWEBUPDATER_PUSH_BODY_MAX)
+                          return;
+                      if (!index)
+                          request->_tempObject = malloc(total); // freed with the request
+                      if (request->_tempObject && index + len <= total)
+                          memcpy((uint8_t *)request->_tempObject + index, data, len);
+                  });
+
     webServer->on((apiPrefix + "/upload").c_str(), HTTP_POST,
                   [&](AsyncWebServerRequest *request) {},
                   [&](AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data, size_t len, bool final) {
                       if (otaPassword.length()) {
                           if (!request->authenticate("ota", otaPassword.c_str())) {
-                              logMessage("[OTA] Incorrect OTA request: Invalid password provided!");
+                              OTA_LOG_ERROR("[OTA] Incorrect OTA request: Invalid password provided!");
                               return request->send(401, "application/json", "{\"message\":\"Invalid OTA password provided!\"}");
                           }
                       } // else logMessage("[OTA] No password confirequest->authenticategured, no authentication requested!");
 
+                      if (index && !uploadWriter.isActive())
+                          return; // the upload already failed
+
                       if (!index) {
                           otaIsRunning = true;
-                          logMessage("[OTA] Begin firmware update with filename: " + filename);
+                          uploadStartMicros = esp_timer_get_time();
+                          metrics.updateStarted();
+                          OTA_LOG_INFO("[OTA] Begin firmware update with filename: " + filename);
                           // if filename includes spiffs|littlefs, update the spiffs|littlefs partition
                           int cmd = (filename.indexOf("spiffs") > -1 || filename.indexOf("littlefs") > -1) ? U_SPIFFS : U_FLASH;
+                          if (cmd == U_FLASH)
+                              prepareEraser.cancel(); // Update writes the same partition
                           if (!Update.begin(UPDATE_SIZE_UNKNOWN, cmd)) {
-                              logMessage("[OTA] Error: " + String(Update.errorString()));
+                              metrics.countError(OTA_STAGE_BEGIN, Update.getError());
+                              metrics.updateFinished(false, 0, 0);
+                              OTA_LOG_ERROR("[OTA] Error: " + String(Update.errorString()));
                               request->send(500, "application/json", "{\"message\":\"Unable to begin firmware update!\"}");
-                              otaIsRunning = false;
+                              abortLifecycle("upload failed");
+                              return;
+                          }
+                          if (cmd == U_SPIFFS)
+                              setInstalledSha256(U_SPIFFS, "");
+                          // *.gz uploads or data starting with the gzip magic are inflated on the fly
+                          if (!uploadVerifier.begin(request->header("X-OTA-SHA256"), request->header("X-OTA-Signature"), signingKey)) {
+                              OTA_LOG_ERROR("[OTA] Error: " + String(uploadVerifier.errorString()));
+                              request->send(400, "application/json", String("{\"message\":\"") + uploadVerifier.errorString() + "\"}");
+                              Update.abort();
+                              metrics.updateFinished(false, index, esp_timer_get_time() - uploadStartMicros);
+                              abortLifecycle("upload failed");
+                              return;
+                          }
+                          auto updateWriter = [this](uint8_t *data, size_t len) {
+                              uploadVerifier.update(data, len);
+                              return Update.write(data, len) == len;
+                          };
+                          if (!uploadDecoder.begin(OtaDecompressor::fromFilename(filename), updateWriter)) {
+                              OTA_LOG_ERROR("[OTA] Error: " + String(uploadDecoder.errorString()));
+                              request->send(500, "application/json", "{\"message\":\"Unable to allocate the decompressor!\"}");
+                              Update.abort();
+                              metrics.updateFinished(false, index, esp_timer_get_time() - uploadStartMicros);
+                              abortLifecycle("upload failed");
+                              return;
                           }
+                          // Flash writes run in their own task, the TCP task only copies the chunks
+                          auto decodeWriter = [this](uint8_t *data, size_t len) {
+                              int64_t start = esp_timer_get_time();
+                              bool success = uploadDecoder.write(data, len);
+                              metrics.observeWrite(esp_timer_get_time() - start);
+                              return success;
+                          };
+                          if (!uploadWriter.begin(decodeWriter, request->client(), pipelineSlots, pipelineSlotSize, bufferStrategy)) {
+                              OTA_LOG_ERROR("[OTA] Unable to start the upload writer, max alloc heap: " + String(ESP.getMaxAllocHeap()));
+                              request->send(500, "application/json", "{\"message\":\"Unable to allocate the upload buffers!\"}");
+                              Update.abort();
+                              metrics.updateFinished(false, index, esp_timer_get_time() - uploadStartMicros);
+                              abortLifecycle("upload failed");
+                              return;
+                          }
+                          uploadProgress.reset();
+                          emitLifecycle(OTA_LIFECYCLE_DOWNLOADING, filename, 0, request->contentLength());
+                          request->onDisconnect([this]() {
+                              if (!uploadWriter.isActive())
+                                  return;
+                              OTA_LOG_ERROR("[OTA] Upload aborted by the client");
+                              uploadWriter.abort();
+                              Update.abort();
+                              metrics.updateFinished(false, 0, esp_timer_get_time() - uploadStartMicros);
+                              abortLifecycle("upload failed");
+                          });
                       }
 
-                      if (Update.write(data, len) != len) {
-                          logMessage("[OTA] Error: " + String(Update.errorString()));
+                      metrics.sampleHeap();
+                      if (!uploadWriter.write(data, len)) {
+                          OTA_LOG_ERROR("[OTA] Error: " + String(uploadDecoder.errorString()) + " - " + String(Update.errorString()));
                           request->send(500, "application/json", "{\"message\":\"Unable to write firmware update data!\"}");
-                          otaIsRunning = false;
+                          uploadWriter.abort();
+                          Update.abort();
+                          metrics.updateFinished(false, index, esp_timer_get_time() - uploadStartMicros);
+                          abortLifecycle("upload failed");
+                          return;
                       }
+                      if (uploadProgress.due(index + len, request->contentLength()))
+                          emitLifecycle(OTA_LIFECYCLE_DOWNLOADING, filename, index + len, request->contentLength());
 
                       if (final) {
-                          if (!Update.end(true)) {
+                          emitLifecycle(OTA_LIFECYCLE_VERIFYING, filename, index + len, index + len);
+                          if (!uploadWriter.end()) {
+                              OTA_LOG_ERROR("[OTA] Error: " + String(uploadDecoder.errorString()) + " - " + String(Update.errorString()));
+                              Update.abort();
+                          } else if (!uploadDecoder.end()) {
+                              OTA_LOG_ERROR("[OTA] Error: " + String(uploadDecoder.errorString()));
+                              Update.abort();
+                          } else if (!uploadVerifier.finish()) {
+                              OTA_LOG_ERROR("[OTA] Image verification failed - " + String(uploadVerifier.errorString()));
+                              Update.abort();
+                          }
+                          bool success = Update.end(true);
+                          metrics.updateFinished(success, index + len, esp_timer_get_time() - uploadStartMicros);
+                          if (!success) {
+                              metrics.countError(OTA_STAGE_END, Update.getError());
                               String output;
                               JsonDocument doc;
                               doc["message"] = "Update error";
@@ -377,16 +823,19 @@ void OTAWEBUPDATER::attachWebServer(AsyncWebServer *srv) {
                               serializeJson(doc, output);
                               request->send(500, "application/json", output);
 
-                              logMessage("[OTA] Error when calling calling Update.end().");
-                              logMessage("[OTA] Error: " + String(Update.errorString()));
-                              otaIsRunning = false;
+                              OTA_LOG_ERROR("[OTA] Error when calling calling Update.end().");
+                              OTA_LOG_ERROR("[OTA] Error: " + String(Update.errorString()));
+                              abortLifecycle("upload failed");
                           } else {
-                              logMessage("[OTA] Firmware update successful.");
+                              OTA_LOG_INFO("[OTA] Firmware update successful.");
                               request->send(200, "application/json", "{\"message\":\"Please wait while the device reboots!\"}");
                               yield();
                               delay(250);
 
-                              logMessage("[OTA] Update complete, rebooting now!");
+                              emitLifecycle(OTA_LIFECYCLE_COMMITTING, filename, index + len, index + len);
+                              bootGuard.arm();
+                              OTA_LOG_INFO("[OTA] Update complete, rebooting now!");
+                              logBuffer.flush();
                               Serial.flush();
                               ESP.restart();
                           }
@@ -396,37 +845,135 @@ void OTAWEBUPDATER::attachWebServer(AsyncWebServer *srv) {
 
 /**
  * @brief Start a background task to regulary check for updates
+ *
+ * Runs at idle priority on core 0 by default, see setTaskConfig(). The task
+ * stack stays in internal RAM, a task with its stack in PSRAM must not access
+ * the flash, which this one does for NVS and the partitions.
  */
 bool OTAWEBUPDATER::startBackgroundTask() {
     stopBackgroundTask();
     BaseType_t xReturned = xTaskCreatePinnedToCore(
         otaTask,
         "OtaWebUpdater",
-        4000,          // Stack size in words
-        this,          // Task input parameter
-        0,             // Priority of the task
-        &otaCheckTask, // Task handle.
-        0              // Core where the task should run
+        taskConfig.stackSize, // Stack size
+        this,                 // Task input parameter
+        taskConfig.priority,  // Priority of the task
+        &otaCheckTask,        // Task handle.
+        taskConfig.core       // Core where the task should run
     );
     if (xReturned != pdPASS) {
-        logMessage("[OTA] Unable to run the background Task");
+        OTA_LOG_ERROR("[OTA] Unable to run the background Task");
         return false;
     }
     return true;
 }
 
+/**
+ * @brief Raise the priority of the background task while an update is installed
+ * @param active true when a download starts, false when it ended
+ *
+ * The flash writer of the pipeline inherits the priority of the task. Does
+ * nothing when called from another task, e.g. a direct executeUpdate().
+ */
+void OTAWEBUPDATER::setDownloadPhase(bool active) {
+    if (taskConfig.downloadPriority <= taskConfig.priority || !otaCheckTask || xTaskGetCurrentTaskHandle() != otaCheckTask)
+        return;
+    vTaskPrioritySet(NULL, active ? taskConfig.downloadPriority : taskConfig.priority);
+}
+
+/**
+ * @brief Report a stage of an update to the application
+ * @param event The new stage
+ * @param file Url or name of the file
+ * @param bytes Bytes transferred so far
+ * @param total Size of the file, -1 if unknown
+ */
+void OTAWEBUPDATER::emitLifecycle(OtaLifecycleEvent event, const String &file, size_t bytes, int total) {
+    if (!lifecycleCallback)
+        return;
+    OtaLifecycleInfo info = {event, file.c_str(), bytes, total, ""};
+    lifecycleCallback(info);
+}
+
+/**
+ * @brief End an update that failed or was not needed
+ * @param reason Reported as OtaLifecycleInfo::reason
+ */
+void OTAWEBUPDATER::abortLifecycle(const char *reason) {
+    otaIsRunning = false;
+    if (!lifecycleCallback)
+        return;
+    OtaLifecycleInfo info = {OTA_LIFECYCLE_ABORTED, "", 0, -1, reason};
+    lifecycleCallback(info);
+}
+
 /**
  * @brief Stops a background task if existing
  */
 void OTAWEBUPDATER::stopBackgroundTask() {
+    if (checkTimer)
+        xTimerStop(checkTimer, portMAX_DELAY);
     if (otaCheckTask != NULL) { // make sure there is no task running
         vTaskDelete(otaCheckTask);
-        logMessage("[OTA] Stopped the background Task");
+        otaCheckTask = NULL;
+        OTA_LOG_INFO("[OTA] Stopped the background Task");
+    }
+}
+
+/**
+ * @brief Wake up the background task
+ * @param bits One or more OTA_EVENT_* bits describing the reason
+ */
+void OTAWEBUPDATER::notify(EventBits_t bits) {
+    if (bits & OTA_EVENT_CHECK)
+        checkRequested = true;
+    if (otaEvents)
+        xEventGroupSetBits(otaEvents, bits);
+}
+
+/**
+ * @brief Block until there is something to do for the background task
+ * @return The OTA_EVENT_* bits that woke the task
+ */
+EventBits_t OTAWEBUPDATER::waitForEvent() {
+    if (!otaEvents) {
+        vTaskDelay(portMAX_DELAY);
+        return 0;
     }
+    return xEventGroupWaitBits(otaEvents, OTA_EVENT_ALL, pdTRUE, pdFALSE, portMAX_DELAY);
+}
+
+/**
+ * @brief Arm the one-shot timer for the next regular version check
+ */
+void OTAWEBUPDATER::scheduleVersionCheck() {
+    if (!checkTimer || !otaCheckTask)
+        return;
+
+    uint64_t now = nowMillis();
+    uint64_t remaining = nextVersionCheckMillis > now ? nextVersionCheckMillis - now : 0;
+    if (bootGuard.state() == OTA_BOOT_TRIAL && remaining > 1000)
+        remaining = 1000; // poll the health check
+    uint64_t ticks = remaining * configTICK_RATE_HZ / 1000;
+    if (ticks < 1)
+        ticks = 1;
+    if (ticks > portMAX_DELAY - 1) // the timer wakes us up early, loop() re-arms it
+        ticks = portMAX_DELAY - 1;
+
+    xTimerChangePeriod(checkTimer, (TickType_t)ticks, portMAX_DELAY); // also starts the timer
+}
+
+/**
+ * @brief Timer callback for the next regular version check
+ * @param timer The check timer, its ID is the OtaWebUpdater instance
+ */
+void otaTimerCallback(TimerHandle_t timer) {
+    OTAWEBUPDATER *otaWebUpdater = (OTAWEBUPDATER *)pvTimerGetTimerID(timer);
+    otaWebUpdater->notify(OTA_EVENT_TIMER);
 }
 
 /**
- * @brief Background Task running as a loop forever
+ * @brief Background Task sleeping until a timer, network or API event arrives
  * @param param needs to be a valid OtaWebUpdater instance
  */
 void otaTask(void *param) {
@@ -436,632 +983,1687 @@ void otaTask(void *param) {
 
     OTAWEBUPDATER *otaWebUpdater = (OTAWEBUPDATER *)param;
     for (;;) {
-        yield();
         otaWebUpdater->loop();
-        yield();
-        vTaskDelay(otaWebUpdater->xDelay);
+        otaWebUpdater->waitForEvent();
     }
 }
 
 /**
  * @brief Run our internal routine
+ *
+ * Executes pending updates and due or requested version checks, then arms the
+ * timer for the next regular check. Safe to call at any time. Nothing but the
+ * health check runs while a new image is on trial.
  */
 void OTAWEBUPDATER::loop() {
-    if (newReleaseAvailable)
+    checkBootHealth();
+    if (bootGuard.state() == OTA_BOOT_TRIAL) {
+        scheduleVersionCheck();
+        return;
+    }
+
+    if (benchmarkRequested) {
+        benchmarkRequested = false;
+        runBenchmark(benchmarkMode, benchmarkFile, benchmarkSize);
+    }
+
+    if (newReleaseAvailable && updatePrepared())
         executeUpdate();
 
+    if (multicastRequested) {
+        sendMulticast();
+        multicastRequested = false;
+    }
+
+    if (pushRequested) {
+        pushToTargets();
+        pushRequested = false;
+    }
+
+    if (networkReady && peerUpdates && !peerDiscovery.isAdvertised())
+        advertisePeer();
+
+    if (multicastUpdates && networkReady && !multicastReceiver.isListening()) {
+#if OTAWEBUPDATER_USE_NVS == true
+        const char *nvs = NVS;
+#else
+        const char *nvs = NULL;
+#endif
+        auto accept = [this](const String &sha256, size_t size) {
+            if (sha256.equalsIgnoreCase(installedSha256(U_FLASH)) || bootGuard.isRejected(sha256))
+                return false;
+            OTA_LOG_INFO("[OTA] Receiving multicast firmware " + sha256);
+            emitLifecycle(OTA_LIFECYCLE_PENDING, sha256, 0, size);
+            downloadProgress.reset();
+            prepareEraser.cancel();
+            clearResumePoint(); // the partition is overwritten
+            return true;
+        };
+        if (multicastReceiver.begin(nvs, accept, [this]() { notify(OTA_EVENT_MULTICAST); }))
+            OTA_LOG_INFO("[OTA] Listening for multicast updates");
+    }
+    if (multicastReceiver.available())
+        receiveMulticast();
+
     if (networkReady) {
-        if (initialCheck) {
-            if (millis() - lastVersionCheckMillis < intervalVersionCheckMillis)
-                return;
-            lastVersionCheckMillis = millis();
-        } else
+        bool requested = checkRequested;
+        checkRequested = false;
+
+        if (requested || nowMillis() >= nextVersionCheckMillis) {
             initialCheck = true;
+            lastVersionCheckMillis = nowMillis();
+
+            if (!baseUrl.isEmpty()) {
+                OTA_LOG_INFO("[OTA] Searching a new firmware release");
+                bool success = checkAvailableVersion();
+                planNextVersionCheck(success);
+                if (versionCheckCallback)
+                    versionCheckCallback(success, newReleaseAvailable, manifestCache.version);
+                if (newReleaseAvailable)
+                    emitLifecycle(OTA_LIFECYCLE_PENDING, manifestCache.version);
+                if (newReleaseAvailable && updatePrepared())
+                    executeUpdate();
+                else if (newReleaseAvailable)
+                    httpSession.close(); // the download starts once the partition is erased
+            } else {
+                nextVersionCheckMillis = lastVersionCheckMillis + intervalVersionCheckMillis;
+            }
+        }
+    }
+    scheduleVersionCheck();
+}
 
-        if (baseUrl.isEmpty())
-            return;
-        logMessage("[OTA] Searching a new firmware release");
-        checkAvailableVersion();
+/**
+ * @brief Confirm a new image once it is healthy, or return to the previous one
+ *
+ * The image passes as soon as the network is up and the HealthCheck returns
+ * true. It is reverted if that did not happen within the window after boot,
+ * or if it already restarted more often than allowed. Without setHealthCheck()
+ * a new image is confirmed on the first run of the background task.
+ */
+void OTAWEBUPDATER::checkBootHealth() {
+    if (bootGuard.state() != OTA_BOOT_TRIAL)
+        return;
+
+    const char *reason = NULL;
+    if (!healthWindowMillis) {
+        bootGuard.confirm();
+        OTA_LOG_INFO("[OTA] New image confirmed");
+        return;
+    } else if (bootGuard.boots() > healthMaxBoots) {
+        reason = "restarted too often";
+    } else if (networkReady && (!healthCheck || healthCheck())) {
+        bootGuard.confirm();
+        OTA_LOG_INFO("[OTA] New image is healthy after " + String((uint32_t)(nowMillis() / 1000)) + " s, rollback cancelled");
+        return;
+    } else if (nowMillis() >= healthWindowMillis) {
+        reason = networkReady ? "health check failed" : "no network";
+    } else {
+        return;
     }
+
+    OTA_LOG_ERROR("[OTA] New image is not healthy (" + String(reason) + "), reverting to the previous one");
+    logBuffer.flush();
+    Serial.flush();
+    bootGuard.revert();
+    OTA_LOG_ERROR("[OTA] Unable to revert - " + String(bootGuard.errorString()) + ", keeping the new image");
+    bootGuard.confirm();
+}
+
+/**
+ * @brief Erase the app partition in the background before the update runs
+ * @return true if the update can start now
+ *
+ * Uses the firmware size of the manifest. Nothing is erased if a download of
+ * firmware.bin can be resumed or it is installed already. OTA_EVENT_PREPARED
+ * wakes up the task as soon as the erase is done.
+ */
+bool OTAWEBUPDATER::updatePrepared() {
+    if (!prepareUpdates || prepareEraser.isFinished())
+        return true;
+    if (prepareEraser.isRunning() || otaIsRunning)
+        return false;
+    if (!manifestCache.firmwareSize || artifactInstalled("firmware.bin") || loadResumePoint(baseUrl + "/firmware.bin").offset)
+        return true;
+
+    const esp_partition_t *partition = esp_ota_get_next_update_partition(NULL);
+    if (!prepareEraser.begin(partition, manifestCache.firmwareSize, [this]() { notify(OTA_EVENT_PREPARED); }))
+        return true;
+    OTA_LOG_INFO("[OTA] Erasing partition " + String(partition->label) + " in the background");
+    emitLifecycle(OTA_LIFECYCLE_PREPARING, "firmware.bin", 0, manifestCache.firmwareSize);
+    return false;
 }
 
 /**
  * @brief Execute the version check from the external Webserver
  * @return true if the check was successfull
  * @return false on error
+ *
+ * The request is conditional on the ETag / Last-Modified of the last manifest.
+ * A "304 Not Modified" reuses the cached manifest values without parsing.
  */
 bool OTAWEBUPDATER::checkAvailableVersion() {
     if (baseUrl.isEmpty()) {
-        logMessage("[OTA] No baseUrl configured");
+        OTA_LOG_INFO("[OTA] No baseUrl configured");
         return false;
     }
 
-    WiFiClient client;
-    HTTPClient http;
+    int64_t start = esp_timer_get_time();
+    bool success = fetchManifest();
+    metrics.observeManifest(esp_timer_get_time() - start, success);
+    return success;
+}
+
+/**
+ * @brief Request, parse and evaluate the manifest
+ * @return true if the check was successfull
+ */
+bool OTAWEBUPDATER::fetchManifest() {
+    const char *headerKeys[] = {"ETag", "Last-Modified", "Retry-After", "Cache-Control", "Date"};
+    String manifestUrl = baseUrl + "/current-version.json";
+    uint32_t deadline = millis() + checkConnectTimeout + checkReadTimeout; // for the whole check
+    serverRetryAfterMillis = 0;
+    serverMaxAgeMillis = 0;
+
+    // The binary summary tells if the JSON changed, without parsing or conditional headers
+    OtaBinaryManifest summary;
+    if (binaryManifest) {
+        if (!fetchBinaryManifest(baseUrl + "/current-version.bin", summary))
+            return false;
+        if (summary.crc && summary.crc == manifestCache.binaryCrc && manifestCache.url == manifestUrl && !manifestCache.date.isEmpty()) {
+            OTA_LOG_INFO("[OTA] Manifest not modified");
+            return finishManifestCheck(evaluateManifest());
+        }
+    }
 
-    // Send request
-    http.setFollowRedirects(HTTPC_FORCE_FOLLOW_REDIRECTS);
-    http.useHTTP10(true);
-    http.begin(client, baseUrl + "/current-version.json");
-    http.GET();
+    // Send request over the keep-alive session, the downloads will reuse it
+    int httpCode = httpSession.get(manifestUrl, [&](HTTPClient &http) {
+        http.collectHeaders(headerKeys, 5);
+        if (manifestCache.url == manifestUrl && !manifestCache.date.isEmpty()) {
+            if (!manifestCache.etag.isEmpty())
+                http.addHeader("If-None-Match", manifestCache.etag);
+            if (!manifestCache.lastModified.isEmpty())
+                http.addHeader("If-Modified-Since", manifestCache.lastModified);
+        }
+    }, checkConnectTimeout, checkReadTimeout);
+    HTTPClient &http = httpSession.client();
+    if (httpCode > 0)
+        parseServerHints(http);
+
+    if (httpCode == 304) {
+        httpSession.end();
+        OTA_LOG_INFO("[OTA] Manifest not modified");
+        if (summary.crc && summary.crc != manifestCache.binaryCrc && summary.date == manifestCache.date && summary.version == manifestCache.version) {
+            manifestCache.binaryCrc = summary.crc;
+            saveManifestCache();
+        }
+        return finishManifestCheck(evaluateManifest());
+    }
+    if (httpCode == OTAHTTP_ERROR_DNS) {
+        httpSession.close();
+        OTA_LOG_ERROR("[OTA] Unable to resolve the host of " + manifestUrl + " within " + String(checkConnectTimeout) + " ms");
+        return false;
+    }
+    if (httpCode == OTAHTTP_ERROR_INSECURE) {
+        OTA_LOG_ERROR("[OTA] Refusing " + manifestUrl + " without a CA certificate, see setCACert()");
+        return false;
+    }
+    if (httpCode != 200) {
+        httpSession.close();
+        OTA_LOG_ERROR("[OTA] Unable to load " + manifestUrl + ", HTTP code " + String(httpCode));
+        return false;
+    }
+    OtaDeadlineStream body(http.getStream(), deadline);
+    if (body.expired()) {
+        httpSession.close();
+        OTA_LOG_ERROR("[OTA] Version check of " + manifestUrl + " took too long");
+        return false;
+    }
 
-    // Parse response
+    // Parse response, keeping only the fields we need
+    JsonDocument filter;
+    filter["date"] = true;
+    filter["revision"] = true;
+    filter["rollout"] = true;
+    filter["bundle"] = true;
+    filter["sha256"] = true;
+    filter["signature"] = true;
+    filter["size"]["firmware.bin"] = true;
+    if (deltaUpdates)
+        filter["delta"][ESP.getSketchMD5()] = true;
+
+    // HTTP/1.1 responses without Content-Length are chunked, only getString() decodes that
     JsonDocument doc;
-    deserializeJson(doc, http.getStream());
+    DeserializationError error;
+    if (http.getSize() > 0) {
+        error = deserializeJson(doc, body, DeserializationOption::Filter(filter));
+    } else {
+        // getString() reads on its own, limit each of its reads to the rest of the deadline
+        uint32_t remaining = body.expired() ? 1 : deadline - millis();
+        http.setTimeout(remaining < checkReadTimeout ? remaining : checkReadTimeout);
+        error = deserializeJson(doc, http.getString(), DeserializationOption::Filter(filter));
+    }
+    String etag = http.header("ETag");
+    String lastModified = http.header("Last-Modified");
 
-    // Disconnect
-    http.end();
+    // Keep the connection if the body was read completely
+    if (error)
+        httpSession.close();
+    else
+        httpSession.end();
 
     auto date = doc["date"].as<String>();
     auto revision = doc["revision"].as<String>();
 
-    if (date.isEmpty() || revision.isEmpty() || date == "null" || revision == "null") {
-        logMessage("[OTA] Invalid response or json in " + baseUrl + "/current-version.json");
+    if (error || date.isEmpty() || revision.isEmpty() || date == "null" || revision == "null") {
+        OTA_LOG_ERROR("[OTA] Invalid response or json in " + manifestUrl);
         return false;
     }
-    if (date > currentFwDate) { // a newer Version is available!
-        logMessage("[OTA] Newer firmware available: " + date + " vs " + currentFwDate);
-        newReleaseAvailable = true;
+
+    manifestCache.url = manifestUrl;
+    manifestCache.etag = etag;
+    manifestCache.lastModified = lastModified;
+    manifestCache.date = date;
+    manifestCache.version = revision;
+    manifestCache.deltaFrom = "";
+    manifestCache.deltaFile = "";
+    if (deltaUpdates && doc["delta"][ESP.getSketchMD5()].is<String>()) {
+        manifestCache.deltaFrom = ESP.getSketchMD5();
+        manifestCache.deltaFile = doc["delta"][ESP.getSketchMD5()].as<String>();
     }
-    logMessage("[OTA] No newer firmware available");
-    return true;
+    manifestCache.bundleFile = doc["bundle"] | "";
+    manifestCache.sha256 = "";
+    manifestCache.signatures = "";
+    if (doc["sha256"].is<JsonObject>())
+        serializeJson(doc["sha256"], manifestCache.sha256);
+    if (doc["signature"].is<JsonObject>())
+        serializeJson(doc["signature"], manifestCache.signatures);
+    manifestCache.firmwareSize = doc["size"]["firmware.bin"] | (uint32_t)0;
+    manifestCache.rolloutPercent = doc["rollout"]["percent"] | 100;
+    manifestCache.rolloutSalt = doc["rollout"]["salt"] | revision;
+    manifestCache.notBefore = doc["rollout"]["notBefore"] | (uint32_t)0;
+    // a summary of another release means the upload of the two files is still in progress
+    manifestCache.binaryCrc = summary.date == date && summary.version == revision ? summary.crc : 0;
+    saveManifestCache();
+
+    return finishManifestCheck(evaluateManifest());
 }
 
 /**
- * @brief Download a file from a url and execute the firmware update
- *
- * @param baseUrl HTTPS url to download from
- * @param filename  The filename to download
- * @return true
- * @return false
+ * @brief Load the fixed-layout summary of the manifest
+ * @param url Url of current-version.bin
+ * @param summary Receives the content, its crc stays 0 if the file is missing or invalid
+ * @return false if the server could not be reached
  */
-bool OTAWEBUPDATER::updateFile(String baseUrl, String filename) {
-    if (baseUrl.isEmpty()) {
-        logMessage("[OTA] No baseUrl configured");
+bool OTAWEBUPDATER::fetchBinaryManifest(const String &url, OtaBinaryManifest &summary) {
+    const char *headerKeys[] = {"Retry-After", "Cache-Control", "Date"};
+    int httpCode = httpSession.get(url, [&](HTTPClient &http) { http.collectHeaders(headerKeys, 3); }, checkConnectTimeout, checkReadTimeout);
+    HTTPClient &http = httpSession.client();
+    if (httpCode > 0)
+        parseServerHints(http);
+
+    if (httpCode == OTAHTTP_ERROR_DNS) {
+        httpSession.close();
+        OTA_LOG_ERROR("[OTA] Unable to resolve the host of " + url + " within " + String(checkConnectTimeout) + " ms");
         return false;
     }
-
-    otaIsRunning = true;
-    int filetype = (filename.indexOf("spiffs") > -1 || filename.indexOf("littlefs") > -1) ? U_SPIFFS : U_FLASH;
-
-    String firmwareUrl = baseUrl + "/" + filename;
-    WiFiClient client;
-    HTTPClient http;
-
-    // Reserve some memory to download the file
-    auto bufferAllocationLen = 128 * 1024;
-    uint8_t *buffer;
-    try {
-        buffer = new uint8_t[bufferAllocationLen];
-    } catch (std::bad_alloc &ba) {
-        logMessage("[OTA] Unable to request memory with malloc(" + String(bufferAllocationLen + 1) + ")");
-        otaIsRunning = false;
+    if (httpCode == OTAHTTP_ERROR_INSECURE) {
+        OTA_LOG_ERROR("[OTA] Refusing " + url + " without a CA certificate, see setCACert()");
         return false;
     }
+    if (httpCode <= 0 || httpCode >= 500) {
+        httpSession.close();
+        OTA_LOG_ERROR("[OTA] Unable to load " + url + ", HTTP code " + String(httpCode));
+        return false;
+    }
+    if (httpCode != 200 || http.getSize() != OTAMANIFEST_SIZE) {
+        httpSession.close();
+        OTA_LOG_INFO("[OTA] No binary manifest at " + url + ", HTTP code " + String(httpCode));
+        return true;
+    }
 
-    http.setFollowRedirects(HTTPC_FORCE_FOLLOW_REDIRECTS);
-    http.begin(client, firmwareUrl);
-
-    logMessage("[OTA] Firmware type: " + String(filetype == U_SPIFFS ? "spiffs" : "flash"));
-    logMessage("[OTA] Firmware url:  " + firmwareUrl);
-
-    if (http.GET() == 200) {
-        // get length of document (is -1 when Server sends no Content-Length header)
-        auto totalLength = http.getSize();
-        auto len = totalLength;
-        auto currentLength = 0;
-
-        // this is required to start firmware update process
-        Update.begin(UPDATE_SIZE_UNKNOWN, filetype);
-        logMessage("[OTA] Firmware size: " + String(totalLength));
-
-        // create buffer for read
-        // uint8_t buff[4096] = { 0 };
-        WiFiClient *stream = http.getStreamPtr();
-
-        // read all data from server
-        logMessage("[OTA] Begin firmware upgrade...");
-        while (http.connected() && (len > 0 || len == -1)) {
-            // get available data size
-            size_t size = stream->available();
-            if (size) {
-                // read up to 4096 byte
-                int readBufLen = stream->readBytes(buffer, ((size > bufferAllocationLen) ? bufferAllocationLen : size));
-                if (len > 0)
-                    len -= readBufLen;
-
-                Update.write(buffer, readBufLen);
-                logMessage("[OTA] Status: " + String(currentLength));
-
-                currentLength += readBufLen;
-                if (currentLength != totalLength)
-                    continue;
-                // Update completed
-                Update.end(true);
-                http.end();
-                logMessage("[OTA] Upgrade successfully executed. Wrote bytes: " + String(currentLength));
-
-                otaIsRunning = false;
-                delete[] buffer;
-                return true;
-            }
-            delay(1);
-        }
+    uint8_t buf[OTAMANIFEST_SIZE];
+    if (http.getStream().readBytes(buf, OTAMANIFEST_SIZE) != OTAMANIFEST_SIZE) {
+        httpSession.close();
+        OTA_LOG_ERROR("[OTA] Unable to read " + url);
+        return false;
     }
+    httpSession.end();
 
-    otaIsRunning = false;
-    delete[] buffer;
-    return false;
+    if (memcmp(buf, OTAMANIFEST_MAGIC, 4) != 0 || buf[4] != OTAMANIFEST_VERSION) {
+        OTA_LOG_ERROR("[OTA] Invalid binary manifest at " + url);
+        return true;
+    }
+    char text[25];
+    text[24] = 0;
+    memcpy(text, buf + 16, 24);
+    summary.date = text;
+    memcpy(text, buf + 40, 24);
+    summary.version = text;
+    summary.crc = buf[8] | buf[9] << 8 | buf[10] << 16 | (uint32_t)buf[11] << 24;
+    return true;
 }
 
 /**
- * @brief Execute the update with a firmware from the external Webserver
+ * @brief Close the session unless a download is about to follow
+ * @param result The result of the manifest check
+ * @return result
  */
-void OTAWEBUPDATER::executeUpdate() {
-    if (baseUrl.isEmpty()) {
-        logMessage("[OTA] No baseUrl configured");
-        return;
-    }
-
-    otaIsRunning = true;
-    if (updateFile(baseUrl, "littlefs.bin") && updateFile(baseUrl, "firmware.bin")) {
-        ESP.restart();
-    } else {
-        otaIsRunning = false;
-        logMessage("[OTA] Failed to update firmware");
-    }
+bool OTAWEBUPDATER::finishManifestCheck(bool result) {
+    if (!newReleaseAvailable)
+        httpSession.close(); // no reason to hold a socket (and TLS heap) until the next check
+    return result;
 }
 
-void OTAWEBUPDATER::attachUI() {
-    webServer->on((uiPrefix).c_str(), HTTP_GET, [&](AsyncWebServerRequest *request) {
-        String html = R"html(
-  <!DOCTYPE html>
-<html lang="en">
-<head>
-    <meta charset="UTF-8">
-    <meta name="viewport" content="width=device-width, initial-scale=1.0">
-    <title>ESP32 OTA Updater</title>
-    <style>
-        :root {
-            --primary-color: #2563eb;
-            --success-color: #16a34a;
-            --warning-color: #ca8a04;
-            --error-color: #dc2626;
-            --bg-color: #f8fafc;
-            --card-bg: #ffffff;
-            --text-color: #1e293b;
-            --border-color: #e2e8f0;
-        }
+/**
+ * @brief Compare the (cached) manifest against the running firmware
+ * @return true if the manifest is valid
+ */
+bool OTAWEBUPDATER::evaluateManifest() {
+    if (manifestCache.date.isEmpty())
+        return false;
 
-        body {
-            font-family: system-ui, -apple-system, sans-serif;
-            background: var(--bg-color);
-            color: var(--text-color);
-            margin: 0;
-            padding: 16px;
-            line-height: 1.5;
+    rolloutWaitMillis = 0;
+    if (manifestCache.date > currentFwDate) { // a newer Version is available!
+        OTA_LOG_INFO("[OTA] Newer firmware available: " + manifestCache.date + " vs " + currentFwDate);
+        if (bootGuard.isRejected(manifestEntry(manifestCache.sha256, "firmware.bin"))) {
+            OTA_LOG_INFO("[OTA] This release was reverted on this device, waiting for a newer one");
+            return true;
         }
-
-        .container {
-            max-width: 800px;
-            margin: 0 auto;
+        if (!rolloutAllowed())
+            return true;
+
+        // A patch against the running image, keyed by its MD5
+        deltaFile = "";
+        if (deltaUpdates && !manifestCache.deltaFile.isEmpty() && manifestCache.deltaFrom == ESP.getSketchMD5()) {
+            deltaFile = manifestCache.deltaFile;
+            OTA_LOG_INFO("[OTA] Delta update available: " + deltaFile);
         }
+        bundleFile = manifestCache.bundleFile;
+        if (!bundleFile.isEmpty())
+            OTA_LOG_INFO("[OTA] Update bundle available: " + bundleFile);
+        newReleaseAvailable = true;
+        return true;
+    }
+    OTA_LOG_INFO("[OTA] No newer firmware available");
+    return true;
+}
 
-        .card {
-            background: var(--card-bg);
-            border-radius: 8px;
-            padding: 16px;
-            margin-bottom: 16px;
-            box-shadow: 0 1px 3px rgba(0,0,0,0.1);
-            border: 1px solid var(--border-color);
-        }
+/**
+ * @brief Check if this device belongs to the rollout cohort of the manifest
+ * @return true if the release may be installed now
+ *
+ * The device is in the cohort if its bucket (0..99), derived from the efuse MAC
+ * and the rollout salt, is below the rollout percentage. A new salt selects a
+ * different cohort, by default every revision uses its own.
+ */
+bool OTAWEBUPDATER::rolloutAllowed() {
+    uint8_t bucket = rolloutBucket(manifestCache.rolloutSalt);
+    if (bucket >= manifestCache.rolloutPercent) {
+        OTA_LOG_INFO("[OTA] Release not rolled out to this device yet (bucket " + String(bucket) + ", rollout " + String(manifestCache.rolloutPercent) + "%)");
+        return false;
+    }
 
-        h1, h2 {
-            margin: 0 0 16px 0;
-            color: var(--text-color);
+    if (manifestCache.notBefore) {
+        uint32_t now = currentEpoch();
+        if (!now) {
+            OTA_LOG_INFO("[OTA] Release has a rollout time but the current time is unknown");
+            return false;
         }
-
-        .upload-zone {
-            border: 2px dashed var(--border-color);
-            border-radius: 8px;
-            padding: 32px;
-            text-align: center;
-            cursor: pointer;
-            transition: all 0.2s;
+        if (now < manifestCache.notBefore) {
+            rolloutWaitMillis = (uint64_t)(manifestCache.notBefore - now) * 1000;
+            OTA_LOG_INFO("[OTA] Release is rolled out in " + String(manifestCache.notBefore - now) + " seconds");
+            return false;
         }
+    }
+    return true;
+}
 
-        .upload-zone:hover {
-            border-color: var(--primary-color);
-            background: #f8fafc;
-        }
+/**
+ * @brief Get the rollout bucket of this device
+ * @param salt Selects an independent distribution of the fleet
+ * @return A stable value between 0 and 99
+ */
+uint8_t OTAWEBUPDATER::rolloutBucket(const String &salt) {
+    uint32_t hash = 2166136261UL; // FNV-1a over the salt, seeded into the device hash
+    for (size_t i = 0; i < salt.length(); i++)
+        hash = (hash ^ (uint8_t)salt[i]) * 16777619UL;
+    hash ^= deviceHash;
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bUL;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35UL;
+    hash ^= hash >> 16;
+    return hash % 100;
+}
 
-        .upload-zone.drag-over {
-            border-color: var(--primary-color);
-            background: #eff6ff;
-        }
+/**
+ * @brief Get the current unix time
+ * @return Seconds since 1970 from the system clock, or from the Date header of
+ *         the last manifest response if the clock was never set, 0 if unknown
+ */
+uint32_t OTAWEBUPDATER::currentEpoch() {
+    time_t now = time(NULL);
+    if (now > 1609459200) // 2021-01-01, the clock was set by SNTP or the app
+        return now;
+    if (serverDate)
+        return serverDate + (nowMillis() - serverDateMillis) / 1000;
+    return 0;
+}
 
-        button {
-            background: var(--primary-color);
-            color: white;
-            border: none;
-            padding: 8px 16px;
-            border-radius: 4px;
-            cursor: pointer;
-            font-size: 0.875rem;
-            transition: opacity 0.2s;
-        }
+/**
+ * @brief Parse a RFC 7231 IMF-fixdate like "Sun, 06 Nov 1994 08:49:37 GMT"
+ * @return Seconds since 1970, 0 on error
+ */
+uint32_t OTAWEBUPDATER::parseHttpDate(const String &date) {
+    static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    char month[4] = {0};
+    int day, year, hour, minute, second;
+    if (sscanf(date.c_str(), "%*[^,], %d %3s %d %d:%d:%d", &day, month, &year, &hour, &minute, &second) != 6)
+        return 0;
+    const char *found = strstr(months, month);
+    if (!found || strlen(month) != 3)
+        return 0;
+    int mon = (found - months) / 3 + 1;
+
+    // days since 1970-01-01 of the civil date
+    int y = year - (mon <= 2);
+    int era = y / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (mon + (mon > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t days = (int64_t)era * 146097 + doe - 719468;
+    if (days < 0)
+        return 0;
+    return days * 86400 + hour * 3600 + minute * 60 + second;
+}
 
-        button:hover {
-            opacity: 0.9;
-        }
+/**
+ * @brief Get the value for a file from a cached manifest object
+ * @param json Serialized object like {"firmware.bin": "..."}
+ * @param file The filename to look up
+ * @return The value or an empty string
+ */
+String OTAWEBUPDATER::manifestEntry(const String &json, const String &file) {
+    if (json.isEmpty())
+        return "";
+    JsonDocument doc;
+    if (deserializeJson(doc, json))
+        return "";
+    return doc[file] | "";
+}
 
-        button:disabled {
-            opacity: 0.5;
-            cursor: not-allowed;
-        }
+/**
+ * @brief SHA-256 of the installed firmware or filesystem as hex
+ * @param filetype U_FLASH for the running app, U_SPIFFS for the data partition
+ * @return The hash, empty if the partition can not be read
+ *
+ * Hashing a partition takes a while, the result is computed once and kept in NVS.
+ * The app hash is bound to the sketch MD5 and covers the image only, so it equals
+ * the SHA-256 of firmware.bin. The filesystem hash is replaced by the hash of the
+ * image whenever one is installed, files changed at runtime do not count.
+ */
+String OTAWEBUPDATER::installedSha256(int filetype) {
+    const char *key = filetype == U_SPIFFS ? "fsSha256" : "appSha256";
+    String sha256 = "";
+#if OTAWEBUPDATER_USE_NVS == true
+    if (preferences.begin(NVS, true)) {
+        if (filetype == U_SPIFFS || preferences.getString("appSha256Md5", "") == ESP.getSketchMD5())
+            sha256 = preferences.getString(key, "");
+        preferences.end();
+    }
+    if (!sha256.isEmpty())
+        return sha256;
+#endif
 
-        .status {
-            padding: 8px;
-            border-radius: 4px;
-            margin: 8px 0;
-            display: none;
-        }
+    uint8_t digest[32];
+    if (filetype == U_SPIFFS) {
+        const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, NULL);
+        if (!partition || esp_partition_get_sha256(partition, digest) != ESP_OK)
+            return "";
+        sha256 = OtaImageVerifier::toHex(digest);
+    } else {
+        // esp_partition_get_sha256() of an app omits the appended hash, hash the whole image instead
+        OtaImageVerifier image;
+        image.begin("", "", NULL);
+        if (!image.updateFromPartition(esp_ota_get_running_partition(), ESP.getSketchSize()) || !image.finish())
+            return "";
+        sha256 = image.digestHex();
+    }
+    setInstalledSha256(filetype, sha256);
+    return sha256;
+}
 
-        .status.error {
-            background: #fee2e2;
-            color: #991b1b;
-            display: block;
+/**
+ * @brief Remember the hash of a newly installed image, empty to recompute it
+ * @param filetype U_FLASH or U_SPIFFS
+ * @param sha256 Hex SHA-256 of the image
+ */
+void OTAWEBUPDATER::setInstalledSha256(int filetype, const String &sha256) {
+#if OTAWEBUPDATER_USE_NVS == true
+    if (preferences.begin(NVS, false)) {
+        const char *key = filetype == U_SPIFFS ? "fsSha256" : "appSha256";
+        if (sha256.isEmpty()) {
+            if (preferences.isKey(key))
+                preferences.remove(key);
+        } else if (preferences.getString(key, "") != sha256) {
+            preferences.putString(key, sha256);
         }
+        if (filetype == U_FLASH && !sha256.isEmpty())
+            preferences.putString("appSha256Md5", ESP.getSketchMD5());
+        preferences.end();
+    }
+#endif
+}
 
-        .status.success {
-            background: #dcfce7;
-            color: #166534;
-            display: block;
-        }
+/**
+ * @brief Is the file of the manifest already installed on this device
+ * @param filename firmware.bin or littlefs.bin
+ * @return true if the manifest has a SHA-256 for it that matches the partition
+ */
+bool OTAWEBUPDATER::artifactInstalled(const String &filename) {
+    String expected = manifestEntry(manifestCache.sha256, filename);
+    if (expected.isEmpty())
+        return false;
+    int filetype = (filename.indexOf("spiffs") > -1 || filename.indexOf("littlefs") > -1) ? U_SPIFFS : U_FLASH;
+    return expected.equalsIgnoreCase(installedSha256(filetype));
+}
 
-        .status.info {
-            background: #e0f2fe;
-            color: #075985;
-            display: block;
-        }
+/**
+ * @brief Load the validators and values of the last manifest from NVS
+ */
+void OTAWEBUPDATER::loadManifestCache() {
+#if OTAWEBUPDATER_USE_NVS == true
+    if (preferences.begin(NVS, true)) {
+        manifestCache.url = preferences.getString("mfUrl", "");
+        manifestCache.etag = preferences.getString("mfEtag", "");
+        manifestCache.lastModified = preferences.getString("mfModified", "");
+        manifestCache.date = preferences.getString("mfDate", "");
+        manifestCache.version = preferences.getString("mfRevision", "");
+        manifestCache.deltaFrom = preferences.getString("mfDeltaFrom", "");
+        manifestCache.deltaFile = preferences.getString("mfDeltaFile", "");
+        manifestCache.bundleFile = preferences.getString("mfBundle", "");
+        manifestCache.sha256 = preferences.getString("mfSha256", "");
+        manifestCache.signatures = preferences.getString("mfSignature", "");
+        manifestCache.firmwareSize = preferences.getULong("mfFwSize", 0);
+        manifestCache.rolloutPercent = preferences.getUChar("mfPercent", 100);
+        manifestCache.rolloutSalt = preferences.getString("mfSalt", "");
+        manifestCache.notBefore = preferences.getULong("mfNotBefore", 0);
+        manifestCache.binaryCrc = preferences.getULong("mfBinCrc", 0);
+        preferences.end();
+    }
+#endif
+}
 
-        .grid {
-            display: grid;
-            grid-template-columns: repeat(auto-fit, minmax(200px, 1fr));
-            gap: 16px;
-            margin-top: 16px;
-        }
+/**
+ * @brief Store the validators and values of the last manifest to NVS
+ */
+void OTAWEBUPDATER::saveManifestCache() {
+#if OTAWEBUPDATER_USE_NVS == true
+    if (preferences.begin(NVS, false)) {
+        preferences.putString("mfUrl", manifestCache.url);
+        preferences.putString("mfEtag", manifestCache.etag);
+        preferences.putString("mfModified", manifestCache.lastModified);
+        preferences.putString("mfDate", manifestCache.date);
+        preferences.putString("mfRevision", manifestCache.version);
+        preferences.putString("mfDeltaFrom", manifestCache.deltaFrom);
+        preferences.putString("mfDeltaFile", manifestCache.deltaFile);
+        preferences.putString("mfBundle", manifestCache.bundleFile);
+        preferences.putString("mfSha256", manifestCache.sha256);
+        preferences.putString("mfSignature", manifestCache.signatures);
+        preferences.putULong("mfFwSize", manifestCache.firmwareSize);
+        preferences.putUChar("mfPercent", manifestCache.rolloutPercent);
+        preferences.putString("mfSalt", manifestCache.rolloutSalt);
+        preferences.putULong("mfNotBefore", manifestCache.notBefore);
+        preferences.putULong("mfBinCrc", manifestCache.binaryCrc);
+        preferences.end();
+    }
+#endif
+}
 
-        .stat-card {
-            background: #f8fafc;
-            padding: 12px;
-            border-radius: 6px;
-            border: 1px solid var(--border-color);
+/**
+ * @brief Load the checkpoint of an interrupted download
+ * @param url The url of the file to download
+ * @return The checkpoint, offset is 0 if there is none for this url
+ */
+OtaResumePoint OTAWEBUPDATER::loadResumePoint(String url) {
+    OtaResumePoint resume;
+#if OTAWEBUPDATER_USE_NVS == true
+    if (preferences.begin(NVS, true)) {
+        if (preferences.getString("rsmUrl", "") == url) {
+            resume.url = url;
+            resume.offset = preferences.getULong("rsmOffset", 0);
+            resume.total = preferences.getInt("rsmTotal", -1);
+            resume.validator = preferences.getString("rsmValidator", "");
         }
+        preferences.end();
+    }
+#endif
+    return resume;
+}
 
-        .stat-title {
-            font-size: 0.875rem;
-            color: #64748b;
-            margin-bottom: 4px;
-        }
+/**
+ * @brief Store the checkpoint of a running download
+ * @param resume The current checkpoint, offset must be written to flash already
+ */
+void OTAWEBUPDATER::saveResumePoint(const OtaResumePoint &resume) {
+#if OTAWEBUPDATER_USE_NVS == true
+    if (preferences.begin(NVS, false)) {
+        if (preferences.getString("rsmUrl", "") != resume.url)
+            preferences.putString("rsmUrl", resume.url);
+        if (preferences.getString("rsmValidator", "") != resume.validator)
+            preferences.putString("rsmValidator", resume.validator);
+        preferences.putInt("rsmTotal", resume.total);
+        preferences.putULong("rsmOffset", resume.offset);
+        preferences.end();
+    }
+#endif
+}
+
+/**
+ * @brief Forget the checkpoint after a completed or unrecoverable download
+ */
+void OTAWEBUPDATER::clearResumePoint() {
+#if OTAWEBUPDATER_USE_NVS == true
+    if (preferences.begin(NVS, false)) {
+        if (preferences.isKey("rsmUrl"))
+            preferences.remove("rsmUrl");
+        preferences.end();
+    }
+#endif
+}
+
+/**
+ * @brief Download a file from a url and execute the firmware update
+ *
+ * @param baseUrl HTTPS url to download from
+ * @param filename  The filename to download
+ * @return true
+ * @return false
+ *
+ * @param delta The file is a bsdiff patch against the running firmware
+ *
+ * Lost connections are resumed with a HTTP Range request up to downloadRetries
+ * times. The progress is checkpointed to NVS at sector boundaries, so a later
+ * call for the same file continues where the last one stopped. Delta downloads
+ * are only resumed while the patcher is alive, as its state is not persisted.
+ */
+bool OTAWEBUPDATER::updateFile(String baseUrl, String filename, bool delta) {
+    if (baseUrl.isEmpty()) {
+        OTA_LOG_INFO("[OTA] No baseUrl configured");
+        return false;
+    }
+
+    bool ownsRun = !otaIsRunning.exchange(true); // executeUpdate() keeps it set between the files
+    int64_t startMicros = esp_timer_get_time();
+    metrics.updateStarted();
+    int filetype = (filename.indexOf("spiffs") > -1 || filename.indexOf("littlefs") > -1) ? U_SPIFFS : U_FLASH;
+    if (delta)
+        filetype = U_FLASH;
+
+    String firmwareUrl = baseUrl + "/" + filename;
+    OtaResumePoint resume;
+    if (!delta)
+        resume = loadResumePoint(firmwareUrl);
+    resume.url = firmwareUrl;
+    resume.persistent = !delta;
+
+    OtaPartitionWriter writer;
+    writer.setEraseAhead(flashEraseAhead);
+    if (filetype == U_FLASH)
+        writer.setErased(prepareEraser.take(esp_ota_get_next_update_partition(NULL)));
+    if (!writer.begin(filetype, resume.offset) && !(resume.offset && writer.begin(filetype, 0))) {
+        OTA_LOG_ERROR("[OTA] Unable to open the target partition - " + String(writer.errorString()));
+        metrics.countError(OTA_STAGE_BEGIN, writer.lastError());
+        metrics.updateFinished(false, 0, 0);
+        if (ownsRun)
+            otaIsRunning = false;
+        return false;
+    }
+    if (writer.offset() != resume.offset) { // start over
+        resume.offset = 0;
+        resume.total = -1;
+        resume.validator = "";
+    }
+    if (filetype == U_SPIFFS)
+        setInstalledSha256(U_SPIFFS, ""); // the partition is about to change
+
+    // Hash the image on its way to the flash, a delta must produce the full firmware.bin
+    OtaImageVerifier verifier;
+    String imageName = delta ? "firmware.bin" : filename;
+    if (!verifier.begin(manifestEntry(manifestCache.sha256, imageName), manifestEntry(manifestCache.signatures, imageName), signingKey) ||
+        !verifier.updateFromPartition(writer.partition(), writer.offset())) {
+        OTA_LOG_ERROR("[OTA] Unable to verify " + imageName + " - " + String(verifier.errorString()));
+        metrics.updateFinished(false, 0, 0);
+        writer.abort();
+        if (ownsRun)
+            otaIsRunning = false;
+        return false;
+    }
+    auto imageWriter = [&writer, &verifier](uint8_t *data, size_t len) {
+        verifier.update(data, len);
+        return writer.write(data, len);
+    };
 
-        .stat-value {
-            font-weight: 500;
+    // Rebuild the new image from the running one and the patch
+    OtaDeltaPatcher patcher;
+    auto running = esp_ota_get_running_partition();
+    auto patchWriter = imageWriter;
+    if (delta && !patcher.begin(running, ESP.getSketchSize(), patchWriter)) {
+        OTA_LOG_ERROR("[OTA] Unable to start the delta patcher - " + String(patcher.errorString()));
+        metrics.updateFinished(false, 0, 0);
+        if (ownsRun)
+            otaIsRunning = false;
+        return false;
+    }
+
+    // Decode compressed downloads, raw resumed downloads stay raw
+    OtaDecompressor decoder;
+    OtaDecompressor::Sink decodedWriter = imageWriter;
+    if (delta)
+        decodedWriter = [&patcher](uint8_t *data, size_t len) { return patcher.write(data, len); };
+    if (!decoder.begin(resume.offset ? OTA_COMPRESSION_NONE : OTA_COMPRESSION_AUTO, decodedWriter)) {
+        OTA_LOG_ERROR("[OTA] Unable to start the decompressor - " + String(decoder.errorString()));
+        metrics.updateFinished(false, 0, 0);
+        if (ownsRun)
+            otaIsRunning = false;
+        return false;
+    }
+
+    // Reserve some memory and a writer task to download the file
+    OtaPipeline pipeline;
+    pipeline.setCore(taskConfig.writerCore);
+    pipeline.reserveHeap(decoder.pendingHeap()); // a gzip stream allocates its state after the slots
+    auto flashWriter = [this, &decoder](uint8_t *data, size_t len) {
+        int64_t start = esp_timer_get_time();
+        bool success = decoder.write(data, len);
+        metrics.observeWrite(esp_timer_get_time() - start);
+        return success;
+    };
+    if (!pipeline.begin(flashWriter, pipelineSlots, pipelineSlotSize, bufferStrategy)) {
+        OTA_LOG_ERROR("[OTA] Unable to start the download pipeline, max alloc heap: " + String(ESP.getMaxAllocHeap()) + ", free PSRAM: " + String(ESP.getFreePsram()));
+        metrics.updateFinished(false, 0, 0);
+        if (ownsRun)
+            otaIsRunning = false;
+        return false;
+    }
+    OTA_LOG_DEBUG("[OTA] Download buffers: " + String(pipeline.slots()) + "x" + String(pipeline.slotSize()) + " bytes in " + String(pipeline.inPsram() ? "PSRAM" : "internal heap"));
+
+    OTA_LOG_DEBUG("[OTA] Firmware type: " + String(filetype == U_SPIFFS ? "spiffs" : (delta ? "delta" : "flash")));
+    OTA_LOG_DEBUG("[OTA] Firmware url:  " + firmwareUrl);
+    if (resume.offset)
+        OTA_LOG_INFO("[OTA] Resuming download at byte " + String(resume.offset));
+
+    OtaDownloadResult result = OTA_DOWNLOAD_INTERRUPTED;
+    size_t startOffset = resume.offset;
+    downloadProgress.reset();
+    emitLifecycle(OTA_LIFECYCLE_DOWNLOADING, resume.url, resume.offset, resume.total);
+    for (uint8_t attempt = 0; attempt <= downloadRetries; attempt++) {
+        if (attempt) {
+            metrics.countRetry();
+            OTA_LOG_INFO("[OTA] Download interrupted at byte " + String(resume.offset) + ", retry " + String(attempt) + "/" + String(downloadRetries));
+            delay(attempt * 1000);
         }
 
-        .progress-bar {
-            width: 100%;
-            height: 4px;
-            background: #e2e8f0;
-            border-radius: 2px;
-            overflow: hidden;
-            margin-top: 16px;
+        result = downloadRange(resume, pipeline, writer, decoder);
+        if (result == OTA_DOWNLOAD_RESTART) {
+            // The file changed on the server, written data is worthless
+            OTA_LOG_INFO("[OTA] Remote file changed, restarting the download");
+            pipeline.finish();
+            writer.begin(filetype, 0);
+            resume.offset = 0;
+            resume.total = -1;
+            resume.validator = "";
+            startOffset = 0;
+            clearResumePoint();
+            if (!verifier.begin(manifestEntry(manifestCache.sha256, imageName), manifestEntry(manifestCache.signatures, imageName), signingKey))
+                result = OTA_DOWNLOAD_FAILED;
+            else if (delta && !patcher.begin(running, ESP.getSketchSize(), patchWriter))
+                result = OTA_DOWNLOAD_FAILED;
+            else if (!decoder.begin(OTA_COMPRESSION_AUTO, decodedWriter))
+                result = OTA_DOWNLOAD_FAILED;
+            else if (!pipeline.begin(flashWriter, pipelineSlots, pipelineSlotSize, bufferStrategy))
+                result = OTA_DOWNLOAD_FAILED;
         }
+        if (result == OTA_DOWNLOAD_COMPLETE || result == OTA_DOWNLOAD_FAILED)
+            break;
+    }
 
-        .progress-bar .progress {
-            width: 0%;
-            height: 100%;
-            background: var(--primary-color);
-            transition: width 0.3s ease;
+    // wait for the writer to drain all pending slots
+    bool written = pipeline.finish();
+    if (written && result == OTA_DOWNLOAD_COMPLETE && !decoder.end()) {
+        OTA_LOG_ERROR("[OTA] Decompression failed - " + String(decoder.errorString()));
+        result = OTA_DOWNLOAD_FAILED;
+    } else if (!written && decoder.codec() != OTA_COMPRESSION_NONE) {
+        OTA_LOG_ERROR("[OTA] Decompression failed - " + String(decoder.errorString()));
+    }
+    if (written && delta && result == OTA_DOWNLOAD_COMPLETE && !patcher.end()) {
+        OTA_LOG_ERROR("[OTA] Delta patch failed - " + String(patcher.errorString()));
+        result = OTA_DOWNLOAD_FAILED;
+    } else if (!written && delta) {
+        OTA_LOG_ERROR("[OTA] Delta patch failed - " + String(patcher.errorString()));
+    }
+    if (written && result == OTA_DOWNLOAD_COMPLETE)
+        emitLifecycle(OTA_LIFECYCLE_VERIFYING, resume.url, resume.offset, resume.total);
+    if (written && result == OTA_DOWNLOAD_COMPLETE && !verifier.finish()) {
+        OTA_LOG_ERROR("[OTA] Image verification failed - " + String(verifier.errorString()));
+        result = OTA_DOWNLOAD_FAILED;
+        clearResumePoint();
+    }
+    if (result == OTA_DOWNLOAD_COMPLETE && written) {
+        if (writer.end()) {
+            clearResumePoint();
+            if (filetype == U_SPIFFS)
+                setInstalledSha256(U_SPIFFS, verifier.digestHex());
+            OTA_LOG_INFO("[OTA] Upgrade successfully executed. Wrote bytes: " + String(resume.offset));
+            metrics.updateFinished(true, resume.offset - startOffset, esp_timer_get_time() - startMicros);
+            if (ownsRun)
+                otaIsRunning = false;
+            return true;
         }
+        OTA_LOG_ERROR("[OTA] Image verification failed - " + String(writer.errorString()));
+        metrics.countError(OTA_STAGE_END, writer.lastError());
+        clearResumePoint();
+    } else if (!written) {
+        OTA_LOG_ERROR("[OTA] Error writing to flash - " + String(writer.errorString()));
+        clearResumePoint();
+    } else if (result == OTA_DOWNLOAD_INTERRUPTED) {
+        OTA_LOG_ERROR("[OTA] Download incomplete, will resume at byte " + String(writer.offset() - writer.offset() % OtaPartitionWriter::SECTOR_SIZE));
+    }
+    writer.abort();
+    metrics.updateFinished(false, resume.offset - startOffset, esp_timer_get_time() - startMicros);
 
-        input {
-            padding: 8px;
-            margin: 8px 0 16px;
-            border: 1px solid var(--border-color);
-            border-radius: 4px;
-            box-sizing: border-box;
+    if (ownsRun)
+        otaIsRunning = false;
+    return false;
+}
+
+/**
+ * @brief Run a single HTTP request for the remaining part of a file
+ *
+ * @param resume Url, offset, size and validator of the download, updated while reading
+ * @param pipeline The pipeline to push the data into
+ * @param writer The partition writer behind the pipeline, used for checkpoints
+ * @param decoder The decompressor in front of the writer, configured from Content-Encoding
+ * @return OtaDownloadResult
+ */
+OtaDownloadResult OTAWEBUPDATER::downloadRange(OtaResumePoint &resume, OtaPipeline &pipeline, OtaPartitionWriter &writer, OtaDecompressor &decoder) {
+    const char *headerKeys[] = {"Content-Range", "ETag", "Last-Modified", "Content-Encoding", "Transfer-Encoding"};
+
+    int httpCode = httpSession.get(resume.url, [&](HTTPClient &http) {
+        http.collectHeaders(headerKeys, 5);
+        if (resume.offset) {
+            http.addHeader("Range", "bytes=" + String(resume.offset) + "-");
+            if (!resume.validator.isEmpty())
+                http.addHeader("If-Range", resume.validator);
+        }
+    });
+    HTTPClient &http = httpSession.client();
+    if (httpSession.reused())
+        OTA_LOG_DEBUG("[OTA] Reusing the open connection");
+    String validator = http.header("ETag");
+    if (validator.isEmpty())
+        validator = http.header("Last-Modified");
+
+    size_t skip = 0;
+    if (httpCode == 206) {
+        // Content-Range: bytes <first>-<last>/<total>
+        String range = http.header("Content-Range");
+        int dash = range.indexOf('-');
+        int slash = range.indexOf('/');
+        if (!range.startsWith("bytes ") || dash < 0 || (size_t)range.substring(6, dash).toInt() != resume.offset) {
+            httpSession.close();
+            return OTA_DOWNLOAD_RESTART;
+        }
+        if (slash > -1 && range.substring(slash + 1) != "*") {
+            int total = range.substring(slash + 1).toInt();
+            if (resume.total > 0 && total != resume.total) {
+                httpSession.close();
+                return OTA_DOWNLOAD_RESTART;
+            }
+            resume.total = total;
+        }
+    } else if (httpCode == 200) {
+        if (resume.offset) {
+            // The server ignored the range, skip what we already have if the file is unchanged
+            if (validator != resume.validator || http.getSize() != resume.total) {
+                httpSession.close();
+                return OTA_DOWNLOAD_RESTART;
+            }
+            skip = resume.offset;
+        }
+        resume.total = http.getSize(); // -1 when the server sends no Content-Length header
+    } else {
+        OTA_LOG_ERROR("[OTA] Download failed with HTTP code " + String(httpCode));
+        httpSession.close();
+        return ((httpCode < 0 && httpCode != OTAHTTP_ERROR_INSECURE) || httpCode >= 500) ? OTA_DOWNLOAD_INTERRUPTED : OTA_DOWNLOAD_FAILED;
+    }
+    if (http.header("Transfer-Encoding").indexOf("chunked") > -1) {
+        OTA_LOG_ERROR("[OTA] Chunked transfer encoding is not supported for downloads");
+        httpSession.close();
+        return OTA_DOWNLOAD_FAILED;
+    }
+    if (resume.validator.isEmpty())
+        resume.validator = validator;
+    OTA_LOG_DEBUG("[OTA] Firmware size: " + String(resume.total));
+
+    // An encoded stream can not be continued after a reboot, the decoder state is lost
+    OtaCompression encoding = OtaDecompressor::fromContentEncoding(http.header("Content-Encoding"));
+    if (encoding != OTA_COMPRESSION_AUTO && resume.offset == 0 && decoder.produced() == 0 && !decoder.begin(encoding, decoder.sink())) {
+        httpSession.close();
+        return OTA_DOWNLOAD_FAILED;
+    }
+    if (encoding == OTA_COMPRESSION_GZIP || encoding == OTA_COMPRESSION_DEFLATE)
+        resume.persistent = false;
+
+    size_t checkpoint = writer.flushed();
+    if (resume.persistent && resume.total > 0)
+        saveResumePoint(resume);
+
+    // read all data from server, the pipeline writes it to flash in parallel
+    WiFiClient *stream = http.getStreamPtr();
+    int64_t waitStart = esp_timer_get_time(); // the network wait of a chunk starts after the previous one
+    uint32_t lastData = millis();
+    while (http.connected() && (resume.total < 0 || resume.offset < (size_t)resume.total)) {
+        // get available data size
+        size_t size = stream->available();
+        if (!size) {
+            // a server that keeps the connection open but stopped sending, resumed like a lost connection
+            if (millis() - lastData >= httpSession.timeout()) {
+                OTA_LOG_ERROR("[OTA] No data received for " + String(httpSession.timeout()) + " ms");
+                break;
+            }
+            delay(1);
+            continue;
         }
 
-        #switchPartitionBtn {
-            background: var(--warning-color);
+        int64_t acquireStart = esp_timer_get_time();
+        uint8_t *slot = pipeline.acquire();
+        if (!slot)
+            break; // flash writer failed
+        int64_t readStart = esp_timer_get_time();
+        metrics.observeSlotWait(readStart - acquireStart);
+
+        size_t want = (size > pipeline.slotSize()) ? pipeline.slotSize() : size;
+        if (skip && want > skip)
+            want = skip;
+        int readBufLen = stream->readBytes(slot, want);
+        int64_t readEnd = esp_timer_get_time();
+        lastData = millis();
+        uint32_t networkWait = (acquireStart - waitStart) + (readEnd - readStart);
+        metrics.observeRead(networkWait, readBufLen);
+        waitStart = readEnd;
+        if (readSamples) {
+            readSamples->observe(networkWait);
+            if (!benchmark.firstByteMicros && readBufLen > 0)
+                benchmark.firstByteMicros = readEnd - benchmarkStartMicros;
         }
+        metrics.sampleHeap();
 
-        .small-text {
-            font-size: 0.875rem;
-            color: #64748b;
+        if (skip) {
+            skip -= readBufLen;
+            pipeline.commit(slot, 0);
+            continue;
         }
-    </style>
-</head>
-<body>
-    <div class="container">
-        <div class="card">
-            <h1>ESP32 OTA Updater</h1>
-            <div id="status"></div>
-            
-            <div id="uploadZone" class="upload-zone">
-                <div>Drag and drop firmware file here or click to select</div>
-                <input type="file" id="fileInput" style="display: none" accept=".bin">
-                <div class="progress-bar">
-                    <div class="progress" id="uploadProgress"></div>
-                </div>
-            </div>
-
-            <label for="otaPassword">(Optional) OTA Password:</label>
-            <input type="text" id="otaPassword" required>
-        </div>
-
-        <div class="card">
-            <h2>Firmware Information</h2>
-            <div id="firmwareInfo"></div>
-            <button id="switchPartitionBtn" onclick="switchPartition()">Switch Active Partition</button>
-        </div>
-
-        <div class="card">
-            <h2>System Information</h2>
-            <div id="systemInfo" class="grid"></div>
-        </div>
-  )html";
-#if OTAWEBUPDATER_USE_NVS == true
-        html += R"html(
-        <div class="card">
-            <h2>Configuration</h2>
-            <div id="configuration"></div>
-            <button onclick="saveConfig()">Save Settings</button>
-        </div>
-    )html";
-#endif
-        html += R"html(
-    </div>
-
-    <script>
-        const API_BASE = '/api/ota';
-        
-        // Initialize the page
-        window.addEventListener('load', () => {
-            loadFirmwareInfo();
-            loadSystemInfo();
-            setupFileUpload();
-            if (document.getElementById('configuration')) getConfig();
-        });
-
-        async function getConfig() {
-            try {
-                const response = await fetch(`${API_BASE}/config`);
-                const data = await response.json();
-
-                const element = document.getElementById('configuration');
-                if (element) {
-                    element.innerHTML = `
-                    <div class="grid">
-                      <div class="stat-card">
-                          <div class="stat-title">Automatic Update URL</div>
-                          <div class="stat-value">
-                            <input type="text" id="baseUrl" value="${data.baseUrl}">
-                          </div>
-                      </div>
-                      <div class="stat-card">
-                          <div class="stat-title">Automatic Update Interval in Minutes</div>
-                          <div class="stat-value">
-                            <input type="number" id="intervalVersionCheck" value="${data.intervalVersionCheck}">
-                          </div>
-                      </div>
-                    </div>
-                `;
-                } // else NVS disabled
-            } catch (error) {
-                showStatus('Failed to load config');
-            }
+        if (!pipeline.commit(slot, readBufLen))
+            break;
+        resume.offset += readBufLen;
+        if (downloadProgress.due(resume.offset, resume.total)) {
+            OTA_LOG_INFO("[OTA] Status: " + String(resume.offset) + (resume.total > 0 ? " of " + String(resume.total) + " bytes" : " bytes"));
+            if (!benchmark.running)
+                emitLifecycle(OTA_LIFECYCLE_DOWNLOADING, resume.url, resume.offset, resume.total);
         }
 
-        async function saveConfig() {
-          try {
-            const response = await fetch(`${API_BASE}/config`, {
-              method: 'POST',
-              headers: {
-                'Content-Type': 'application/json'
-              },
-              body: JSON.stringify({
-                baseUrl: document.getElementById('baseUrl').value,
-                intervalVersionCheck: document.getElementById('intervalVersionCheck').value
-              })
-            })
-          } catch (error) {
-              showStatus('Failed to save config');
-          }
+        // checkpoint the flash position every few sectors
+        // that the writer task has stored, the sector it is working on may not be on the flash yet
+        if (resume.persistent && decoder.codec() == OTA_COMPRESSION_NONE && resume.total > 0 && writer.flushed() - checkpoint >= resumeCheckpointBytes) {
+            checkpoint = writer.flushed();
+            OtaResumePoint flashed = resume;
+            flashed.offset = checkpoint;
+            saveResumePoint(flashed);
         }
+    }
+    bool connected = http.connected();
+    bool complete = resume.total >= 0 ? resume.offset == (size_t)resume.total : (!connected && resume.offset > 0);
+
+    // Only a completely read body leaves the connection usable for the next file
+    if (complete && !pipeline.failed())
+        httpSession.end();
+    else
+        httpSession.close();
+
+    if (pipeline.failed())
+        return OTA_DOWNLOAD_FAILED;
+    return complete ? OTA_DOWNLOAD_COMPLETE : OTA_DOWNLOAD_INTERRUPTED;
+}
 
-        async function loadFirmwareInfo() {
-            try {
-                const response = await fetch(`${API_BASE}/firmware/info`);
-                const data = await response.json();
-                
-                document.getElementById('firmwareInfo').innerHTML = `
-                    <div class="grid">
-                        <div class="stat-card">
-                            <div class="stat-title">Partition</div>
-                            <div class="stat-value">${data.label}</div>
-                        </div>
-                        <div class="stat-card">
-                            <div class="stat-title">Version</div>
-                            <div class="stat-value">${data.firmware_version}</div>
-                        </div>
-                        <div class="stat-card">
-                            <div class="stat-title">Build Date</div>
-                            <div class="stat-value">${data.firmware_date}</div>
-                        </div>
-                    </div>
-                `;
-            } catch (error) {
-                showStatus('Failed to load firmware info: ' + error.message, 'error');
-            }
+/**
+ * @brief Execute the update with a firmware from the external Webserver
+ */
+void OTAWEBUPDATER::executeUpdate() {
+    if (baseUrl.isEmpty()) {
+        OTA_LOG_INFO("[OTA] No baseUrl configured");
+        return;
+    }
+
+    otaIsRunning = true;
+    setDownloadPhase(true);
+    bool success = false;
+    if (!bundleFile.isEmpty()) {
+        success = updateBundle(baseUrl, bundleFile); // all or nothing
+    } else {
+        // skip the images the manifest lists with the hash of the installed ones
+        bool fsInstalled = artifactInstalled("littlefs.bin");
+        bool appInstalled = artifactInstalled("firmware.bin");
+        if (fsInstalled)
+            OTA_LOG_INFO("[OTA] littlefs.bin is already installed, skipping it");
+        if (appInstalled)
+            OTA_LOG_INFO("[OTA] firmware.bin is already installed, skipping it");
+        if (fsInstalled && appInstalled) {
+            setDownloadPhase(false);
+            abortLifecycle("already installed");
+            return;
         }
+        success = (fsInstalled || updateFile(baseUrl, "littlefs.bin")) && (appInstalled || updateFirmware());
+    }
+    if (success) {
+        httpSession.close();
+        emitLifecycle(OTA_LIFECYCLE_COMMITTING);
+        bootGuard.arm();
+        logBuffer.flush();
+        ESP.restart();
+    } else {
+        httpSession.close();
+        setDownloadPhase(false);
+        OTA_LOG_ERROR("[OTA] Failed to update firmware");
+        abortLifecycle("update failed");
+    }
+}
 
-        async function loadSystemInfo() {
-            try {
-                const response = await fetch(`${API_BASE}/esp`);
-                const data = await response.json();
-                
-                const systemInfoHtml = `
-                    <div class="stat-card">
-                        <div class="stat-title">CPU</div>
-                        <div class="stat-value">${data.chip.model}</div>
-                        <div class="small-text">${data.chip.cores} cores @ ${data.chip.cpuFreqMHz}MHz</div>
-                    </div>
-                    <div class="stat-card">
-                        <div class="stat-title">Temperature</div>
-                        <div class="stat-value">${data.chip.temperature.toFixed(1)}°C</div>
-                    </div>
-                    <div class="stat-card">
-                        <div class="stat-title">RAM Usage</div>
-                        <div class="stat-value">${(100 - data.ram.usagePercent).toFixed(1)}%</div>
-                        <div class="small-text">${(data.ram.freeHeap/1024).toFixed(1)}KB free of ${(data.ram.heapSize/1024).toFixed(1)}KB</div>
-                    </div>
-                    <div class="stat-card">
-                        <div class="stat-title">Flash</div>
-                        <div class="stat-value">${(data.flash.flashChipSize/1048576).toFixed(1)} MB</div>
-                        <div class="small-text">${data.flash.flashChipSpeedMHz} MHz</div>
-                    </div>
-                    <div class="stat-card">
-                        <div class="stat-title">Sketch Size</div>
-                        <div class="stat-value">${(data.sketch.usagePercent).toFixed(1)}%</div>
-                        <div class="small-text">${(data.sketch.size/1024).toFixed(1)}KB of ${(data.sketch.maxSize/1024).toFixed(1)}KB</div>
-                    </div>
-                    <div class="stat-card">
-                        <div class="stat-title">Next Boot Partition</div>
-                        <div class="stat-value">${data.bootPartition.label}</div>
-                        <div class="small-text">${data.bootPartition.type}</div>
-                    </div>
-                `;
-
-                document.getElementById('systemInfo').innerHTML = systemInfoHtml;
-            } catch (error) {
-                showStatus('Failed to load system info: ' + error.message, 'error');
-            }
+/**
+ * @brief Download an update bundle and install all of its artifacts
+ *
+ * @param baseUrl HTTPS url to download from
+ * @param filename The bundle filename, see OtaBundle for the format
+ * @return true if all artifacts were verified and the new app was activated
+ *
+ * The bundle is read in a single pass over one connection. The boot partition
+ * is only switched after the last artifact verified, a failed bundle leaves the
+ * running firmware active. Lost connections are resumed within this call, but
+ * not after a reboot.
+ */
+bool OTAWEBUPDATER::updateBundle(String baseUrl, String filename) {
+    if (baseUrl.isEmpty()) {
+        OTA_LOG_INFO("[OTA] No baseUrl configured");
+        return false;
+    }
+
+    bool ownsRun = !otaIsRunning.exchange(true); // executeUpdate() keeps it set between the files
+    int64_t startMicros = esp_timer_get_time();
+    metrics.updateStarted();
+
+    OtaResumePoint resume;
+    resume.url = baseUrl + "/" + filename;
+    resume.persistent = false;
+
+    // The signature covers the header with the artifact hashes and is checked before
+    // anything is written, the optional sha256 of the manifest covers the whole bundle
+    OtaImageVerifier verifier;
+    OtaImageVerifier headerVerifier;
+    if (!verifier.begin(manifestEntry(manifestCache.sha256, filename), "", NULL) ||
+        !headerVerifier.begin("", manifestEntry(manifestCache.signatures, filename), signingKey)) {
+        OTA_LOG_ERROR("[OTA] Unable to verify " + filename + " - " + String(verifier.errorString()) + String(headerVerifier.errorString()));
+        metrics.updateFinished(false, 0, 0);
+        if (ownsRun)
+            otaIsRunning = false;
+        return false;
+    }
+    auto headerCheck = [&headerVerifier](const uint8_t *digest) { return headerVerifier.checkSignature(digest); };
+
+    OtaBundle bundle;
+    bundle.setEraseAhead(flashEraseAhead);
+    bundle.setAppErased(prepareEraser.take(esp_ota_get_next_update_partition(NULL)));
+    bundle.begin(headerCheck);
+    setInstalledSha256(U_SPIFFS, ""); // the bundle may replace the filesystem
+
+    // Bundles can be served gzip compressed as a whole
+    OtaDecompressor decoder;
+    auto bundleWriter = [&bundle, &verifier](uint8_t *data, size_t len) {
+        verifier.update(data, len);
+        return bundle.write(data, len);
+    };
+    if (!decoder.begin(OTA_COMPRESSION_AUTO, bundleWriter)) {
+        OTA_LOG_ERROR("[OTA] Unable to start the decompressor - " + String(decoder.errorString()));
+        metrics.updateFinished(false, 0, 0);
+        if (ownsRun)
+            otaIsRunning = false;
+        return false;
+    }
+
+    OtaPipeline pipeline;
+    pipeline.setCore(taskConfig.writerCore);
+    pipeline.reserveHeap(decoder.pendingHeap()); // a gzip stream allocates its state after the slots
+    auto flashWriter = [this, &decoder](uint8_t *data, size_t len) {
+        int64_t start = esp_timer_get_time();
+        bool success = decoder.write(data, len);
+        metrics.observeWrite(esp_timer_get_time() - start);
+        return success;
+    };
+    if (!pipeline.begin(flashWriter, pipelineSlots, pipelineSlotSize, bufferStrategy)) {
+        OTA_LOG_ERROR("[OTA] Unable to start the download pipeline, max alloc heap: " + String(ESP.getMaxAllocHeap()) + ", free PSRAM: " + String(ESP.getFreePsram()));
+        metrics.updateFinished(false, 0, 0);
+        if (ownsRun)
+            otaIsRunning = false;
+        return false;
+    }
+    OTA_LOG_DEBUG("[OTA] Bundle url: " + resume.url);
+
+    // the bundle writes the partitions itself, this one is only used for checkpoints
+    OtaPartitionWriter unused;
+    OtaDownloadResult result = OTA_DOWNLOAD_INTERRUPTED;
+    downloadProgress.reset();
+    emitLifecycle(OTA_LIFECYCLE_DOWNLOADING, resume.url, resume.offset, resume.total);
+    for (uint8_t attempt = 0; attempt <= downloadRetries; attempt++) {
+        if (attempt) {
+            metrics.countRetry();
+            OTA_LOG_ERROR("[OTA] Download interrupted at byte " + String(resume.offset) + ", retry " + String(attempt) + "/" + String(downloadRetries));
+            delay(attempt * 1000);
         }
 
-        function setupFileUpload() {
-            const uploadZone = document.getElementById('uploadZone');
-            const fileInput = document.getElementById('fileInput');
-
-            uploadZone.addEventListener('click', () => fileInput.click());
-            
-            uploadZone.addEventListener('dragover', (e) => {
-                e.preventDefault();
-                uploadZone.classList.add('drag-over');
-            });
-
-            uploadZone.addEventListener('dragleave', () => {
-                uploadZone.classList.remove('drag-over');
-            });
-
-            uploadZone.addEventListener('drop', (e) => {
-                e.preventDefault();
-                uploadZone.classList.remove('drag-over');
-                const file = e.dataTransfer.files[0];
-                if (file) handleFile(file);
-            });
-
-            fileInput.addEventListener('change', (e) => {
-                const file = e.target.files[0];
-                if (file) handleFile(file);
-            });
+        result = downloadRange(resume, pipeline, unused, decoder);
+        if (result == OTA_DOWNLOAD_RESTART) {
+            OTA_LOG_INFO("[OTA] Remote file changed, restarting the download");
+            pipeline.finish();
+            resume.offset = 0;
+            resume.total = -1;
+            resume.validator = "";
+            bundle.begin(headerCheck);
+            if (!verifier.begin(manifestEntry(manifestCache.sha256, filename), "", NULL) ||
+                !decoder.begin(OTA_COMPRESSION_AUTO, bundleWriter) || !pipeline.begin(flashWriter, pipelineSlots, pipelineSlotSize, bufferStrategy))
+                result = OTA_DOWNLOAD_FAILED;
         }
+        if (result == OTA_DOWNLOAD_COMPLETE || result == OTA_DOWNLOAD_FAILED)
+            break;
+    }
 
-        async function handleFile(file) {
-            if (!file.name.endsWith('.bin')) {
-                showStatus('Please select a valid firmware file (.bin)', 'error');
-                return;
-            }
+    bool written = pipeline.finish();
+    bool success = false;
+    if (written && result == OTA_DOWNLOAD_COMPLETE)
+        emitLifecycle(OTA_LIFECYCLE_VERIFYING, resume.url, resume.offset, resume.total);
+    if (!written || result != OTA_DOWNLOAD_COMPLETE) {
+        OTA_LOG_ERROR("[OTA] Bundle download failed - " + String(bundle.errorString()) + " " + String(decoder.errorString()));
+    } else if (!decoder.end()) {
+        OTA_LOG_ERROR("[OTA] Decompression failed - " + String(decoder.errorString()));
+    } else if (!verifier.finish()) {
+        OTA_LOG_ERROR("[OTA] Bundle verification failed - " + String(verifier.errorString()));
+    } else if (!bundle.end()) {
+        OTA_LOG_ERROR("[OTA] Bundle verification failed - " + String(bundle.errorString()));
+    } else {
+        OTA_LOG_INFO("[OTA] Bundle with " + String(bundle.artifacts()) + " artifacts installed. Read bytes: " + String(resume.offset));
+        success = true;
+    }
+    if (!success)
+        bundle.abort();
 
-            const formData = new FormData();
-            formData.append('file', file);
-
-            try {
-                const otaPassword = document.getElementById('otaPassword').value;
-
-                const xhr = new XMLHttpRequest();
-                if (otaPassword.length) {
-                  xhr.open('POST', `${API_BASE}/upload`, true, 'ota', otaPassword);
-                } else {
-                  xhr.open('POST', `${API_BASE}/upload`, true);
-                }
-
-                xhr.upload.onprogress = (e) => {
-                    if (e.lengthComputable) {
-                        const percentComplete = (e.loaded / e.total) * 100;
-                        document.getElementById('uploadProgress').style.width = percentComplete + '%';
-                    }
-                };
-
-                xhr.onload = function() {
-                    if (xhr.status === 200) {
-                        showStatus('Firmware uploaded successfully. Device will reboot...', 'success');
-                        // Reset progress bar after short delay
-                        setTimeout(() => {
-                            document.getElementById('uploadProgress').style.width = '0%';
-                        }, 2000);
-                    } else {
-                        showStatus('Upload failed: ' + xhr.responseText, 'error');
-                    }
-                };
-
-                xhr.onerror = function() {
-                    showStatus('Upload failed', 'error');
-                };
-
-                showStatus('Uploading firmware...', 'info');
-                xhr.send(formData);
-            } catch (error) {
-                showStatus('Upload failed: ' + error.message, 'error');
-            }
+    metrics.updateFinished(success, resume.offset, esp_timer_get_time() - startMicros);
+    if (ownsRun)
+        otaIsRunning = false;
+    return success;
+}
+
+/**
+ * @brief Measure the update path without installing anything
+ *
+ * @param mode See OtaBenchmarkMode
+ * @param filename The test file on the baseUrl, an app image for the write mode
+ * @param size Bytes to erase and write in the flash mode
+ * @return true if the run completed, the result is in benchmarkResult()
+ *
+ * Downloads run through the same pipeline, decoder and partition writer as
+ * updateFile(). The inactive app partition is overwritten by the write and flash
+ * modes but never activated, a checkpoint of an interrupted download is dropped.
+ */
+bool OTAWEBUPDATER::runBenchmark(OtaBenchmarkMode mode, String filename, size_t size) {
+    if (otaIsRunning)
+        return false;
+    otaIsRunning = true;
+    setDownloadPhase(true);
+    benchmark = OtaBenchmarkResult();
+    benchmark.mode = mode;
+    benchmark.running = true;
+    OTA_LOG_INFO("[OTA] Running the " + String(OtaBenchmarkResult::modeName(mode)) + " benchmark");
+
+    // the samples are only needed during the run
+    OtaLatencySamples *reads = new (std::nothrow) OtaLatencySamples;
+    OtaLatencySamples *writes = new (std::nothrow) OtaLatencySamples;
+    bool success = false;
+    int64_t start = esp_timer_get_time();
+    if (!reads || !writes) {
+        benchmark.error = "Out of memory";
+    } else {
+        if (mode != OTA_BENCHMARK_DISCARD) {
+            prepareEraser.cancel();
+            clearResumePoint();
         }
+        if (mode == OTA_BENCHMARK_FLASH)
+            success = benchmarkFlash(size, *reads, *writes); // the first reservoir holds the erases
+        else
+            success = benchmarkDownload(mode, filename, *reads, *writes);
+        benchmark.micros = esp_timer_get_time() - start;
+        if (mode == OTA_BENCHMARK_FLASH)
+            benchmark.erase = reads->summary();
+        else
+            benchmark.read = reads->summary();
+        benchmark.write = writes->summary();
+    }
+    delete reads;
+    delete writes;
 
-        async function switchPartition() {
-            try {
-                const response = await fetch(`${API_BASE}/partition/switch`, {
-                    method: 'POST',
-                    headers: {
-                        'Content-Type': 'application/json',
-                    }
-                });
-                
-                if (response.ok) {
-                    const data = await response.json();
-                    showStatus(data.message + ' Device will reboot...', 'success');
-                    setTimeout(() => location.reload(), 5000);
-                } else {
-                    const json = await response.json();
-                    if (json.message) {
-                      throw new Error(json.message);
-                    } else {
-                      throw new Error('Failed to switch partition');
-                    }
-                }
-            } catch (error) {
-                showStatus('Failed to switch partition: ' + error.message, 'error');
-            }
+    benchmark.success = success;
+    benchmark.running = false;
+    setDownloadPhase(false);
+    otaIsRunning = false;
+    if (success)
+        OTA_LOG_INFO("[OTA] Benchmark done: " + String(benchmark.bytes) + " bytes in " + String(benchmark.micros / 1000) + " ms, " + String(benchmark.mbps(), 3) + " MB/s");
+    else
+        OTA_LOG_ERROR("[OTA] Benchmark failed - " + benchmark.error);
+    return success;
+}
+
+/**
+ * @brief Download the test file, optionally into the inactive app partition
+ */
+bool OTAWEBUPDATER::benchmarkDownload(OtaBenchmarkMode mode, String filename, OtaLatencySamples &reads, OtaLatencySamples &writes) {
+    if (baseUrl.isEmpty()) {
+        benchmark.error = "No baseUrl configured";
+        return false;
+    }
+
+    OtaPartitionWriter writer;
+    writer.setEraseAhead(flashEraseAhead);
+    if (mode == OTA_BENCHMARK_WRITE && !writer.begin(U_FLASH, 0)) {
+        benchmark.error = writer.errorString();
+        return false;
+    }
+
+    auto sink = [&](uint8_t *data, size_t len) {
+        int64_t begin = esp_timer_get_time();
+        bool success = mode != OTA_BENCHMARK_WRITE || writer.write(data, len);
+        writes.observe(esp_timer_get_time() - begin);
+        return success;
+    };
+    OtaDecompressor decoder;
+    OtaPipeline pipeline;
+    pipeline.setCore(taskConfig.writerCore);
+    if (!decoder.begin(OTA_COMPRESSION_NONE, sink) ||
+        !pipeline.begin([&decoder](uint8_t *data, size_t len) { return decoder.write(data, len); }, pipelineSlots, pipelineSlotSize, bufferStrategy)) {
+        benchmark.error = "Unable to start the download pipeline";
+        writer.abort();
+        return false;
+    }
+
+    OtaResumePoint resume;
+    resume.url = baseUrl + "/" + filename;
+    resume.persistent = false;
+    benchmarkStartMicros = esp_timer_get_time();
+    readSamples = &reads;
+    OtaDownloadResult result = downloadRange(resume, pipeline, writer, decoder);
+    readSamples = NULL;
+    bool written = pipeline.finish();
+    writer.abort(); // never activated
+    httpSession.close();
+
+    benchmark.bytes = resume.offset;
+    if (!written)
+        benchmark.error = mode == OTA_BENCHMARK_WRITE ? writer.errorString() : "Pipeline failed";
+    else if (result != OTA_DOWNLOAD_COMPLETE)
+        benchmark.error = "Download of " + resume.url + " failed";
+    return written && result == OTA_DOWNLOAD_COMPLETE;
+}
+
+/**
+ * @brief Erase and write the inactive app partition, without any network
+ */
+bool OTAWEBUPDATER::benchmarkFlash(size_t size, OtaLatencySamples &erases, OtaLatencySamples &writes) {
+    const size_t sector = OtaPartitionWriter::SECTOR_SIZE;
+    const esp_partition_t *partition = esp_ota_get_next_update_partition(NULL);
+    if (!partition) {
+        benchmark.error = "No app partition to write";
+        return false;
+    }
+    size = (size + sector - 1) / sector * sector;
+    if (!size || size > partition->size)
+        size = partition->size;
+
+    // erase in the steps the writer would use
+    size_t step = flashEraseAhead < sector ? sector : flashEraseAhead - flashEraseAhead % sector;
+    for (size_t pos = 0; pos < size; pos += step) {
+        size_t len = size - pos < step ? size - pos : step;
+        int64_t begin = esp_timer_get_time();
+        esp_err_t err = esp_partition_erase_range(partition, pos, len);
+        erases.observe(esp_timer_get_time() - begin);
+        if (err != ESP_OK) {
+            benchmark.error = esp_err_to_name(err);
+            return false;
         }
+    }
 
-        function showStatus(message, type) {
-            const statusElement = document.getElementById('status');
-            statusElement.innerHTML = message;
-            statusElement.className = `status ${type}`;
+    uint8_t *data = (uint8_t *)malloc(sector);
+    if (!data) {
+        benchmark.error = "Out of memory";
+        return false;
+    }
+    esp_fill_random(data, sector);
+    data[0] = ESP_IMAGE_HEADER_MAGIC;
+
+    OtaPartitionWriter writer;
+    writer.setErased(size);
+    bool success = writer.begin(U_FLASH, 0);
+    for (size_t pos = 0; success && pos < size; pos += sector) {
+        int64_t begin = esp_timer_get_time();
+        success = writer.write(data, sector);
+        writes.observe(esp_timer_get_time() - begin);
+        benchmark.bytes = pos + sector;
+    }
+    if (!success)
+        benchmark.error = writer.errorString();
+    writer.abort(); // never activated
+    free(data);
+    return success;
+}
+
+/**
+ * @brief Install the firmware, as delta patch if the manifest offered one
+ * @return true on success
+ *
+ * With peer updates, devices on the LAN that run the release are tried first.
+ * A failed delta update falls back to the full firmware.bin.
+ */
+bool OTAWEBUPDATER::updateFirmware() {
+    if (peerUpdates && updateFromPeer())
+        return true;
+    if (!deltaFile.isEmpty()) {
+        if (updateFile(baseUrl, deltaFile, true))
+            return true;
+        OTA_LOG_ERROR("[OTA] Delta update failed, falling back to the full image");
+    }
+    return updateFile(baseUrl, "firmware.bin");
+}
+
+/**
+ * @brief Download firmware.bin from a device on the LAN
+ * @return true if a peer delivered a valid image
+ *
+ * Peers are only picked by the announced hash, the image itself is verified
+ * against the sha256 (and signature) of the manifest like any other download.
+ * Without a hash in the manifest there is nothing to trust a peer with. A
+ * resumable download from the baseUrl is continued instead.
+ */
+bool OTAWEBUPDATER::updateFromPeer() {
+    String expected = manifestEntry(manifestCache.sha256, "firmware.bin");
+    if (expected.isEmpty() || loadResumePoint(baseUrl + "/firmware.bin").offset)
+        return false;
+
+    String peers[OTAPEER_MAX_PEERS];
+    uint8_t found = peerDiscovery.find(expected, peers, OTAPEER_MAX_PEERS);
+    OTA_LOG_DEBUG("[OTA] Found " + String(found) + " peers with the release");
+    for (uint8_t i = 0; i < found; i++) {
+        OTA_LOG_INFO("[OTA] Downloading firmware.bin from peer " + peers[i]);
+        if (updateFile(peers[i], "firmware.bin"))
+            return true;
+        OTA_LOG_ERROR("[OTA] Download from peer " + peers[i] + " failed");
+    }
+    return false;
+}
+
+/**
+ * @brief Announce the running firmware via mDNS
+ *
+ * The hash of the running image is computed once and cached in NVS, see
+ * installedSha256(). Retried on the next wake up if mDNS is not running yet.
+ */
+void OTAWEBUPDATER::advertisePeer() {
+    if (peerSha256.isEmpty()) {
+        peerImageSize = ESP.getSketchSize();
+        peerSha256 = installedSha256(U_FLASH);
+    }
+    if (peerSha256.isEmpty())
+        return;
+    if (peerDiscovery.advertise(peerPort, apiPrefix + "/peer", peerSha256))
+        OTA_LOG_INFO("[OTA] Serving firmware " + peerSha256 + " to peers");
+    else
+        OTA_LOG_DEBUG("[OTA] Unable to announce the firmware, call MDNS.begin() first");
+}
+
+/**
+ * @brief Send the running firmware to all nodes of the LAN
+ * @return true if no node misses a block at the end
+ *
+ * The nodes verify the image against the hash of the running firmware, and
+ * the signature of the manifest if it lists the same hash.
+ */
+bool OTAWEBUPDATER::sendMulticast() {
+    String sha256 = installedSha256(U_FLASH);
+    String signature = "";
+    if (sha256.equalsIgnoreCase(manifestEntry(manifestCache.sha256, "firmware.bin")))
+        signature = manifestEntry(manifestCache.signatures, "firmware.bin");
+
+    OTA_LOG_INFO("[OTA] Sending firmware " + sha256 + " to the multicast group");
+    otaIsRunning = true;
+    setDownloadPhase(true);
+    bool success = multicastSender.send(esp_ota_get_running_partition(), ESP.getSketchSize(), sha256, signature);
+    setDownloadPhase(false);
+    otaIsRunning = false;
+
+    const OtaMulticastStats &stats = multicastSender.stats();
+    if (success)
+        OTA_LOG_INFO("[OTA] Multicast done after " + String(stats.rounds) + " rounds, " + String(stats.done) + " nodes installed it");
+    else
+        OTA_LOG_ERROR("[OTA] Multicast failed: " + String(multicastSender.errorString()));
+    return success;
+}
+
+/**
+ * @brief Write the multicast image while packets arrive
+ *
+ * Returns when the image is installed, the session failed, or the sender was
+ * silent for a minute. The received blocks are kept in NVS, the next
+ * announcement of the same session resumes them.
+ */
+void OTAWEBUPDATER::receiveMulticast() {
+    if (otaIsRunning)
+        return;
+    otaIsRunning = true;
+    setDownloadPhase(true);
+
+    uint64_t lastPacket = nowMillis();
+    while (nowMillis() - lastPacket < 60 * 1000) {
+        OtaMulticastState state = multicastReceiver.poll(1000, signingKey);
+        if (state == OTA_MULTICAST_IDLE) {
+            if (!multicastReceiver.isActive())
+                break;
+            continue;
+        }
+        lastPacket = nowMillis();
+
+        if (state == OTA_MULTICAST_RECEIVING && multicastReceiver.isActive() && downloadProgress.due(multicastReceiver.receivedBlocks(), multicastReceiver.totalBlocks()))
+            emitLifecycle(OTA_LIFECYCLE_DOWNLOADING, "multicast", (size_t)multicastReceiver.receivedBlocks() * OTAMULTICAST_BLOCK_SIZE, multicastReceiver.totalBlocks() * OTAMULTICAST_BLOCK_SIZE);
+        if (state == OTA_MULTICAST_COMPLETE) {
+            emitLifecycle(OTA_LIFECYCLE_COMMITTING, "multicast");
+            bootGuard.arm();
+            OTA_LOG_INFO("[OTA] Multicast firmware installed, restarting");
+            logBuffer.flush();
+            ESP.restart();
+        }
+        if (state == OTA_MULTICAST_FAILED) {
+            OTA_LOG_ERROR("[OTA] Multicast update failed: " + String(multicastReceiver.errorString()));
+            setDownloadPhase(false);
+            abortLifecycle(multicastReceiver.errorString());
+            return;
         }
-    </script>
-</body>
-</html>)html";
+    }
+    bool stalled = multicastReceiver.isActive();
+    if (stalled) {
+        OTA_LOG_ERROR("[OTA] Multicast sender went silent at " + String(multicastReceiver.receivedBlocks()) + "/" + String(multicastReceiver.totalBlocks()) + " blocks");
+        multicastReceiver.abort();
+    }
+    setDownloadPhase(false);
+    if (stalled)
+        abortLifecycle("multicast sender went silent");
+    else
+        otaIsRunning = false;
+}
 
-        request->send(200, "text/html", html);
+/**
+ * @brief Upload the running firmware to all push targets
+ * @return true if every target installed it
+ *
+ * Runs in the calling task, the API hands it over to the background task.
+ * The progress is shown by GET /api/ota/gateway/push.
+ */
+bool OTAWEBUPDATER::pushToTargets() {
+    String sha256 = installedSha256(U_FLASH);
+    String signature = "";
+    if (sha256.equalsIgnoreCase(manifestEntry(manifestCache.sha256, "firmware.bin")))
+        signature = manifestEntry(manifestCache.signatures, "firmware.bin");
+
+    OTA_LOG_INFO("[OTA] Pushing firmware " + sha256 + " to " + String(gatewayPush.targetCount()) + " devices");
+    otaIsRunning = true;
+    setDownloadPhase(true);
+    bool success = gatewayPush.push(esp_ota_get_running_partition(), ESP.getSketchSize(), sha256, signature, apiPrefix + "/upload");
+    setDownloadPhase(false);
+    otaIsRunning = false;
+
+    if (success)
+        OTA_LOG_INFO("[OTA] Push done, " + String(gatewayPush.countState(OTA_PUSH_DONE)) + " devices installed the firmware");
+    else
+        OTA_LOG_ERROR("[OTA] Push failed: " + String(gatewayPush.errorString()) + ", " + String(gatewayPush.countState(OTA_PUSH_FAILED)) + " of " + String(gatewayPush.targetCount()) + " devices failed");
+    return success;
+}
+
+/**
+ * @brief Build the fields of /api/ota/esp that do not change until the next boot
+ *
+ * The result is a JSON object that ends inside of "chip", so the sampled values
+ * can be appended without another JsonDocument per request. The boot partition
+ * only changes right before a restart, so it is cached as well.
+ */
+void OTAWEBUPDATER::buildEspStaticInfo() {
+    JsonDocument json;
+
+    JsonObject booting = json["booting"].to<JsonObject>();
+    booting["rebootReason"] = esp_reset_reason();
+    booting["partitionCount"] = esp_ota_get_app_partition_count();
+
+    auto partition = esp_ota_get_boot_partition();
+    JsonObject bootPartition = json["bootPartition"].to<JsonObject>();
+    bootPartition["address"] = partition->address;
+    bootPartition["size"] = partition->size;
+    bootPartition["label"] = partition->label;
+    bootPartition["encrypted"] = partition->encrypted;
+    switch (partition->type) {
+    case ESP_PARTITION_TYPE_APP:
+        bootPartition["type"] = "app";
+        break;
+    case ESP_PARTITION_TYPE_DATA:
+        bootPartition["type"] = "data";
+        break;
+    default:
+        bootPartition["type"] = "any";
+    }
+    bootPartition["subtype"] = partition->subtype;
+
+    partition = esp_ota_get_running_partition();
+    JsonObject runningPartition = json["runningPartition"].to<JsonObject>();
+    runningPartition["address"] = partition->address;
+    runningPartition["size"] = partition->size;
+    runningPartition["label"] = partition->label;
+    runningPartition["encrypted"] = partition->encrypted;
+    switch (partition->type) {
+    case ESP_PARTITION_TYPE_APP:
+        runningPartition["type"] = "app";
+        break;
+    case ESP_PARTITION_TYPE_DATA:
+        runningPartition["type"] = "data";
+        break;
+    default:
+        runningPartition["type"] = "any";
+    }
+    runningPartition["subtype"] = partition->subtype;
+
+    JsonObject build = json["build"].to<JsonObject>();
+    build["date"] = __DATE__;
+    build["time"] = __TIME__;
+
+    JsonObject flash = json["flash"].to<JsonObject>();
+    flash["flashChipSize"] = ESP.getFlashChipSize();
+    flash["flashChipRealSize"] = spi_flash_get_chip_size();
+    flash["flashChipSpeedMHz"] = ESP.getFlashChipSpeed() / 1000000;
+    flash["flashChipMode"] = ESP.getFlashChipMode();
+    flash["sdkVersion"] = ESP.getFlashChipSize();
+
+    JsonObject sketch = json["sketch"].to<JsonObject>();
+    sketch["size"] = ESP.getSketchSize();
+    sketch["maxSize"] = ESP.getFreeSketchSpace();
+    sketch["usagePercent"] = (float)ESP.getSketchSize() / (float)ESP.getFreeSketchSpace() * 100.f;
+    sketch["md5"] = ESP.getSketchMD5();
+
+    // must be the last object, it is completed by the sampled values
+    JsonObject chip = json["chip"].to<JsonObject>();
+    chip["revision"] = ESP.getChipRevision();
+    chip["model"] = ESP.getChipModel();
+    chip["cores"] = ESP.getChipCores();
+    chip["cpuFreqMHz"] = ESP.getCpuFreqMHz();
+    chip["sdkVersion"] = ESP.getSdkVersion();
+    chip["efuseMac"] = ESP.getEfuseMac();
+
+    espStaticInfo = "";
+    serializeJson(json, espStaticInfo);
+    espStaticInfo.remove(espStaticInfo.length() - 2); // reopen "chip"
+}
+
+/**
+ * @brief Refresh the heap, PSRAM and temperature values of /api/ota/esp
+ *
+ * Frequent scrapes share one sample per espSampleIntervalMillis.
+ */
+void OTAWEBUPDATER::sampleEspInfo() {
+    uint64_t now = nowMillis();
+    if (espSampleMillis && now - espSampleMillis < espSampleIntervalMillis)
+        return;
+    espSampleMillis = now;
+
+    espSample.heapSize = ESP.getHeapSize();
+    espSample.freeHeap = ESP.getFreeHeap();
+    espSample.minFreeHeap = ESP.getMinFreeHeap();
+    espSample.maxAllocHeap = ESP.getMaxAllocHeap();
+    espSample.psramSize = ESP.getPsramSize();
+    espSample.freePsram = ESP.getFreePsram();
+    espSample.minFreePsram = ESP.getMinFreePsram();
+    espSample.maxAllocPsram = ESP.getMaxAllocPsram();
+    temp_sensor_read_celsius(&espSample.temperature);
+}
+
+/**
+ * @brief Serve the web UI
+ *
+ * The page is stored gzip compressed in flash (see otaWebUi.h) and sent without
+ * copying it to the heap. Browsers revalidate it with the ETag and get a 304
+ * as long as the firmware was not changed.
+ */
+void OTAWEBUPDATER::attachUI() {
+    webServer->on((uiPrefix).c_str(), HTTP_GET, [&](AsyncWebServerRequest *request) {
+        if (request->hasHeader("If-None-Match") && request->header("If-None-Match") == OTAWEBUI_ETAG) {
+            AsyncWebServerResponse *response = request->beginResponse(304);
+            response->addHeader("ETag", OTAWEBUI_ETAG);
+            response->addHeader("Cache-Control", "no-cache");
+            request->send(response);
+            return;
+        }
+        AsyncWebServerResponse *response = request->beginResponse_P(200, "text/html", OTAWEBUI_HTML_GZ, OTAWEBUI_SIZE);
+        response->addHeader("Content-Encoding", "gzip");
+        response->addHeader("ETag", OTAWEBUI_ETAG);
+        response->addHeader("Cache-Control", "no-cache");
+        request->send(response);
     });
 }
\ No newline at end of file
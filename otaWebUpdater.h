@@ -16,19 +16,146 @@
 #define OTAWEBUPDATER_USE_NVS true
 #endif
 
+#include "otaBenchmark.h"
+#include "otaBootGuard.h"
+#include "otaBufferPool.h"
+#include "otaBundle.h"
+#include "otaDecompressor.h"
+#include "otaDeltaPatcher.h"
+#include "otaGateway.h"
+#include "otaHttpSession.h"
+#include "otaImageVerifier.h"
+#include "otaLog.h"
+#include "otaMetrics.h"
+#include "otaMulticast.h"
+#include "otaPartitionEraser.h"
+#include "otaPartitionWriter.h"
+#include "otaPeer.h"
+#include "otaPipeline.h"
+#include "otaUploadWriter.h"
+
 #include <Arduino.h>
+#include <ArduinoJson.h>
 #include <ESPAsyncWebServer.h>
+#include <atomic>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/timers.h>
 
 #if OTAWEBUPDATER_USE_NVS == true
 #include <Preferences.h>
 #endif
 
+// Reasons to wake up the background task
+#define OTA_EVENT_TIMER BIT0   // the next regular version check is due
+#define OTA_EVENT_NETWORK BIT1 // the network came up
+#define OTA_EVENT_CHECK BIT2    // a version check was requested
+#define OTA_EVENT_PREPARED BIT3  // the app partition was erased for the pending update
+#define OTA_EVENT_BENCHMARK BIT4 // a throughput self-test was requested
+#define OTA_EVENT_MULTICAST BIT5 // a multicast packet arrived or a transmission was requested
+#define OTA_EVENT_PUSH BIT6      // a push to downstream devices was requested
+#define OTA_EVENT_ALL (OTA_EVENT_TIMER | OTA_EVENT_NETWORK | OTA_EVENT_CHECK | OTA_EVENT_PREPARED | OTA_EVENT_BENCHMARK | OTA_EVENT_MULTICAST | OTA_EVENT_PUSH)
+
+// Largest body of a POST to /gateway/push, enough for OTAGATEWAY_MAX_TARGETS addresses
+#ifndef OTAWEBUPDATER_PUSH_BODY_MAX
+#define OTAWEBUPDATER_PUSH_BODY_MAX 4096
+#endif
+
 struct OtaWebVersion {
     String date;
     String version;
 };
 
+// Layout of current-version.bin, created by tools/makeManifest.py:
+//   "OTAM", uint8 version, uint8 reserved[3], uint32 CRC32 of current-version.json,
+//   uint32 reserved, char date[24], char revision[24], little endian and NUL padded
+#define OTAMANIFEST_MAGIC "OTAM"
+#define OTAMANIFEST_VERSION 1
+#define OTAMANIFEST_SIZE 64
+
+// Content of current-version.bin
+struct OtaBinaryManifest : OtaWebVersion {
+    uint32_t crc = 0; // CRC32 of the current-version.json it summarizes, 0 if there is none
+};
+
+// Values and cache validators of the last current-version.json
+struct OtaManifestCache : OtaWebVersion {
+    String url;
+    String etag;
+    String lastModified;
+    String deltaFrom; // sketch MD5 the delta patch applies to
+    String deltaFile;
+    String bundleFile;            // all artifacts in one transactional download
+    String sha256;                // {"file": "hex"} of the images
+    String signatures;            // {"file": "base64 DER"} signatures of the image hashes
+    uint32_t firmwareSize = 0;    // size of firmware.bin, used to erase ahead of the update
+    uint8_t rolloutPercent = 100; // share of the fleet that installs the release
+    String rolloutSalt;           // selects the cohort, defaults to the revision
+    uint32_t notBefore = 0;       // unix time the rollout starts
+    uint32_t binaryCrc = 0;       // CRC32 announced by current-version.bin, 0 if not known
+};
+
+// Checkpoint of an interrupted download
+struct OtaResumePoint {
+    String url;
+    size_t offset = 0;
+    int total = -1;
+    String validator;       // ETag or Last-Modified of the file
+    bool persistent = true; // store checkpoints to NVS
+};
+
+// Dynamic system values reported by /api/ota/esp
+struct OtaEspSample {
+    uint32_t heapSize = 0;
+    uint32_t freeHeap = 0;
+    uint32_t minFreeHeap = 0;
+    uint32_t maxAllocHeap = 0;
+    uint32_t psramSize = 0;
+    uint32_t freePsram = 0;
+    uint32_t minFreePsram = 0;
+    uint32_t maxAllocPsram = 0;
+    float temperature = 0;
+};
+
+// Stages of an update reported to the application, see onLifecycle()
+enum OtaLifecycleEvent {
+    OTA_LIFECYCLE_PENDING,     // a new release was found, the update starts soon
+    OTA_LIFECYCLE_PREPARING,   // the app partition is erased before the download
+    OTA_LIFECYCLE_DOWNLOADING, // a file is downloaded or uploaded, reported with progress
+    OTA_LIFECYCLE_VERIFYING,   // the image is checked against its hash and signature
+    OTA_LIFECYCLE_COMMITTING,  // the new image is activated, a restart follows
+    OTA_LIFECYCLE_ABORTED,     // the update failed or was not needed, regular operation can resume
+};
+
+// Details of an OtaLifecycleEvent, only valid during the callback
+struct OtaLifecycleInfo {
+    OtaLifecycleEvent event;
+    const char *file;   // url or name of the file, "" if none
+    size_t bytes;       // bytes transferred so far
+    int total;          // size of the file, -1 if unknown
+    const char *reason; // why the update was aborted, "" otherwise
+};
+
+// Where and how the background task runs, see setTaskConfig()
+struct OtaTaskConfig {
+    BaseType_t core = 0;              // core of the task, tskNO_AFFINITY lets the scheduler pick
+    UBaseType_t priority = 0;         // priority while waiting and checking
+    uint32_t stackSize = 8192;        // stack size passed to xTaskCreatePinnedToCore(), https and signatures need 8192
+    UBaseType_t downloadPriority = 0; // priority while installing, below priority is ignored
+    BaseType_t writerCore = -1;       // core of the flash writer, -1 for the other core than the task
+};
+
+// Outcome of a single download request
+enum OtaDownloadResult {
+    OTA_DOWNLOAD_COMPLETE,
+    OTA_DOWNLOAD_INTERRUPTED, // connection lost, can be resumed
+    OTA_DOWNLOAD_RESTART,     // remote file changed, start over
+    OTA_DOWNLOAD_FAILED,      // unrecoverable error
+};
+
 void otaTask(void *param);
+void otaTimerCallback(TimerHandle_t timer);
 
 class OTAWEBUPDATER {
   protected:
@@ -45,15 +172,12 @@ class OTAWEBUPDATER {
 #endif
 
   public:
-    // Is a version check currently running
-    bool otaIsRunning = false;
+    // Is an update, benchmark or multicast running, see onLifecycle() to get notified
+    std::atomic<bool> otaIsRunning{false};
 
     // Is a new version available
     bool newReleaseAvailable = false;
 
-    // Interval to run the loop()
-    TickType_t xDelay = 1000 / portTICK_PERIOD_MS;
-
     // Prefix for all API endpoints
     String apiPrefix = "/api/ota";
     String uiPrefix = "/ota"; // Prefix for all UI endpionts
@@ -70,6 +194,12 @@ class OTAWEBUPDATER {
     // Attach a UI to manage the firmware
     void attachUI();
 
+    // Set core, priority and stack of the background task, used by the next startBackgroundTask()
+    void setTaskConfig(const OtaTaskConfig &config) { taskConfig = config; }
+
+    // The current task configuration
+    const OtaTaskConfig &getTaskConfig() { return taskConfig; }
+
     // Starts a new otaTask
     bool startBackgroundTask();
 
@@ -79,14 +209,75 @@ class OTAWEBUPDATER {
     // The loop function called from the background Task
     void loop();
 
-    // Check if there is a new version available
+    // Wake up the background task with OTA_EVENT_* bits
+    void notify(EventBits_t bits);
+
+    // Block the background task until an OTA_EVENT_* arrives
+    EventBits_t waitForEvent();
+
+    // Stage changes of an update, called from the task running it
+    typedef std::function<void(const OtaLifecycleInfo &info)> LifecycleCallback;
+
+    // Get notified before an update starts, on its progress and when it ended
+    void onLifecycle(LifecycleCallback callback) { lifecycleCallback = callback; }
+
+    // Result of a version check, called from the background task
+    typedef std::function<void(bool success, bool newRelease, const String &version)> VersionCheckCallback;
+
+    // Run a version check in the background task as soon as possible, the result goes to onVersionCheck()
+    void requestVersionCheck() { notify(OTA_EVENT_CHECK); }
+
+    // Call back after each version check of the background task
+    void onVersionCheck(VersionCheckCallback callback) { versionCheckCallback = callback; }
+
+    // Check if there is a new version available, blocks until the check timeouts at most
     bool checkAvailableVersion();
 
     // Execute update
     void executeUpdate();
 
     // Install a new firmware version
-    bool updateFile(String baseUrl, String filename);
+    bool updateFile(String baseUrl, String filename, bool delta = false);
+
+    // Install the firmware, using the delta patch if available
+    bool updateFirmware();
+
+    // Install all artifacts of an update bundle, activating the app only if all verified
+    bool updateBundle(String baseUrl, String filename);
+
+    // Measure download and flash throughput without installing anything
+    bool runBenchmark(OtaBenchmarkMode mode, String filename = "firmware.bin", size_t size = 1024 * 1024);
+
+    // Result of the last or the running benchmark
+    const OtaBenchmarkResult &benchmarkResult() { return benchmark; }
+
+    // Send the running firmware to all nodes with multicast updates, see OtaMulticastSender
+    bool sendMulticast();
+
+    // Statistics of the last multicast transmission
+    const OtaMulticastStats &multicastStats() { return multicastSender.stats(); }
+
+    // Add a downstream device ("host" or "host:port") for pushToTargets(), false if the list is full
+    bool addPushTarget(const String &address) { return gatewayPush.addTarget(address); }
+    void clearPushTargets() { gatewayPush.clearTargets(); }
+
+    // Upload the running firmware to the /api/ota/upload of all push targets, see OtaGatewayPush
+    bool pushToTargets();
+
+    // Limit the uploads of pushToTargets() running at the same time and the heap they may use
+    void setPushConcurrency(uint8_t connections, size_t heapReserve = 48 * 1024) {
+        gatewayPush.setConcurrency(connections);
+        gatewayPush.setHeapReserve(heapReserve);
+    }
+
+    // Enable or disable delta (bsdiff) firmware updates
+    void setDeltaUpdates(bool enable) { deltaUpdates = enable; }
+
+    // Poll the 64 byte current-version.bin and only load current-version.json if it changed
+    void setBinaryManifest(bool enable) { binaryManifest = enable; }
+
+    // Require images signed with this ECDSA (or RSA) public key in PEM format, NULL disables it
+    void setSigningKey(const char *publicKeyPem) { signingKey = publicKeyPem; }
 
     // Set a new baseUrl
     void setBaseUrl(String newUrl);
@@ -97,9 +288,69 @@ class OTAWEBUPDATER {
     // Set a different check interval
     void setVersionCheckInterval(uint32_t minutes);
 
+    // Set the maximum per-device delay added to version checks
+    void setCheckJitter(uint32_t seconds);
+
+    // Set the deadlines of a version check to resolve, connect and handshake, and for each read, the whole check gets their sum
+    void setCheckTimeouts(uint16_t connectMs, uint16_t readMs) {
+        checkConnectTimeout = connectMs;
+        checkReadTimeout = readMs;
+    }
+
+    // Set the first retry delay after a failed version check, doubled on each failure
+    void setRetryBackoff(uint32_t seconds) { retryBackoffMillis = (uint64_t)seconds * 1000; }
+
     // Set OTA password
     void setOtaPassword(String newPass);
 
+    // Set the number and size of the download pipeline buffers
+    void setDownloadPipeline(size_t slots, size_t slotSize) {
+        pipelineSlots = slots;
+        pipelineSlotSize = slotSize;
+    }
+
+    // Set where the download pipeline buffers are allocated
+    void setBufferStrategy(OtaBufferStrategy strategy) { bufferStrategy = strategy; }
+
+    // Erase the target partition this many bytes ahead, e.g. OtaPartitionWriter::BLOCK_SIZE
+    void setFlashEraseAhead(size_t bytes) { flashEraseAhead = bytes; }
+
+    // Erase the app partition in the background before a found release is downloaded
+    void setPrepareUpdates(bool enable) { prepareUpdates = enable; }
+
+    // Serve the running firmware to other devices on the LAN and download from them first,
+    // port is the one of the attached webserver. Requires MDNS.begin() and a manifest with sha256.
+    void setPeerUpdates(bool enable, uint16_t port = 80);
+
+    // Install firmware images multicast by a gateway on the LAN
+    void setMulticastUpdates(bool enable);
+
+    // Limit the data rate of sendMulticast()
+    void setMulticastRate(uint32_t bytesPerSecond) { multicastSender.setRate(bytesPerSecond); }
+
+    // Health gate of a new image, returns true once the application works
+    typedef std::function<bool()> HealthCheck;
+
+    // Revert a new image unless the network is up and check passes within windowSeconds after boot,
+    // or if it restarts more than maxBoots times. Call before startBackgroundTask(), 0 confirms at once.
+    void setHealthCheck(uint32_t windowSeconds, HealthCheck check = NULL, uint8_t maxBoots = 3) {
+        healthWindowMillis = (uint64_t)windowSeconds * 1000;
+        healthCheck = check;
+        healthMaxBoots = maxBoots;
+    }
+
+    // Health of the running image, updates wait while it is on trial
+    OtaBootState bootState() { return bootGuard.state(); }
+
+    // Set the CA certificate (PEM) to verify a https baseUrl, required for https
+    void setCACert(const char *caCert) { httpSession.setCACert(caCert); }
+
+    // Allow https without a CA certificate, the server is then not authenticated
+    void setInsecure(bool allow);
+
+    // Set how often an interrupted download is resumed before giving up
+    void setDownloadRetries(uint8_t retries) { downloadRetries = retries; }
+
     // Set Firmware information
     void setFirmware(String fwDate, String fwRelease) {
         currentFwDate = fwDate;
@@ -114,15 +365,72 @@ class OTAWEBUPDATER {
     virtual void logMessage(String msg, bool showtime = true);
     // Print a part of log message, can be overwritten
     virtual void logMessagePart(String msg, bool showtime = false);
+    // Pass a message to the logger callbacks
+    void writeLogLine(const char *msg, bool showtime);
+
+    // Run a single (range) request of a download
+    OtaDownloadResult downloadRange(OtaResumePoint &resume, OtaPipeline &pipeline, OtaPartitionWriter &writer, OtaDecompressor &decoder);
+
+    // Request and parse the manifest
+    bool fetchManifest();
+    bool fetchBinaryManifest(const String &url, OtaBinaryManifest &summary);
+
+    // Send a document as MessagePack if the client accepts it, as JSON otherwise
+    void sendDocument(AsyncWebServerRequest *request, const JsonDocument &doc, int code = 200);
+
+    // Compare the last manifest against the running firmware
+    bool evaluateManifest();
+    bool finishManifestCheck(bool result);
+
+    // Staged rollout of a release
+    bool rolloutAllowed();
+    uint8_t rolloutBucket(const String &salt);
+    uint32_t currentEpoch();
+    static uint32_t parseHttpDate(const String &date);
+
+    // Cached and sampled parts of /api/ota/esp
+    void buildEspStaticInfo();
+    void sampleEspInfo();
+
+    // Erase the app partition for a pending update, true once the download can start
+    bool updatePrepared();
+
+    // Download firmware.bin from a device on the LAN that runs the new release
+    bool updateFromPeer();
+
+    // Announce the running firmware to other devices with peer updates
+    void advertisePeer();
+
+    // Receive a multicast image until it is complete or the sender goes silent
+    void receiveMulticast();
+
+    // The two kinds of benchmark runs
+    bool benchmarkDownload(OtaBenchmarkMode mode, String filename, OtaLatencySamples &reads, OtaLatencySamples &writes);
+    bool benchmarkFlash(size_t size, OtaLatencySamples &erases, OtaLatencySamples &writes);
+
+    // Value for a file from a cached manifest object
+    static String manifestEntry(const String &json, const String &file);
+
+    // SHA-256 of the installed app or filesystem, cached in NVS
+    String installedSha256(int filetype);
+    void setInstalledSha256(int filetype, const String &sha256);
+    bool artifactInstalled(const String &filename);
+
+    // Persist the last manifest for conditional requests
+    void loadManifestCache();
+    void saveManifestCache();
+
+    // Checkpoints of interrupted downloads
+    OtaResumePoint loadResumePoint(String url);
+    void saveResumePoint(const OtaResumePoint &resume);
+    void clearResumePoint();
 
     // URL to load the data from
     // Files that needs to be located at this URL:
     //  - current-version.json       json with version information
-    //  - boot_app0.bin              ESP32 boot code
-    //  - bootloader_dio_80m.bin     ESP32 boot code
-    //  - partitions.bin             ESP32 flash partition layout
     //  - firmware.bin               This firmware file
     //  - littlefs.bin               The WebUI spiffs/littlefs
+    //  - or instead of the two: a bundle named in current-version.json (tools/makeBundle.py)
     String baseUrl = "";
 
     // The Webserver to register routes on
@@ -131,9 +439,103 @@ class OTAWEBUPDATER {
     // Task handle for the background task
     TaskHandle_t otaCheckTask = NULL;
 
+    // Core, priorities and stack of the background task
+    OtaTaskConfig taskConfig;
+
+    // Switch the background task between its idle and download priority
+    void setDownloadPhase(bool active);
+
+    // Wake up events for the background task
+    EventGroupHandle_t otaEvents = NULL;
+
+    // One-shot timer for the next regular version check
+    TimerHandle_t checkTimer = NULL;
+
+    // A version check was requested from the API
+    volatile bool checkRequested = false;
+
+    // Arm the timer for the next regular version check
+    void scheduleVersionCheck();
+
+    // Plan the next check based on the result and the server hints
+    void planNextVersionCheck(bool success);
+    void parseServerHints(HTTPClient &http);
+
+    // Scheduling helpers
+    static uint64_t nowMillis();
+    uint64_t deviceJitter(uint64_t delay);
+
     // Time of last version check
     uint64_t lastVersionCheckMillis = 0;
 
+    // Time of the next regular version check
+    uint64_t nextVersionCheckMillis = 0;
+
+    // Window to spread the checks of a fleet
+    uint64_t checkJitterMillis = 5 * 60 * 1000; // 5 minutes
+
+    // First retry delay after a failed check
+    uint64_t retryBackoffMillis = 60 * 1000; // 1 minute
+
+    // Deadlines of the version check, shorter than the ones of the downloads
+    uint16_t checkConnectTimeout = 3000;
+    uint16_t checkReadTimeout = 5000;
+
+    // Receives the result of each version check
+    VersionCheckCallback versionCheckCallback = NULL;
+
+    // Receives the stages of an update
+    LifecycleCallback lifecycleCallback = NULL;
+    void emitLifecycle(OtaLifecycleEvent event, const String &file = "", size_t bytes = 0, int total = -1);
+
+    // Clear otaIsRunning after a failed or skipped update and report it
+    void abortLifecycle(const char *reason);
+
+    // Confirm or revert a new image, see setHealthCheck()
+    void checkBootHealth();
+    OtaBootGuard bootGuard;
+    uint64_t healthWindowMillis = 0;
+    HealthCheck healthCheck = NULL;
+    uint8_t healthMaxBoots = 3;
+
+    // Failed version checks in a row
+    uint8_t checkFailures = 0;
+
+    // Retry-After and Cache-Control: max-age of the last manifest response
+    uint64_t serverRetryAfterMillis = 0;
+    uint64_t serverMaxAgeMillis = 0;
+
+    // Hash of the efuse MAC, used to derive per-device jitter
+    uint32_t deviceHash = 0;
+
+    // Time until a staged release becomes available to this device
+    uint64_t rolloutWaitMillis = 0;
+
+    // Date header of the last manifest response and when it was received
+    uint32_t serverDate = 0;
+    uint64_t serverDateMillis = 0;
+
+    // Log messages waiting for the logger callbacks
+    OtaLogBuffer logBuffer;
+
+    // Throttles the status messages of a download
+    OtaProgress downloadProgress;
+    OtaProgress uploadProgress;
+
+    // Counters and histograms for /api/ota/metrics and /api/ota/esp
+    OtaMetrics metrics;
+
+    // Start of the running upload, for the throughput
+    int64_t uploadStartMicros = 0;
+
+    // Static fields of /api/ota/esp, serialized once
+    String espStaticInfo = "";
+
+    // Last sample of the dynamic fields of /api/ota/esp
+    OtaEspSample espSample;
+    uint64_t espSampleMillis = 0;
+    uint64_t espSampleIntervalMillis = 1000;
+
     // Interval to check for new versions (should be hours!!)s
     uint64_t intervalVersionCheckMillis = 24 * 60 * 60 * 1000; // 24 hours
 
@@ -151,6 +553,87 @@ class OTAWEBUPDATER {
 
     // Password to execute OTA upload
     String otaPassword = "";
+
+    // Number of buffers in the download pipeline (network -> flash)
+    size_t pipelineSlots = 4;
+
+    // Size of each download pipeline buffer
+    size_t pipelineSlotSize = 32 * 1024;
+
+    // Memory used for the download pipeline buffers
+    OtaBufferStrategy bufferStrategy = OTA_BUFFER_AUTO;
+
+    // Bytes of the target partition erased at once, a sector by default
+    size_t flashEraseAhead = OtaPartitionWriter::SECTOR_SIZE;
+
+    // Erase the app partition before the download of a new release
+    bool prepareUpdates = false;
+    OtaPartitionEraser prepareEraser;
+
+    // Firmware exchange with other devices on the LAN
+    bool peerUpdates = false;
+    uint16_t peerPort = 80;
+    OtaPeerDiscovery peerDiscovery;
+    String peerSha256 = "";   // of the served image, empty until it is announced
+    size_t peerImageSize = 0; // bytes served, the size of firmware.bin
+    uint8_t peerTransfers = 0;
+
+    // Image distribution to all nodes of the LAN at once
+    bool multicastUpdates = false;
+    volatile bool multicastRequested = false;
+    OtaMulticastSender multicastSender;
+    OtaMulticastReceiver multicastReceiver;
+
+    // Gateway uploads to downstream devices
+    volatile bool pushRequested = false;
+    OtaGatewayPush gatewayPush;
+
+    // Throughput self-test requested from the API and its last result
+    volatile bool benchmarkRequested = false;
+    OtaBenchmarkMode benchmarkMode = OTA_BENCHMARK_DISCARD;
+    String benchmarkFile = "firmware.bin";
+    size_t benchmarkSize = 1024 * 1024;
+    OtaBenchmarkResult benchmark;
+
+    // Network wait per chunk of a running benchmark, see downloadRange()
+    OtaLatencySamples *readSamples = NULL;
+    int64_t benchmarkStartMicros = 0; // before the request, for the time to the first byte
+
+    // Number of resume attempts after a lost connection
+    uint8_t downloadRetries = 5;
+
+    // Bytes flashed between two NVS checkpoints of a download
+    size_t resumeCheckpointBytes = 64 * 1024;
+
+    // Use delta patches advertised by the manifest
+    bool deltaUpdates = true;
+
+    // Poll current-version.bin before current-version.json
+    bool binaryManifest = false;
+
+    // Patch against the running firmware offered by the manifest
+    String deltaFile = "";
+
+    // Update bundle offered by the manifest, replaces littlefs.bin and firmware.bin
+    String bundleFile = "";
+
+    // The last manifest received
+    OtaManifestCache manifestCache;
+
+    // Keep-alive connection for the manifest and all downloads of an update
+    OtaHttpSession httpSession;
+
+    // Decoder of the running web upload
+    OtaDecompressor uploadDecoder;
+
+    // Hands the web upload over to a flash writer task
+    OtaUploadWriter uploadWriter;
+
+    // Hash and signature check of the running web upload
+    OtaImageVerifier uploadVerifier;
+
+    // Public key (PEM) images must be signed with, NULL to accept unsigned images
+    const char *signingKey = NULL;
 };
 
 #endif // OTAWEBUPDATER_h
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""
+Compress ui/index.html into otaWebUi.h
+
+The web UI is served straight out of flash as a gzip response. Run this script
+after changing ui/index.html and commit the generated header:
+
+    python3 tools/embedUi.py
+
+The block between <!-- OTAWEBUPDATER_USE_NVS --> and <!-- /OTAWEBUPDATER_USE_NVS -->
+is only part of the NVS variant of the page.
+"""
+
+import gzip
+import hashlib
+import os
+import re
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCE = os.path.join(ROOT, "ui", "index.html")
+TARGET = os.path.join(ROOT, "otaWebUi.h")
+NVS_BLOCK = re.compile(r"<!-- OTAWEBUPDATER_USE_NVS -->\n(.*?)<!-- /OTAWEBUPDATER_USE_NVS -->\n", re.S)
+
+
+def compress(html):
+    # mtime 0 keeps the output and the ETag stable between runs
+    data = gzip.compress(html.encode("utf-8"), compresslevel=9, mtime=0)
+    return data, hashlib.sha256(data).hexdigest()[:16]
+
+
+def array(name, data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("    " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    return "const uint8_t %s[] PROGMEM = {\n%s\n};\n" % (name, "\n".join(lines))
+
+
+def main():
+    with open(SOURCE, encoding="utf-8") as f:
+        html = f.read()
+
+    variants = [
+        ("true", NVS_BLOCK.sub(r"\1", html)),
+        ("false", NVS_BLOCK.sub("", html)),
+    ]
+
+    out = [
+        "/**",
+        " * @file otaWebUi.h",
+        " * @brief gzip compressed web UI, generated by tools/embedUi.py from ui/index.html",
+        " *",
+        " * Do not edit, run \"python3 tools/embedUi.py\" instead.",
+        " *",
+        " * License: CC BY-NC-SA 4.0",
+        " */",
+        "",
+        "#ifndef OTAWEBUI_h",
+        "#define OTAWEBUI_h",
+        "",
+        "#include <Arduino.h>",
+        "",
+    ]
+    for i, (nvs, page) in enumerate(variants):
+        data, etag = compress(page)
+        out.append("#if OTAWEBUPDATER_USE_NVS == true" if i == 0 else "#else")
+        out.append('#define OTAWEBUI_ETAG "\\"%s\\""' % etag)
+        out.append("#define OTAWEBUI_SIZE %d" % len(data))
+        out.append(array("OTAWEBUI_HTML_GZ", data))
+    out.append("#endif")
+    out.append("")
+    out.append("#endif // OTAWEBUI_h")
+    out.append("")
+
+    with open(TARGET, "w", encoding="utf-8") as f:
+        f.write("\n".join(out))
+    for nvs, page in variants:
+        data, etag = compress(page)
+        print("NVS %-5s: %6d -> %5d bytes, ETag %s" % (nvs, len(page.encode("utf-8")), len(data), etag))
+
+
+if __name__ == "__main__":
+    main()
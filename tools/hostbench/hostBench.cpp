@@ -0,0 +1,317 @@
+/**
+ * Host benchmark of the OTA download pipeline
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#include "hostShim.h"
+
+#include "otaPartitionEraser.h"
+#include "otaPartitionWriter.h"
+#include "otaPipeline.h"
+
+#include <esp_image_format.h>
+#include <esp_ota_ops.h>
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+// The simulated TCP connection
+struct NetModel {
+    double kbps = 8000;    // link bandwidth in kbit/s
+    double latencyMs = 50; // round trip time
+    double loss = 0;       // probability a segment is lost
+    double rtoMs = 200;    // retransmission delay of a lost segment
+    size_t window = 5744;  // receive window of lwIP (TCP_WND)
+    size_t segment = 1460; // MSS
+};
+
+// One chunk of a captured download: the gap before it arrived and its size
+struct TraceChunk {
+    double gapMicros;
+    size_t bytes;
+};
+
+/**
+ * Replays a response body like WiFiClient, available() only reports what has
+ * arrived by now. Without a trace, segments arrive at the link bandwidth and the
+ * sender waits a round trip whenever the receive window is full.
+ */
+class SimStream {
+  public:
+    SimStream(const std::vector<uint8_t> &body, const NetModel &model, const std::vector<TraceChunk> &trace, uint32_t seed)
+        : body(body), net(model), trace(trace), random(seed) {}
+
+    size_t available() {
+        pump();
+        return buffered;
+    }
+
+    size_t readBytes(uint8_t *buf, size_t len) {
+        pump();
+        size_t take = len < buffered ? len : buffered;
+        memcpy(buf, body.data() + readPos, take);
+        readPos += take;
+        buffered -= take;
+        if (blocked && buffered + net.segment <= net.window) {
+            // the window update needs a round trip until new data arrives
+            double resume = micros() + net.latencyMs * 1000;
+            if (resume > nextArrival)
+                nextArrival = resume;
+            blocked = false;
+        }
+        return take;
+    }
+
+    bool done() { return readPos == body.size(); }
+
+  private:
+    void pump() {
+        double now = micros();
+        if (!started) {
+            started = true;
+            nextArrival = now + net.latencyMs * 1000; // request and first byte
+        }
+        while (sent < body.size() && nextArrival <= now) {
+            size_t seg = trace.empty() ? net.segment : trace[traceIdx].bytes;
+            if (seg > body.size() - sent)
+                seg = body.size() - sent;
+            if (trace.empty() && buffered + seg > net.window) {
+                blocked = true;
+                break;
+            }
+            buffered += seg;
+            sent += seg;
+            if (trace.empty()) {
+                nextArrival += seg * 8 / net.kbps * 1000;
+                if (net.loss > 0 && std::uniform_real_distribution<double>(0, 1)(random) < net.loss)
+                    nextArrival += net.rtoMs * 1000;
+            } else {
+                traceIdx = (traceIdx + 1) % trace.size();
+                nextArrival += trace[traceIdx].gapMicros;
+            }
+        }
+    }
+
+    const std::vector<uint8_t> &body;
+    NetModel net;
+    const std::vector<TraceChunk> &trace;
+    size_t traceIdx = 0;
+    std::mt19937 random;
+
+    bool started = false;
+    bool blocked = false;
+    double nextArrival = 0;
+    size_t sent = 0;
+    size_t buffered = 0;
+    size_t readPos = 0;
+};
+
+static void usage() {
+    puts("Usage: otaHostBench [options]\n"
+         "\n"
+         "Payload\n"
+         "  --image FILE          response body to replay (default: random app image)\n"
+         "  --size BYTES          size of the random image (1200000)\n"
+         "  --trace FILE          captured arrivals, one \"<gap_us> <bytes>\" per line\n"
+         "  --filesystem          write to the spiffs partition instead of the app\n"
+         "Network\n"
+         "  --bandwidth KBPS      link bandwidth in kbit/s (8000)\n"
+         "  --latency MS          round trip time (50)\n"
+         "  --loss RATE           probability of a lost segment (0)\n"
+         "  --rto MS              delay of a lost segment (200)\n"
+         "  --window BYTES        TCP receive window (5744)\n"
+         "Flash\n"
+         "  --erase-ms MS         4 KB sector erase (30)\n"
+         "  --block-erase-ms MS   64 KB block erase (150)\n"
+         "  --page-ms MS          256 byte page program (0.4)\n"
+         "  --stall-rate RATE     probability of a stall per write call (0)\n"
+         "  --stall-ms MS         duration of a stall (0)\n"
+         "Updater\n"
+         "  --slots N             pipeline slots (4)\n"
+         "  --slot-size BYTES     pipeline slot size (32768)\n"
+         "  --erase-ahead BYTES   OtaPartitionWriter::setEraseAhead() (4096)\n"
+         "  --prepare             erase in the background first, like setPrepareUpdates()\n"
+         "  --heap BYTES          free heap of the simulated device (184320)\n"
+         "Run\n"
+         "  --time-scale X        run the simulated clock X times faster (1)\n"
+         "  --seed N              seed of the random image and losses (1)\n"
+         "  --csv                 print a single CSV line");
+}
+
+static bool loadTrace(const char *path, std::vector<TraceChunk> &trace) {
+    std::ifstream in(path);
+    TraceChunk chunk;
+    while (in >> chunk.gapMicros >> chunk.bytes)
+        if (chunk.bytes)
+            trace.push_back(chunk);
+    return !trace.empty();
+}
+
+int main(int argc, char **argv) {
+    NetModel net;
+    std::vector<TraceChunk> trace;
+    std::vector<uint8_t> body;
+    std::string image;
+    size_t imageSize = 1200000;
+    size_t slots = 4;
+    size_t slotSize = 32 * 1024;
+    size_t eraseAhead = OtaPartitionWriter::SECTOR_SIZE;
+    bool filesystem = false;
+    bool prepare = false;
+    bool csv = false;
+    uint32_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        auto value = [&]() { return std::string(argv[++i]); };
+        if (arg == "--image" && hasValue) image = value();
+        else if (arg == "--size" && hasValue) imageSize = std::stoul(value());
+        else if (arg == "--trace" && hasValue) {
+            std::string path = value();
+            if (!loadTrace(path.c_str(), trace)) {
+                fprintf(stderr, "Unable to read the trace %s\n", path.c_str());
+                return 2;
+            }
+        }
+        else if (arg == "--filesystem") filesystem = true;
+        else if (arg == "--bandwidth" && hasValue) net.kbps = std::stod(value());
+        else if (arg == "--latency" && hasValue) net.latencyMs = std::stod(value());
+        else if (arg == "--loss" && hasValue) net.loss = std::stod(value());
+        else if (arg == "--rto" && hasValue) net.rtoMs = std::stod(value());
+        else if (arg == "--window" && hasValue) net.window = std::stoul(value());
+        else if (arg == "--erase-ms" && hasValue) hostFlashModel.eraseSectorMs = std::stod(value());
+        else if (arg == "--block-erase-ms" && hasValue) hostFlashModel.eraseBlockMs = std::stod(value());
+        else if (arg == "--page-ms" && hasValue) hostFlashModel.pageProgramMs = std::stod(value());
+        else if (arg == "--stall-rate" && hasValue) hostFlashModel.stallRate = std::stod(value());
+        else if (arg == "--stall-ms" && hasValue) hostFlashModel.stallMs = std::stod(value());
+        else if (arg == "--slots" && hasValue) slots = std::stoul(value());
+        else if (arg == "--slot-size" && hasValue) slotSize = std::stoul(value());
+        else if (arg == "--erase-ahead" && hasValue) eraseAhead = std::stoul(value());
+        else if (arg == "--prepare") prepare = true;
+        else if (arg == "--heap" && hasValue) hostHeapSize = std::stoul(value());
+        else if (arg == "--time-scale" && hasValue) hostTimeScale = std::stod(value());
+        else if (arg == "--seed" && hasValue) seed = std::stoul(value());
+        else if (arg == "--csv") csv = true;
+        else {
+            usage();
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+    if (net.window < net.segment)
+        net.window = net.segment;
+
+    if (!image.empty()) {
+        std::ifstream in(image, std::ios::binary);
+        body.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        if (body.empty()) {
+            fprintf(stderr, "Unable to read the image %s\n", image.c_str());
+            return 2;
+        }
+    } else {
+        std::mt19937 random(seed);
+        body.resize(imageSize);
+        for (uint8_t &b : body)
+            b = random();
+        if (!body.empty() && !filesystem)
+            body[0] = ESP_IMAGE_HEADER_MAGIC;
+    }
+
+    int command = filesystem ? U_SPIFFS : U_FLASH;
+    const esp_partition_t *target = filesystem ? esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, NULL) : esp_ota_get_next_update_partition(NULL);
+    if (body.size() > target->size) {
+        fprintf(stderr, "The image does not fit into %s\n", target->label);
+        return 2;
+    }
+    hostFlashInit();
+    hostHeapBaseline();
+
+    // the optional prepare phase, before the update is running
+    unsigned long prepareMicros = 0;
+    OtaPartitionEraser eraser;
+    if (prepare && !filesystem) {
+        unsigned long start = micros();
+        eraser.begin(target, body.size());
+        while (!eraser.isFinished())
+            delay(10);
+        prepareMicros = micros() - start;
+    }
+
+    // the same stages as OTAWEBUPDATER::updateFile() and downloadRange()
+    unsigned long startMicros = micros();
+    OtaPartitionWriter writer;
+    writer.setEraseAhead(eraseAhead);
+    if (prepare)
+        writer.setErased(eraser.take(target));
+    if (!writer.begin(command, 0)) {
+        fprintf(stderr, "Unable to open the partition - %s\n", writer.errorString());
+        return 1;
+    }
+
+    std::atomic<uint32_t> sinkCalls{0};
+    OtaPipeline pipeline;
+    auto flashWriter = [&writer, &sinkCalls](uint8_t *data, size_t len) {
+        sinkCalls++;
+        return writer.write(data, len);
+    };
+    if (!pipeline.begin(flashWriter, slots, slotSize)) {
+        fprintf(stderr, "Unable to start the pipeline\n");
+        return 1;
+    }
+
+    SimStream stream(body, net, trace, seed);
+    uint32_t reads = 0;
+    while (!stream.done()) {
+        size_t size = stream.available();
+        if (!size) {
+            delay(1);
+            continue;
+        }
+        uint8_t *slot = pipeline.acquire();
+        if (!slot)
+            break; // flash writer failed
+        size_t want = size > pipeline.slotSize() ? pipeline.slotSize() : size;
+        size_t len = stream.readBytes(slot, want);
+        reads++;
+        if (!pipeline.commit(slot, len))
+            break;
+    }
+    unsigned long receivedMicros = micros();
+
+    bool written = pipeline.finish();
+    bool committed = written && writer.end(!filesystem);
+    unsigned long doneMicros = micros();
+    size_t heapPeak = hostHeapPeak();
+
+    std::vector<uint8_t> flashed(body.size());
+    esp_partition_read(target, 0, flashed.data(), flashed.size());
+    bool contentOk = committed && flashed == body && !hostFlashStats.dirtyWrites;
+
+    double seconds = (doneMicros - startMicros) / 1e6;
+    double commitSeconds = (doneMicros - receivedMicros) / 1e6;
+    double kbps = body.size() / 1024.0 / seconds;
+    if (csv) {
+        puts("bytes,seconds,kib_per_s,commit_s,prepare_s,flash_busy_s,erase_calls,write_calls,stalls,socket_reads,sink_calls,slots,slot_size,heap_peak,ok");
+        printf("%zu,%.3f,%.1f,%.3f,%.3f,%.3f,%u,%u,%u,%u,%u,%zu,%zu,%zu,%d\n", body.size(), seconds, kbps, commitSeconds, prepareMicros / 1e6,
+               hostFlashStats.busyMicros / 1e6, hostFlashStats.eraseCalls.load(), hostFlashStats.writeCalls.load(), hostFlashStats.stalls.load(),
+               reads, sinkCalls.load(), slots, slotSize, heapPeak, contentOk);
+    } else {
+        printf("image           %zu bytes to %s\n", body.size(), target->label);
+        if (prepare)
+            printf("prepare         %.3f s\n", prepareMicros / 1e6);
+        printf("update          %.3f s, %.1f KiB/s\n", seconds, kbps);
+        printf("time to commit  %.3f s after the last byte\n", commitSeconds);
+        printf("flash           busy %.3f s, %u erase calls (%llu KiB), %u write calls, %u stalls\n", hostFlashStats.busyMicros / 1e6,
+               hostFlashStats.eraseCalls.load(), (unsigned long long)hostFlashStats.erasedBytes / 1024, hostFlashStats.writeCalls.load(), hostFlashStats.stalls.load());
+        printf("pipeline        %u socket reads, %u sink calls\n", reads, sinkCalls.load());
+        printf("heap peak       %zu bytes\n", heapPeak);
+        printf("result          %s\n", contentOk ? "ok" : (committed ? "content mismatch" : writer.errorString()));
+    }
+    return contentOk ? 0 : 1;
+}
@@ -0,0 +1,34 @@
+/**
+ * Host shim: the parts of Arduino.h used by the OTA pipeline
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#ifndef HOSTSHIM_ARDUINO_h
+#define HOSTSHIM_ARDUINO_h
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+
+#include "freertos/FreeRTOS.h"
+
+class EspClass {
+  public:
+    uint32_t getFreeHeap();
+    uint32_t getMaxAllocHeap();
+    uint32_t getFreePsram() { return 0; }
+};
+extern EspClass ESP;
+
+static inline bool psramFound() { return false; }
+
+void delay(uint32_t ms);
+unsigned long millis();
+unsigned long micros();
+
+#endif // HOSTSHIM_ARDUINO_h
@@ -0,0 +1,15 @@
+/**
+ * Host shim: the Update commands used by OtaPartitionWriter
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#ifndef HOSTSHIM_UPDATE_h
+#define HOSTSHIM_UPDATE_h
+
+#define U_FLASH 0
+#define U_SPIFFS 100
+
+#endif // HOSTSHIM_UPDATE_h
@@ -0,0 +1,24 @@
+/**
+ * Host shim: esp_err_t
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#ifndef HOSTSHIM_ESP_ERR_h
+#define HOSTSHIM_ESP_ERR_h
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_SIZE 0x104
+#define ESP_ERR_NOT_FOUND 0x105
+#define ESP_ERR_OTA_VALIDATE_FAILED 0x1503
+
+const char *esp_err_to_name(esp_err_t code);
+
+#endif // HOSTSHIM_ESP_ERR_h
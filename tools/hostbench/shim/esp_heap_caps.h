@@ -0,0 +1,23 @@
+/**
+ * Host shim: heap_caps_* on top of malloc
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#ifndef HOSTSHIM_ESP_HEAP_CAPS_h
+#define HOSTSHIM_ESP_HEAP_CAPS_h
+
+#include <cstdint>
+#include <cstdlib>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+static inline void *heap_caps_malloc(size_t size, uint32_t caps) { return (caps & MALLOC_CAP_SPIRAM) ? NULL : malloc(size); }
+static inline void heap_caps_free(void *ptr) { free(ptr); }
+
+#endif // HOSTSHIM_ESP_HEAP_CAPS_h
@@ -0,0 +1,35 @@
+/**
+ * Host shim: app image verification
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#ifndef HOSTSHIM_ESP_IMAGE_FORMAT_h
+#define HOSTSHIM_ESP_IMAGE_FORMAT_h
+
+#include "esp_err.h"
+
+#include <cstdint>
+
+#define ESP_IMAGE_HEADER_MAGIC 0xE9
+
+typedef enum {
+    ESP_IMAGE_VERIFY,
+    ESP_IMAGE_VERIFY_SILENT,
+} esp_image_load_mode_t;
+
+typedef struct {
+    uint32_t offset;
+    uint32_t size;
+} esp_partition_pos_t;
+
+typedef struct {
+    uint32_t start_addr;
+    uint32_t image_len;
+} esp_image_metadata_t;
+
+esp_err_t esp_image_verify(esp_image_load_mode_t mode, const esp_partition_pos_t *part, esp_image_metadata_t *data);
+
+#endif // HOSTSHIM_ESP_IMAGE_FORMAT_h
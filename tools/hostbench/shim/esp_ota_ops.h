@@ -0,0 +1,17 @@
+/**
+ * Host shim: the OTA partition selection
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#ifndef HOSTSHIM_ESP_OTA_OPS_h
+#define HOSTSHIM_ESP_OTA_OPS_h
+
+#include "esp_partition.h"
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start);
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition);
+
+#endif // HOSTSHIM_ESP_OTA_OPS_h
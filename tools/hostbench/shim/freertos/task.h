@@ -0,0 +1,9 @@
+/**
+ * Host shim: see FreeRTOS.h
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#include "FreeRTOS.h"
@@ -0,0 +1,367 @@
+/**
+ * Host shim: FreeRTOS, partitions, heap and time of the simulated device
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#include "hostShim.h"
+
+#include "Arduino.h"
+#include "esp_err.h"
+#include "esp_image_format.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <malloc.h>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+HostFlashModel hostFlashModel;
+HostFlashStats hostFlashStats;
+double hostTimeScale = 1;
+size_t hostHeapSize = 180 * 1024;
+EspClass ESP;
+
+/*
+ * Heap accounting, every allocation of the process is counted
+ */
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+extern "C" void __libc_free(void *ptr);
+
+static std::atomic<int64_t> heapUsed{0};
+static std::atomic<int64_t> heapPeak{0};
+static std::atomic<int64_t> heapBase{0};
+
+static void heapAdd(int64_t bytes) {
+    int64_t now = heapUsed += bytes;
+    int64_t peak = heapPeak.load();
+    while (now > peak && !heapPeak.compare_exchange_weak(peak, now)) {
+    }
+}
+
+extern "C" void *malloc(size_t size) {
+    void *ptr = __libc_malloc(size);
+    if (ptr)
+        heapAdd(malloc_usable_size(ptr));
+    return ptr;
+}
+
+extern "C" void *calloc(size_t count, size_t size) {
+    void *ptr = __libc_calloc(count, size);
+    if (ptr)
+        heapAdd(malloc_usable_size(ptr));
+    return ptr;
+}
+
+extern "C" void *realloc(void *ptr, size_t size) {
+    int64_t before = ptr ? malloc_usable_size(ptr) : 0;
+    void *result = __libc_realloc(ptr, size);
+    if (result)
+        heapAdd((int64_t)malloc_usable_size(result) - before);
+    else if (!size)
+        heapAdd(-before);
+    return result;
+}
+
+extern "C" void free(void *ptr) {
+    if (ptr)
+        heapAdd(-(int64_t)malloc_usable_size(ptr));
+    __libc_free(ptr);
+}
+
+void hostHeapBaseline() {
+    heapBase = heapUsed.load();
+    heapPeak = heapUsed.load();
+}
+
+size_t hostHeapPeak() {
+    return heapPeak - heapBase;
+}
+
+uint32_t EspClass::getFreeHeap() {
+    int64_t used = heapUsed - heapBase;
+    return used < (int64_t)hostHeapSize ? hostHeapSize - used : 0;
+}
+
+uint32_t EspClass::getMaxAllocHeap() {
+    return getFreeHeap();
+}
+
+/*
+ * Simulated time
+ */
+static const auto startTime = std::chrono::steady_clock::now();
+
+void hostSleepMicros(double micros) {
+    if (micros > 0)
+        std::this_thread::sleep_for(std::chrono::duration<double, std::micro>(micros / hostTimeScale));
+}
+
+unsigned long micros() {
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - startTime;
+    return elapsed.count() * hostTimeScale;
+}
+
+unsigned long millis() {
+    return micros() / 1000;
+}
+
+void delay(uint32_t ms) {
+    hostSleepMicros(ms * 1000.0);
+}
+
+const char *esp_err_to_name(esp_err_t code) {
+    switch (code) {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_SIZE:
+        return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_OTA_VALIDATE_FAILED:
+        return "ESP_ERR_OTA_VALIDATE_FAILED";
+    default:
+        return "ESP_FAIL";
+    }
+}
+
+/*
+ * FreeRTOS on std::thread, ticks are simulated milliseconds
+ */
+struct HostQueue {
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> items;
+    size_t length;
+    size_t itemSize;
+};
+
+struct HostTask {};
+static HostTask hostTask;
+
+static bool waitFor(HostQueue *queue, std::unique_lock<std::mutex> &lock, TickType_t wait, std::function<bool()> ready) {
+    if (wait == portMAX_DELAY) {
+        queue->changed.wait(lock, ready);
+        return true;
+    }
+    return queue->changed.wait_for(lock, std::chrono::duration<double, std::milli>(wait / hostTimeScale), ready);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t code, const char *name, uint32_t stack, void *param, UBaseType_t priority, TaskHandle_t *handle, BaseType_t core) {
+    std::thread(code, param).detach();
+    if (handle)
+        *handle = &hostTask;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    // tasks only delete themselves as their last statement, the thread just returns
+}
+
+void vTaskDelay(TickType_t ticks) {
+    hostSleepMicros(ticks * 1000.0);
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task) {
+    return 1;
+}
+
+BaseType_t xPortGetCoreID() {
+    return 0;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    HostQueue *queue = new HostQueue;
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait) {
+    std::unique_lock<std::mutex> lock(queue->lock);
+    if (!waitFor(queue, lock, wait, [queue]() { return queue->items.size() < queue->length; }))
+        return pdFALSE;
+    const uint8_t *bytes = (const uint8_t *)item;
+    queue->items.emplace_back(bytes, bytes + (item ? queue->itemSize : 0));
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait) {
+    std::unique_lock<std::mutex> lock(queue->lock);
+    if (!waitFor(queue, lock, wait, [queue]() { return !queue->items.empty(); }))
+        return pdFALSE;
+    if (item)
+        memcpy(item, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> lock(queue->lock);
+    return queue->items.size();
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return xQueueCreate(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    SemaphoreHandle_t mutex = xQueueCreate(1, 0);
+    xSemaphoreGive(mutex);
+    return mutex;
+}
+
+/*
+ * Simulated flash with the partition layout of examples/partitions.csv
+ */
+struct HostPartition {
+    esp_partition_t info;
+    std::vector<uint8_t> data;
+    size_t imageEnd;
+};
+
+static HostPartition partitions[] = {
+    {{ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_0, 0x10000, 1536 * 1024, "app0"}, {}, 0},
+    {{ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_1, 0x190000, 1536 * 1024, "app1"}, {}, 0},
+    {{ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, 0x310000, 704 * 1024, "spiffs"}, {}, 0},
+};
+static const esp_partition_t *bootPartition = &partitions[0].info;
+
+// the SPI flash serves one operation at a time
+static std::mutex flashLock;
+static std::mt19937 flashRandom(1);
+
+static HostPartition *lookup(const esp_partition_t *partition) {
+    for (HostPartition &p : partitions) {
+        if (&p.info != partition)
+            continue;
+        if (p.data.empty())
+            p.data.assign(p.info.size, 0x00); // old content, a missing erase shows up as a dirty write
+        return &p;
+    }
+    return NULL;
+}
+
+void hostFlashInit() {
+    for (HostPartition &p : partitions)
+        lookup(&p.info);
+}
+
+static void flashBusy(double micros) {
+    hostSleepMicros(micros);
+    hostFlashStats.busyMicros += micros;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label) {
+    for (HostPartition &p : partitions)
+        if (p.info.type == type && p.info.subtype == subtype)
+            return &p.info;
+    return NULL;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size) {
+    std::lock_guard<std::mutex> lock(flashLock);
+    HostPartition *p = lookup(partition);
+    if (!p || offset % 4096 || size % 4096 || offset + size > partition->size)
+        return ESP_ERR_INVALID_ARG;
+
+    // the driver uses block erases for aligned 64 KB ranges
+    double cost = hostFlashModel.callOverheadUs;
+    for (size_t pos = offset; pos < offset + size;) {
+        bool block = (partition->address + pos) % 65536 == 0 && offset + size - pos >= 65536;
+        cost += (block ? hostFlashModel.eraseBlockMs : hostFlashModel.eraseSectorMs) * 1000;
+        pos += block ? 65536 : 4096;
+    }
+    memset(p->data.data() + offset, 0xFF, size);
+    hostFlashStats.eraseCalls++;
+    hostFlashStats.erasedBytes += size;
+    flashBusy(cost);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t offset, const void *src, size_t size) {
+    std::lock_guard<std::mutex> lock(flashLock);
+    HostPartition *p = lookup(partition);
+    if (!p || offset + size > partition->size)
+        return ESP_ERR_INVALID_ARG;
+
+    const uint8_t *bytes = (const uint8_t *)src;
+    for (size_t i = 0; i < size; i++) {
+        if ((p->data[offset + i] & bytes[i]) != bytes[i]) {
+            hostFlashStats.dirtyWrites++;
+            break;
+        }
+    }
+    for (size_t i = 0; i < size; i++)
+        p->data[offset + i] &= bytes[i];
+    if (offset + size > p->imageEnd)
+        p->imageEnd = offset + size;
+
+    size_t pages = size ? (offset + size - 1) / 256 - offset / 256 + 1 : 0;
+    double cost = hostFlashModel.callOverheadUs + pages * hostFlashModel.pageProgramMs * 1000;
+    if (hostFlashModel.stallRate > 0 && std::uniform_real_distribution<double>(0, 1)(flashRandom) < hostFlashModel.stallRate) {
+        cost += hostFlashModel.stallMs * 1000;
+        hostFlashStats.stalls++;
+    }
+    hostFlashStats.writeCalls++;
+    hostFlashStats.writtenBytes += size;
+    flashBusy(cost);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t offset, void *dst, size_t size) {
+    std::lock_guard<std::mutex> lock(flashLock);
+    HostPartition *p = lookup(partition);
+    if (!p || offset + size > partition->size)
+        return ESP_ERR_INVALID_ARG;
+    memcpy(dst, p->data.data() + offset, size);
+    return ESP_OK;
+}
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start) {
+    return bootPartition == &partitions[0].info ? &partitions[1].info : &partitions[0].info;
+}
+
+esp_err_t esp_image_verify(esp_image_load_mode_t mode, const esp_partition_pos_t *part, esp_image_metadata_t *data) {
+    for (HostPartition &p : partitions) {
+        if (p.info.address != part->offset)
+            continue;
+        lookup(&p.info);
+        // reading back and hashing the image
+        flashBusy(p.imageEnd / hostFlashModel.verifyMBps);
+        if (!p.imageEnd || p.data[0] != ESP_IMAGE_HEADER_MAGIC)
+            return ESP_ERR_OTA_VALIDATE_FAILED;
+        data->start_addr = part->offset;
+        data->image_len = p.imageEnd;
+        return ESP_OK;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition) {
+    esp_partition_pos_t pos = {partition->address, partition->size};
+    esp_image_metadata_t data;
+    esp_err_t err = esp_image_verify(ESP_IMAGE_VERIFY, &pos, &data);
+    if (err == ESP_OK)
+        bootPartition = partition;
+    return err;
+}
@@ -0,0 +1,55 @@
+/**
+ * Host shim: simulation models and counters shared with the benchmark
+ * (c) 2022-2024 Martin Verges
+ *
+ * Licensed under CC BY-NC-SA 4.0
+ * (Attribution-NonCommercial-ShareAlike 4.0 International)
+ **/
+
+#ifndef HOSTSHIM_h
+#define HOSTSHIM_h
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Timing of the simulated SPI flash, defaults are close to a typical ESP32 module
+struct HostFlashModel {
+    double eraseSectorMs = 30;  // one 4 KB sector
+    double eraseBlockMs = 150;  // one aligned 64 KB block
+    double pageProgramMs = 0.4; // each 256 byte page touched by a write
+    double callOverheadUs = 30; // cache disable, SPI setup per call
+    double verifyMBps = 20;     // read back of an app image by esp_image_verify()
+    double stallRate = 0;       // probability of a stall per write call
+    double stallMs = 0;         // duration of a stall
+};
+
+// What happened on the simulated flash
+struct HostFlashStats {
+    std::atomic<uint32_t> eraseCalls{0};
+    std::atomic<uint64_t> erasedBytes{0};
+    std::atomic<uint32_t> writeCalls{0};
+    std::atomic<uint64_t> writtenBytes{0};
+    std::atomic<uint32_t> stalls{0};
+    std::atomic<uint32_t> dirtyWrites{0}; // writes onto bytes that were not erased
+    std::atomic<uint64_t> busyMicros{0};
+};
+
+extern HostFlashModel hostFlashModel;
+extern HostFlashStats hostFlashStats;
+
+// Simulated time runs this many times faster than the wall clock
+extern double hostTimeScale;
+
+// Heap of the simulated device, ESP.getFreeHeap() is this minus the allocations since hostHeapBaseline()
+extern size_t hostHeapSize;
+void hostHeapBaseline();
+size_t hostHeapPeak();
+
+// Allocate the partitions, call before hostHeapBaseline()
+void hostFlashInit();
+
+// Sleep for simulated microseconds
+void hostSleepMicros(double micros);
+
+#endif // HOSTSHIM_h
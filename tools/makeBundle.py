@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""
+Pack firmware.bin and littlefs.bin into a single update bundle
+
+    python3 tools/makeBundle.py -o update.bundle --app firmware.bin --fs littlefs.bin
+
+Name the bundle in current-version.json ("bundle": "update.bundle"). The device
+streams it once, verifies the SHA-256 of every artifact and only switches the
+boot partition when all of them are valid. The layout is described in otaBundle.h.
+
+With --sign key.pem the header and the artifact table are signed with openssl,
+put the printed signature into the "signature" object of the manifest.
+"""
+
+import argparse
+import base64
+import hashlib
+import os
+import struct
+import subprocess
+
+MAGIC = b"OTABNDL1"
+VERSION = 1
+TYPE_APP = 0
+TYPE_FILESYSTEM = 1
+ALIGN = 16
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("-o", "--output", required=True, help="bundle file to write")
+    parser.add_argument("--app", help="firmware image (firmware.bin)")
+    parser.add_argument("--fs", help="filesystem image (littlefs.bin or spiffs.bin)")
+    parser.add_argument("--sign", metavar="KEY", help="private key (PEM) to sign the bundle header")
+    args = parser.parse_args()
+
+    # the filesystem has no second slot, it must follow the verified app
+    artifacts = []
+    if args.app:
+        artifacts.append((TYPE_APP, args.app))
+    if args.fs:
+        artifacts.append((TYPE_FILESYSTEM, args.fs))
+    if not artifacts:
+        parser.error("at least one of --app and --fs is required")
+
+    entries = b""
+    payload = b""
+    for kind, path in artifacts:
+        with open(path, "rb") as f:
+            data = f.read()
+        payload += b"\0" * (-len(payload) % ALIGN)
+        name = os.path.basename(path).encode()[:20]
+        entries += struct.pack("<B3xII32s20s", kind, len(payload), len(data), hashlib.sha256(data).digest(), name)
+        payload += data
+
+    header = struct.pack("<8sHHI", MAGIC, VERSION, len(artifacts), 0)
+    with open(args.output, "wb") as f:
+        f.write(header + entries + payload)
+    print("%s: %d artifacts, %d bytes" % (args.output, len(artifacts), len(header) + len(entries) + len(payload)))
+
+    if args.sign:
+        signature = subprocess.run(["openssl", "dgst", "-sha256", "-sign", args.sign], input=header + entries,
+                                   stdout=subprocess.PIPE, check=True).stdout
+        print("signature: %s" % base64.b64encode(signature).decode())
+
+
+if __name__ == "__main__":
+    main()
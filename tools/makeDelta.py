@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+"""
+Create a delta patch the device can apply while downloading
+
+    python3 tools/makeDelta.py -o firmware-from-v1.0.0.patch.gz old/firmware.bin new/firmware.bin
+    python3 tools/makeDelta.py -o firmware-from-v1.0.0.patch.gz --patch bsdiff.patch
+
+The first form runs bsdiff (https://github.com/mendsley/bsdiff, in the PATH or
+given with --bsdiff), the second converts a patch it created before. bsdiff
+compresses everything after the header with bzip2, which the device can not
+decode. The patch is written uncompressed instead and compressed with gzip,
+the device inflates it on the fly before applying it.
+
+Put the file into the "delta" object of current-version.json, keyed by the MD5
+of the old firmware (printed below, and shown as sketch.md5 in /api/ota/esp).
+"""
+
+import argparse
+import bz2
+import gzip
+import hashlib
+import os
+import subprocess
+import sys
+import tempfile
+
+MAGIC = b"ENDSLEY/BSDIFF43"
+HEADER = 24
+
+
+def run_bsdiff(bsdiff, old, new):
+    with tempfile.TemporaryDirectory() as tmp:
+        patch = os.path.join(tmp, "bsdiff.patch")
+        subprocess.run([bsdiff, old, new, patch], check=True)
+        with open(patch, "rb") as f:
+            return f.read()
+
+
+def offtin(buf):
+    value = int.from_bytes(buf[:7], "little") | (buf[7] & 0x7F) << 56
+    return -value if buf[7] & 0x80 else value
+
+
+def check_stream(stream, new_size):
+    """Walk the control blocks like the device does"""
+    pos = 0
+    produced = 0
+    while produced < new_size:
+        if pos + 24 > len(stream):
+            raise SystemExit("truncated patch")
+        diff, extra = offtin(stream[pos:pos + 8]), offtin(stream[pos + 8:pos + 16])
+        if diff < 0 or extra < 0 or produced + diff + extra > new_size:
+            raise SystemExit("corrupt patch control block")
+        pos += 24 + diff + extra
+        produced += diff + extra
+    if pos != len(stream):
+        raise SystemExit("trailing data after the patch")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("-o", "--output", required=True, help="patch file to write, gzip compressed")
+    parser.add_argument("--patch", help="convert this bsdiff patch instead of running bsdiff")
+    parser.add_argument("--bsdiff", default="bsdiff", help="bsdiff executable")
+    parser.add_argument("old", nargs="?", help="firmware.bin running on the devices")
+    parser.add_argument("new", nargs="?", help="firmware.bin to install")
+    args = parser.parse_args()
+
+    if args.patch:
+        with open(args.patch, "rb") as f:
+            patch = f.read()
+    elif args.old and args.new:
+        patch = run_bsdiff(args.bsdiff, args.old, args.new)
+    else:
+        parser.error("either --patch or the old and the new image are required")
+
+    if patch[:16] != MAGIC or len(patch) < HEADER:
+        raise SystemExit("not an ENDSLEY/BSDIFF43 patch")
+    new_size = offtin(patch[16:HEADER])
+    stream = patch[HEADER:]
+    if stream[:3] == b"BZh":
+        stream = bz2.decompress(stream)
+    check_stream(stream, new_size)
+
+    with open(args.output, "wb") as f:
+        f.write(gzip.compress(patch[:HEADER] + stream, 9))
+
+    size = os.path.getsize(args.output)
+    print(f"{args.output}: {size} bytes for a {new_size} byte image")
+    if args.old:
+        with open(args.old, "rb") as f:
+            print(f"delta key (MD5 of the old image): {hashlib.md5(f.read()).hexdigest()}")
+    if args.new and size > os.path.getsize(args.new) * 0.9:
+        print("warning: the patch is hardly smaller than the image, a delta does not pay off", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,54 @@
+#!/usr/bin/env python3
+"""
+Write the binary summary of a manifest for devices polling current-version.bin
+
+    python3 tools/makeManifest.py current-version.json
+
+Creates current-version.bin next to the manifest. Devices with
+setBinaryManifest(true) load the 64 bytes on each check and only fetch and parse
+current-version.json when the CRC32 it carries changed. Run it again after every
+change of the manifest. The layout is described in otaWebUpdater.h.
+"""
+
+import argparse
+import json
+import os
+import struct
+import zlib
+
+MAGIC = b"OTAM"
+VERSION = 1
+FIELD = 24
+
+
+def text(value, name):
+    data = str(value).encode("utf-8")
+    if len(data) > FIELD:
+        raise SystemExit(f"{name} is longer than {FIELD} bytes: {value}")
+    return data.ljust(FIELD, b"\0")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("manifest", help="current-version.json")
+    parser.add_argument("-o", "--output", help="file to write, defaults to current-version.bin next to the manifest")
+    args = parser.parse_args()
+
+    with open(args.manifest, "rb") as f:
+        raw = f.read()
+    manifest = json.loads(raw)
+    if "date" not in manifest or "revision" not in manifest:
+        parser.error("the manifest needs a date and a revision")
+
+    summary = MAGIC + struct.pack("<B3xII", VERSION, zlib.crc32(raw), 0)
+    summary += text(manifest["date"], "date") + text(manifest["revision"], "revision")
+    assert len(summary) == 64
+
+    output = args.output or os.path.join(os.path.dirname(args.manifest), "current-version.bin")
+    with open(output, "wb") as f:
+        f.write(summary)
+    print(f"{output}: {manifest['revision']} ({manifest['date']}), crc32 {zlib.crc32(raw):08x}")
+
+
+if __name__ == "__main__":
+    main()